@@ -10,13 +10,16 @@ struct Aiger
   unsigned max_index;
   unsigned num_inputs;
   unsigned num_ands;
+  unsigned num_outputs;
   unsigned *inputs;
+  unsigned *outputs;
   Gate **gates;
+  Gates and_inputs;
 };
 
 static Aiger *
-new_aiger (Circuit * c,
-	   Reader * r, Symbols * t, unsigned M, unsigned I, unsigned A)
+new_aiger (Circuit * c, Reader * r, Symbols * t,
+	   unsigned M, unsigned I, unsigned O, unsigned A)
 {
   assert (M >= I + A);
   Aiger *res;
@@ -27,7 +30,9 @@ new_aiger (Circuit * c,
   res->max_index = M;
   res->num_inputs = I;
   res->num_ands = A;
+  res->num_outputs = O;
   ALLOC (res->inputs, I);
+  ALLOC (res->outputs, O);
   for (unsigned i = 0; i < I; i++)
     res->inputs[i] = UINT_MAX;
   ALLOC (res->gates, M + 1);
@@ -37,11 +42,22 @@ new_aiger (Circuit * c,
 static void
 delete_aiger (Aiger * aiger)
 {
+  RELEASE (aiger->and_inputs);
   DEALLOC (aiger->gates, aiger->max_index + 1);
+  DEALLOC (aiger->outputs, aiger->num_outputs);
   DEALLOC (aiger->inputs, aiger->num_inputs);
   DELETE (aiger);
 }
 
+static Gate *
+new_aiger_and_gate (Aiger * aiger, Gate * g0, Gate * g1)
+{
+  CLEAR (aiger->and_inputs);
+  PUSH (aiger->and_inputs, g0);
+  PUSH (aiger->and_inputs, g1);
+  return new_hashed_gate (aiger->circuit, AND_OPERATOR, &aiger->and_inputs);
+}
+
 static int
 is_valid_aiger_literal (Aiger * aiger, unsigned lit)
 {
@@ -135,6 +151,25 @@ setup_aiger_symbol_table (Aiger * aiger)
     }
 }
 
+// The first output becomes the output of the circuit.  With more than one
+// output all of them are also collected in the 'outputs' stack of the
+// circuit, from which the caller selects the output to work on.
+
+static void
+connect_aiger_outputs (Aiger * aiger)
+{
+  Circuit *c = aiger->circuit;
+  for (unsigned i = 0; i < aiger->num_outputs; i++)
+    {
+      Gate *g = aiger_literal_to_gate (aiger, aiger->outputs[i]);
+      assert (g);
+      if (!i)
+	connect_output (c, g);
+      if (aiger->num_outputs > 1)
+	PUSH (c->outputs, g);
+    }
+}
+
 static void
 parse_ascii_aiger (Aiger * aiger)
 {
@@ -153,9 +188,14 @@ parse_ascii_aiger (Aiger * aiger)
       aiger->gates[input / 2] = new_input_gate (aiger->circuit);
     }
   setup_aiger_symbol_table (aiger);
-  unsigned output = parse_aiger_ascii_literal (aiger, 0, &ch);
-  Coo output_ch = ch;
-  LOG ("AIGER output literal %u", output);
+  Coo *output_chs;
+  ALLOC (output_chs, aiger->num_outputs);
+  for (unsigned i = 0; i < aiger->num_outputs; i++)
+    {
+      unsigned output = parse_aiger_ascii_literal (aiger, 0, output_chs + i);
+      LOG ("AIGER output %u literal %u", i, output);
+      aiger->outputs[i] = output;
+    }
   for (unsigned i = 0; i < aiger->num_ands; i++)
     {
       unsigned lhs = parse_aiger_ascii_literal (aiger, 1, &ch);
@@ -178,15 +218,14 @@ parse_ascii_aiger (Aiger * aiger)
       if (!g1)
 	parse_error (r, ch, "AND gate argument %u undefined", rhs1);
       LOG ("parsed AIGER AND gate %u = %u & %u", lhs, rhs0, rhs1);
-      Gate *and = new_and_gate (aiger->circuit);
-      connect_gates (g0, and);
-      connect_gates (g1, and);
-      aiger->gates[lhs / 2] = and;
+      aiger->gates[lhs / 2] = new_aiger_and_gate (aiger, g0, g1);
     }
-  Gate *output_gate = aiger_literal_to_gate (aiger, output);
-  if (!output_gate)
-    parse_error (r, output_ch, "output literal %u undefined", output);
-  connect_output (aiger->circuit, output_gate);
+  for (unsigned i = 0; i < aiger->num_outputs; i++)
+    if (!aiger_literal_to_gate (aiger, aiger->outputs[i]))
+      parse_error (r, output_chs[i], "output literal %u undefined",
+		   aiger->outputs[i]);
+  DEALLOC (output_chs, aiger->num_outputs);
+  connect_aiger_outputs (aiger);
 }
 
 static Coo
@@ -230,9 +269,13 @@ parse_binary_aiger (Aiger * aiger)
     }
   setup_aiger_symbol_table (aiger);
   Coo ch;
-  unsigned output = parse_aiger_ascii_literal (aiger, 0, &ch);
-  assert (is_valid_aiger_literal (aiger, output));
-  LOG ("AIGER output literal %u", output);
+  for (unsigned i = 0; i < aiger->num_outputs; i++)
+    {
+      unsigned output = parse_aiger_ascii_literal (aiger, 0, &ch);
+      assert (is_valid_aiger_literal (aiger, output));
+      LOG ("AIGER output %u literal %u", i, output);
+      aiger->outputs[i] = output;
+    }
   r->binary = 1;
   for (unsigned i = 0; i < aiger->num_ands; i++)
     {
@@ -249,14 +292,9 @@ parse_binary_aiger (Aiger * aiger)
       unsigned rhs1 = rhs0 - delta1;
       Gate *g1 = aiger_literal_to_gate (aiger, rhs1);
       assert (g1);
-      Gate *and = new_and_gate (aiger->circuit);
-      connect_gates (g0, and);
-      connect_gates (g1, and);
-      aiger->gates[lhs / 2] = and;
+      aiger->gates[lhs / 2] = new_aiger_and_gate (aiger, g0, g1);
     }
-  Gate *output_gate = aiger_literal_to_gate (aiger, output);
-  assert (output_gate);
-  connect_output (aiger->circuit, output_gate);
+  connect_aiger_outputs (aiger);
 }
 
 Circuit *
@@ -289,14 +327,14 @@ parse_aiger (Reader * r, Symbols * t)
     parse_error (r, ch, "can not handle latches");
   if (UINT_MAX / 2 < M)
     parse_error (r, ch, "maximum variable index %u too large", M);
-  if (O != 1)
-    parse_error (r, ch, "expected exactly one output but got %u", O);
+  if (!O)
+    parse_error (r, ch, "expected at least one output");
   if (I > M || A > M || (binary && M - I != A) || (!binary && M - I < A))
     parse_error (r, ch,
 		 "invalid header M I L O A = %u %u %u %u %u", M, I, L, O, A);
   msg (1, "parsed M I L O A header %u %u %u %u %u", M, I, L, O, A);
   Circuit *res = new_circuit ();
-  Aiger *aiger = new_aiger (res, r, t, M, I, A);
+  Aiger *aiger = new_aiger (res, r, t, M, I, O, A);
   if (binary)
     parse_binary_aiger (aiger);
   else
@@ -58,6 +58,30 @@ count () {
   then
     error \
 "counting mismatch between SAT and BDD engine: '$last' and '$lastline'"
+  fi
+  for order in 1 2 3
+  do
+    execute $dualiza $1 -b --bddorder=$order
+    if [ ! "$last" = "$lastline" ]
+    then
+      error \
+"counting mismatch with BDD order '$order': '$last' and '$lastline'"
+    fi
+  done
+  for lut in 3 6
+  do
+    execute $dualiza $1 --lut=$lut
+    if [ ! "$last" = "$lastline" ]
+    then
+      error \
+"counting mismatch with '--lut=$lut': '$last' and '$lastline'"
+    fi
+  done
+  execute $dualiza $1 --xor
+  if [ ! "$last" = "$lastline" ]
+  then
+    error \
+"counting mismatch with '--xor': '$last' and '$lastline'"
   fi
   case `basename $1|sed -e 's,.a[ai]g$,,'` in
     false)
@@ -92,9 +116,75 @@ count () {
   done
 }
 
+outputs () {
+  execute $dualiza $1
+  all="$tmp.all"
+  cp $tmp $all
+  for args in -b --threads=2 --no-flatten --fraig --primal
+  do
+    execute $dualiza $args $1
+    if [ ! "`cat $all`" = "`cat $tmp`" ]
+    then
+      error "multiple outputs mismatch with '$args' configuration"
+    fi
+  done
+  aag="$tmp.aag"
+  case $1 in
+    *.aag) cp $1 $aag;;
+    *) which aigtoaig >/dev/null 2>/dev/null || return
+       filter aigtoaig $1 $aag || return;;
+  esac
+  n="`head -1 $aag|awk '{print $5}'`"
+  i=0
+  while [ $i -lt $n ]
+  do
+    single="$tmp.single.aag"
+    awk -v i=$i '
+NR == 1 { inputs = $3; latches = $4; outputs = $5; $5 = 1; print; next }
+$0 == "c" { comments = 1 }
+comments { print; next }
+NR > 1 + inputs + latches && NR <= 1 + inputs + latches + outputs {
+  if (NR == 2 + inputs + latches + i) { output = $1; print }
+  next
+}
+/^o[0-9]/ { next }
+{ print }
+END { exit (output < 2) }' $aag > $single
+    constant=$?
+    expected="`sed -n -e "/^c output $i\$/,/^c output/p" $all | \
+grep -v '^c output' | tail -1`"
+    execute $dualiza $single
+    if [ ! "$expected" = "$lastline" ]
+    then
+      error \
+"counting mismatch of output $i with single output: '$expected' and '$lastline'"
+    fi
+    if [ $constant = 0 -a "$sharpsat" -a "$aigtocnf" ]
+    then
+      cnf="$tmp.cnf"
+      if filter $aigtocnf --no-pg $single $cnf
+      then
+	filter "$sharpsat" $cnf
+	res="`sed -e '1,/# solutions/d' -e '/# END/,$d' $tmp`"
+	[ -t 1 ] || echo $res
+	if [ ! "$res" = "$expected" ]
+	then
+	  error \
+"counting mismatch of output $i with sharpSAT: '$expected' and '$res'"
+	fi
+      fi
+    fi
+    i=`expr $i + 1`
+  done
+}
+
 for i in $dir/*.a[ai]g
 do
   run $i
+  if [ "`head -1 $i|awk '{print $5}'`" -gt 1 ]
+  then
+    outputs $i
+  fi
 done
 
 erase
@@ -16,6 +16,23 @@ static BDD **bdd_table, *false_bdd_node, *true_bdd_node;
 static unsigned bdd_size, bdd_count;
 static uint64_t bdd_nodes;
 
+// Optional static variable order mapping external variables to internal
+// variables and back.  Without order the internal variable is the
+// external variable plus one.  Larger internal variables are closer to
+// the root.
+
+static unsigned *bdd_import_table;
+static int *bdd_export_table;
+static unsigned bdd_order_size;
+
+// Optional limit on the number of live BDD nodes.  If it is reached, no
+// new nodes are allocated anymore and 'false' is returned instead.  The
+// results of all following operations are meaningless and the user has
+// to check 'bdd_node_limit_reached' and give up on BDDs.
+
+static unsigned bdd_node_limit;
+static int bdd_node_limit_hit;
+
 /*------------------------------------------------------------------------*/
 
 static BDD *
@@ -40,6 +57,8 @@ alloc_bdd (unsigned var, BDD * then, BDD * other, unsigned hash)
   res->then = then ? inc (then) : 0;
   res->other = other ? inc (other) : 0;
   bdd_count++;
+  if (bdd_count > stats.bdd.peak)
+    stats.bdd.peak = bdd_count;
 #ifndef NLOG
   if (then)
     {
@@ -60,6 +79,7 @@ dealloc_bdd (BDD * b)
   LOG ("deallocating BDD %" PRIu64 "", b->idx);
   assert (bdd_count);
   bdd_count--;
+  stats.bdd.freed++;
   DELETE (b);
 }
 
@@ -68,12 +88,15 @@ find_bdd (unsigned var, BDD * then, BDD * other, unsigned hash)
 {
   stats.bdd.node.lookups++;
   unsigned h = hash & (bdd_size - 1);
+  unsigned probes = 0;
   BDD **res, *b;
   for (res = bdd_table + h;
        (b = *res) &&
        (b->var != var || b->then != then || b->other != other);
        res = &b->next)
-    stats.bdd.node.collisions++;
+    probes++;
+  stats.bdd.node.collisions += probes;
+  stats.bdd.probes[MIN (probes, BDD_HISTOGRAM - 1)]++;
   return res;
 }
 
@@ -133,8 +156,14 @@ enlarge_bdd ()
   msg (2, "enlarging BDD table from %u to %u", bdd_size, new_bdd_size);
   BDD **new_bdd_table;
   ALLOC (new_bdd_table, new_bdd_size);
+  memset (stats.bdd.chains, 0, sizeof stats.bdd.chains);
+  stats.bdd.table = bdd_size;
   for (unsigned i = 0; i < bdd_size; i++)
     {
+      unsigned length = 0;
+      for (BDD * b = bdd_table[i]; b; b = b->next)
+	length++;
+      stats.bdd.chains[MIN (length, BDD_HISTOGRAM - 1)]++;
       for (BDD * b = bdd_table[i], *next; b; b = next)
 	{
 	  next = b->next;
@@ -159,10 +188,54 @@ new_bdd_node (unsigned var, BDD * then, BDD * other)
   BDD **p = find_bdd (var, then, other, hash), *res;
   if ((res = *p))
     return copy_bdd (res);
+  if (bdd_node_limit && bdd_count >= bdd_node_limit)
+    {
+      if (!bdd_node_limit_hit)
+	msg (1, "reached limit of %u live BDD nodes", bdd_node_limit);
+      bdd_node_limit_hit = 1;
+      return inc (false_bdd_node);
+    }
   *p = res = alloc_bdd (var, then, other, hash);
   return res;
 }
 
+void
+limit_number_of_bdd_nodes (unsigned limit)
+{
+  msg (1, "limiting number of live BDD nodes to %u", limit);
+  bdd_node_limit = limit;
+}
+
+int
+bdd_node_limit_reached ()
+{
+  return bdd_node_limit_hit;
+}
+
+/*------------------------------------------------------------------------*/
+
+static const char *bdd_op_names[NUM_BDD_OPS] = {
+  "not", "and", "xor", "or", "xnor", "ite", "project", "exists",
+};
+
+const char *
+bdd_op_name (BDDOp op)
+{
+  assert (op < NUM_BDD_OPS);
+  return bdd_op_names[op];
+}
+
+static BDD *
+count_cached (BDDOp op, BDD * res)
+{
+  assert (op < NUM_BDD_OPS);
+  if (res)
+    stats.bdd.ops[op].hits++;
+  else
+    stats.bdd.ops[op].misses++;
+  return res;
+}
+
 BDD *
 false_bdd ()
 {
@@ -192,14 +265,27 @@ reset_bdds ()
       next = b->next, dealloc_bdd (b);
   assert (!bdd_count);
   DEALLOC (bdd_table, bdd_size);
+  bdd_table = 0;
+  bdd_size = 0;
+  bdd_nodes = 0;
   false_bdd_node = 0;
   true_bdd_node = 0;
+  bdd_node_limit = 0;
+  bdd_node_limit_hit = 0;
+  if (bdd_order_size)
+    {
+      DEALLOC (bdd_import_table, bdd_order_size);
+      DEALLOC (bdd_export_table, bdd_order_size + 1);
+      bdd_order_size = 0;
+    }
 }
 
 static unsigned
 bdd_import_var (int evar)
 {
   assert (evar > 0);
+  if ((unsigned) evar < bdd_order_size)
+    return bdd_import_table[evar];
   return 1u + (unsigned) evar;
 }
 
@@ -208,9 +294,37 @@ bdd_export_var (unsigned ivar)
 {
   assert (1 < ivar);
   assert (ivar <= 1 + (unsigned) INT_MAX);
+  if (ivar < bdd_order_size + 1)
+    return bdd_export_table[ivar];
   return ((int) ivar) - 1;
 }
 
+void
+set_bdd_variable_order (IntStack * order)
+{
+  assert (false_bdd_node);
+  assert (true_bdd_node);
+  assert (bdd_count == 2);
+  assert (!bdd_order_size);
+  const unsigned n = COUNT (*order);
+  if (!n)
+    return;
+  bdd_order_size = n + 1;
+  ALLOC (bdd_import_table, bdd_order_size);
+  ALLOC (bdd_export_table, bdd_order_size + 1);
+  unsigned ivar = n + 1;
+  for (const int *p = order->start; p != order->top; p++, ivar--)
+    {
+      const int evar = *p;
+      assert (0 < evar), assert ((unsigned) evar <= n);
+      assert (!bdd_import_table[evar]);
+      LOG ("BDD variable %d mapped to level %u", evar, ivar - 1);
+      bdd_import_table[evar] = ivar;
+      bdd_export_table[ivar] = evar;
+    }
+  assert (ivar == 1);
+}
+
 BDD *
 new_bdd (int var)
 {
@@ -244,7 +358,7 @@ print_bdd_recursive (BDD * b, FILE * file)
   print_bdd_recursive (b->other, file);
   fprintf (file,
 	   "%" PRIu64 " %u %" PRIu64 " %" PRIu64 "\n",
-	   b->idx, b->var - 1, b->then->idx, b->other->idx);
+	   b->idx, bdd_export_var (b->var), b->then->idx, b->other->idx);
   b->mark = bdd_mark;
 }
 
@@ -268,6 +382,44 @@ print_bdd (BDD * b)
   print_bdd_to_file (b, stdout);
 }
 
+static void
+support_bdd_recursive (BDD * b, IntStack * vars)
+{
+  assert (b);
+  if (b->mark == bdd_mark)
+    return;
+  b->mark = bdd_mark;
+  if (b->idx <= 1)
+    return;
+  PUSH (*vars, (int) b->var);
+  support_bdd_recursive (b->then, vars);
+  support_bdd_recursive (b->other, vars);
+}
+
+static int
+cmp_internal_vars (const void *p, const void *q)
+{
+  return *(int *) p - *(int *) q;
+}
+
+// Pushes the (external) variables the BDD depends on, each only once.
+
+void
+support_bdd (BDD * b, IntStack * vars)
+{
+  const size_t start = COUNT (*vars);
+  inc_bdd_mark ();
+  support_bdd_recursive (b, vars);
+  int *p = vars->start + start, *q = p, *end = vars->top;
+  qsort (p, end - p, sizeof *p, cmp_internal_vars);
+  for (int *r = p; r != end; r++)
+    if (q == p || q[-1] != *r)
+      *q++ = *r;
+  vars->top = q;
+  for (int *r = p; r != q; r++)
+    *r = bdd_export_var ((unsigned) *r);
+}
+
 static void
 visualize_bdd_recursive (BDD * b, FILE * file, Name name)
 {
@@ -443,12 +595,10 @@ cache_unary (BDD * a, BDD * res)
 }
 
 static BDD *
-cached_unary (BDD * a)
+cached_unary (BDDOp op, BDD * a)
 {
-  if (!unary_count)
-    return 0;
-  Unary *l = *find_unary (a);
-  return l ? inc (l->res) : 0;
+  Unary *l = unary_count ? *find_unary (a) : 0;
+  return count_cached (op, l ? inc (l->res) : 0);
 }
 
 static void
@@ -486,7 +636,7 @@ not_bdd_recursive (BDD * a)
     return inc (true_bdd_node);
   if (a == true_bdd_node)
     return inc (false_bdd_node);
-  BDD *res = cached_unary (a);
+  BDD *res = cached_unary (NOT_BDD_OP, a);
   if (res)
     return res;
   BDD *then = not_bdd_recursive (a->then);
@@ -510,9 +660,23 @@ not_bdd (BDD * a)
 
 /*------------------------------------------------------------------------*/
 
+// Binary cache lines are tagged with the operator, since for instance
+// 'and_exists_bdd' needs the AND and the OR cache at the same time.  The
+// order matches 'AND_BDD_OP' to 'XNOR_BDD_OP' in 'BDDOp'.
+
+typedef enum Binop Binop;
+enum Binop
+{
+  AND_BINOP = 0,
+  XOR_BINOP = 1,
+  OR_BINOP = 2,
+  XNOR_BINOP = 3,
+};
+
 typedef struct Binary Binary;
 struct Binary
 {
+  Binop op;
   BDD *a, *b, *res;
   Binary *next;
 };
@@ -521,10 +685,11 @@ static Binary **binary_table;
 static unsigned binary_size, binary_count;
 
 static Binary *
-alloc_binary (BDD * a, BDD * b)
+alloc_binary (Binop op, BDD * a, BDD * b)
 {
   Binary *res;
   NEW (res);
+  res->op = op;
   res->a = inc (a);
   res->b = inc (b);
   binary_count++;
@@ -544,9 +709,10 @@ dealloc_binary (Binary * l)
 }
 
 static unsigned
-hash_binary (BDD * a, BDD * b)
+hash_binary (Binop op, BDD * a, BDD * b)
 {
-  return hash_bdd_ptr (a) * primes[0] + hash_bdd_ptr (b);
+  unsigned res = hash_bdd_ptr (a) * primes[0] + hash_bdd_ptr (b);
+  return res * primes[1] + (unsigned) op;
 }
 
 static void
@@ -562,7 +728,7 @@ enlarge_binary ()
       for (Binary * l = binary_table[i], *next; l; l = next)
 	{
 	  next = l->next;
-	  unsigned h = hash_binary (l->a, l->b);
+	  unsigned h = hash_binary (l->op, l->a, l->b);
 	  h &= (new_binary_size - 1);
 	  l->next = new_binary_table[h];
 	  new_binary_table[h] = l;
@@ -574,39 +740,38 @@ enlarge_binary ()
 }
 
 static Binary **
-find_binary (BDD * a, BDD * b)
+find_binary (Binop op, BDD * a, BDD * b)
 {
   stats.bdd.cache.lookups++;
-  unsigned h = hash_binary (a, b) & (binary_size - 1);
+  unsigned h = hash_binary (op, a, b) & (binary_size - 1);
   Binary **res, *l;
   for (res = binary_table + h;
-       (l = *res) && (l->a != a || l->b != b); res = &l->next)
+       (l = *res) && (l->a != a || l->b != b || l->op != op);
+       res = &l->next)
     stats.bdd.cache.collisions++;
   return res;
 }
 
 static void
-cache_binary (BDD * a, BDD * b, BDD * res)
+cache_binary (Binop op, BDD * a, BDD * b, BDD * res)
 {
   if (binary_count == binary_size)
     enlarge_binary ();
-  Binary **p = find_binary (a, b), *l = *p;;
+  Binary **p = find_binary (op, a, b), *l = *p;;
   if (l)
     {
       assert (l->res == res);
       return;
     }
-  *p = l = alloc_binary (a, b);
+  *p = l = alloc_binary (op, a, b);
   l->res = inc (res);
 }
 
 static BDD *
-cached_binary (BDD * a, BDD * b)
+cached_binary (Binop op, BDD * a, BDD * b)
 {
-  if (!binary_count)
-    return 0;
-  Binary *l = *find_binary (a, b);
-  return l ? inc (l->res) : 0;
+  Binary *l = binary_count ? *find_binary (op, a, b) : 0;
+  return count_cached (AND_BDD_OP + op, l ? inc (l->res) : 0);
 }
 
 static void
@@ -657,14 +822,14 @@ and_bdd_recursive (BDD * a, BDD * b)
     return inc (a);
   if (a->idx > b->idx)
     SWAP (BDD *, a, b);
-  BDD *res = cached_binary (a, b);
+  BDD *res = cached_binary (AND_BINOP, a, b);
   if (res)
     return res;
   COFACTOR2 (a, b);
   BDD *then = and_bdd_recursive (a_then, b_then);
   BDD *other = and_bdd_recursive (a_other, b_other);
   res = new_bdd_node (var, then, other);
-  cache_binary (a, b, res);
+  cache_binary (AND_BINOP, a, b, res);
   dec (other);
   dec (then);
   return res;
@@ -681,14 +846,14 @@ xor_bdd_recursive (BDD * a, BDD * b)
     return inc (false_bdd_node);
   if (a->idx > b->idx)
     SWAP (BDD *, a, b);
-  BDD *res = cached_binary (a, b);
+  BDD *res = cached_binary (XOR_BINOP, a, b);
   if (res)
     return res;
   COFACTOR2 (a, b);
   BDD *then = xor_bdd_recursive (a_then, b_then);
   BDD *other = xor_bdd_recursive (a_other, b_other);
   res = new_bdd_node (var, then, other);
-  cache_binary (a, b, res);
+  cache_binary (XOR_BINOP, a, b, res);
   dec (other);
   dec (then);
   return res;
@@ -705,14 +870,14 @@ or_bdd_recursive (BDD * a, BDD * b)
     return inc (a);
   if (a->idx > b->idx)
     SWAP (BDD *, a, b);
-  BDD *res = cached_binary (a, b);
+  BDD *res = cached_binary (OR_BINOP, a, b);
   if (res)
     return res;
   COFACTOR2 (a, b);
   BDD *then = or_bdd_recursive (a_then, b_then);
   BDD *other = or_bdd_recursive (a_other, b_other);
   res = new_bdd_node (var, then, other);
-  cache_binary (a, b, res);
+  cache_binary (OR_BINOP, a, b, res);
   dec (other);
   dec (then);
   return res;
@@ -729,14 +894,14 @@ xnor_bdd_recursive (BDD * a, BDD * b)
     return inc (true_bdd_node);
   if (a->idx > b->idx)
     SWAP (BDD *, a, b);
-  BDD *res = cached_binary (a, b);
+  BDD *res = cached_binary (XNOR_BINOP, a, b);
   if (res)
     return res;
   COFACTOR2 (a, b);
   BDD *then = xnor_bdd_recursive (a_then, b_then);
   BDD *other = xnor_bdd_recursive (a_other, b_other);
   res = new_bdd_node (var, then, other);
-  cache_binary (a, b, res);
+  cache_binary (XNOR_BINOP, a, b, res);
   dec (other);
   dec (then);
   return res;
@@ -789,7 +954,7 @@ project_bdd_recursive (BDD * a, int *vars, int *end)
 {
   if (a == false_bdd_node || a == true_bdd_node)
     return inc (a);
-  BDD *res = cached_unary (a);
+  BDD *res = cached_unary (PROJECT_BDD_OP, a);
   if (res)
     return res;
   unsigned var = 0;
@@ -808,9 +973,15 @@ project_bdd_recursive (BDD * a, int *vars, int *end)
 }
 
 static int
-cmp_ints (const void *p, const void *q)
+cmp_imported_vars (const void *p, const void *q)
 {
-  return *(int *) q - *(int *) p;
+  unsigned a = bdd_import_var (*(int *) p);
+  unsigned b = bdd_import_var (*(int *) q);
+  if (a < b)
+    return 1;
+  if (a > b)
+    return -1;
+  return 0;
 }
 
 BDD *
@@ -819,7 +990,7 @@ project_bdd (BDD * a, IntStack * vars)
   LOG ("project_bdd (%" PRIu64 ", #%" PRz ")", a->idx, COUNT (*vars));
   init_unary ();
   init_binary ();
-  qsort (vars->start, COUNT (*vars), sizeof *vars->start, cmp_ints);
+  qsort (vars->start, COUNT (*vars), sizeof *vars->start, cmp_imported_vars);
   BDD *res = project_bdd_recursive (a, vars->start, vars->top);
   reset_binary ();
   reset_unary ();
@@ -924,12 +1095,10 @@ cache_ternary (BDD * a, BDD * b, BDD * c, BDD * res)
 }
 
 static BDD *
-cached_ternary (BDD * a, BDD * b, BDD * c)
+cached_ternary (BDDOp op, BDD * a, BDD * b, BDD * c)
 {
-  if (!ternary_count)
-    return 0;
-  Ternary *l = *find_ternary (a, b, c);
-  return l ? inc (l->res) : 0;
+  Ternary *l = ternary_count ? *find_ternary (a, b, c) : 0;
+  return count_cached (op, l ? inc (l->res) : 0);
 }
 
 static void
@@ -991,7 +1160,7 @@ ite_bdd_recursive (BDD * a, BDD * b, BDD * c)
       if (b == true_bdd_node)
 	return inc (a);
     }
-  BDD *res = cached_ternary (a, b, c);
+  BDD *res = cached_ternary (ITE_BDD_OP, a, b, c);
   if (res)
     return res;
   unsigned var = MAX (b->var, c->var);
@@ -1022,169 +1191,595 @@ ite_bdd (BDD * a, BDD * b, BDD * c)
 
 /*------------------------------------------------------------------------*/
 
-typedef struct Count Count;
-struct Count
+// Relational product 'exists vars (a & b)' computed in one pass without
+// building the conjunction first.  The quantified variables are given as
+// a positive cube, which is walked down in lock-step with the arguments.
+
+static BDD *
+and_exists_bdd_recursive (BDD * a, BDD * b, BDD * cube)
 {
-  BDD *a;
-  Count *next;
-  Number res;
-};
+  if (a == false_bdd_node || b == false_bdd_node)
+    return inc (false_bdd_node);
+  if (a == true_bdd_node && b == true_bdd_node)
+    return inc (true_bdd_node);
+  if (a == b || b == true_bdd_node)
+    b = true_bdd_node;
+  else if (a == true_bdd_node || a->idx > b->idx)
+    SWAP (BDD *, a, b);
+  unsigned var = MAX (a->var, b->var);
+  while (cube->var > var)
+    cube = cube->then;
+  if (cube == true_bdd_node)
+    return and_bdd_recursive (a, b);
+  BDD *res = cached_ternary (EXISTS_BDD_OP, a, b, cube);
+  if (res)
+    return res;
+  COFACTOR (a);
+  COFACTOR (b);
+  if (cube->var == var)
+    {
+      BDD *then = and_exists_bdd_recursive (a_then, b_then, cube->then);
+      if (then == true_bdd_node)
+	res = then;
+      else
+	{
+	  BDD *other = and_exists_bdd_recursive (a_other, b_other, cube->then);
+	  res = or_bdd_recursive (then, other);
+	  dec (other);
+	  dec (then);
+	}
+    }
+  else
+    {
+      BDD *then = and_exists_bdd_recursive (a_then, b_then, cube);
+      BDD *other = and_exists_bdd_recursive (a_other, b_other, cube);
+      res = new_bdd_node (var, then, other);
+      dec (other);
+      dec (then);
+    }
+  cache_ternary (a, b, cube, res);
+  return res;
+}
 
-static Count **count_table;
-static unsigned count_size, count_count;
+static int
+cmp_imported_vars_ascending (const void *p, const void *q)
+{
+  unsigned a = bdd_import_var (*(int *) p);
+  unsigned b = bdd_import_var (*(int *) q);
+  if (a < b)
+    return -1;
+  if (a > b)
+    return 1;
+  return 0;
+}
 
-static Count *
-alloc_count (BDD * a)
+static BDD *
+new_cube_bdd (IntStack * vars)
 {
-  Count *res;
-  NEW (res);
-  res->a = inc (a);
-  init_number (res->res);
-  count_count++;
+  qsort (vars->start, COUNT (*vars), sizeof *vars->start,
+	 cmp_imported_vars_ascending);
+  BDD *res = inc (true_bdd_node);
+  for (const int *p = vars->start; p != vars->top; p++)
+    {
+      unsigned var = bdd_import_var (*p);
+      if (var == res->var)
+	continue;
+      BDD *tmp = new_bdd_node (var, res, false_bdd_node);
+      dec (res);
+      res = tmp;
+    }
   return res;
 }
 
-static void
-dealloc_count (Count * l)
+BDD *
+and_exists_bdd (BDD * a, BDD * b, IntStack * vars)
 {
-  assert (l);
-  assert (count_count);
-  count_count--;
-  dec (l->a);
-  clear_number (l->res);
-  DELETE (l);
+  LOG ("and_exists_bdd (%" PRIu64 ", %" PRIu64 ", #%" PRz ")",
+       a->idx, b->idx, COUNT (*vars));
+  BDD *cube = new_cube_bdd (vars);
+  init_binary ();
+  init_ternary ();
+  BDD *res = and_exists_bdd_recursive (a, b, cube);
+  reset_ternary ();
+  reset_binary ();
+  dec (cube);
+  return res;
 }
 
-static unsigned
-hash_count (BDD * a)
+BDD *
+exists_bdd (BDD * a, IntStack * vars)
 {
-  return hash_bdd_ptr (a);
+  return and_exists_bdd (a, true_bdd_node, vars);
 }
 
+/*------------------------------------------------------------------------*/
+
+// Counting is performed bottom-up without recursion.  The nodes of the
+// BDD are first collected in post-order with an explicit stack, which
+// puts children before their parents.  During counting the 'mark' field
+// of a collected node holds its position in this order and it is reset
+// afterwards.  The count of a node is the number of assignments to the
+// domain variables at and below its level.  Counts are stored in one
+// contiguous arena of 32-bit limbs, where each node only gets as many
+// limbs as the number of domain variables below it requires.
+
+typedef STACK (BDD *) BDDs;
+
+typedef struct Counter Counter;
+struct Counter
+{
+  BDDs nodes;
+  unsigned *pos, max_var, levels;
+  size_t *offset, limbs;
+  unsigned *arena;
+};
+
 static void
-enlarge_count ()
+collect_bdd_nodes (BDD * root, BDDs * nodes)
 {
-  unsigned new_count_size = count_size ? 2 * count_size : 1;
-  msg (2, "enlarging count cache from %u to %u", count_size, new_count_size);
-  Count **new_count_table;
-  ALLOC (new_count_table, new_count_size);
-  for (unsigned i = 0; i < count_size; i++)
+  BDDs work;
+  INIT (work);
+  inc_bdd_mark ();
+  PUSH (work, root);
+  while (!EMPTY (work))
     {
-      for (Count * l = count_table[i], *next; l; l = next)
+      BDD *b = POP (work);
+      if ((uintptr_t) b & 1)
 	{
-	  next = l->next;
-	  unsigned h = hash_count (l->a);
-	  h &= (new_count_size - 1);
-	  l->next = new_count_table[h];
-	  new_count_table[h] = l;
+	  PUSH (*nodes, (BDD *) ((uintptr_t) b & ~(uintptr_t) 1));
+	  continue;
 	}
+      if (b->idx <= 1 || b->mark == bdd_mark)
+	continue;
+      b->mark = bdd_mark;
+      PUSH (work, (BDD *) ((uintptr_t) b | 1));
+      PUSH (work, b->other);
+      PUSH (work, b->then);
     }
-  DEALLOC (count_table, count_size);
-  count_table = new_count_table;
-  count_size = new_count_size;
+  RELEASE (work);
 }
 
-static Count **
-find_count (BDD * a)
+unsigned
+live_bdd_nodes ()
 {
-  stats.bdd.cache.lookups++;
-  unsigned h = hash_count (a) & (count_size - 1);
-  Count **res, *l;
-  for (res = count_table + h; (l = *res) && l->a != a; res = &l->next)
-    stats.bdd.cache.collisions++;
+  return bdd_count;
+}
+
+unsigned
+size_bdd (BDD * b)
+{
+  BDDs work;
+  INIT (work);
+  inc_bdd_mark ();
+  unsigned res = 0;
+  PUSH (work, b);
+  while (!EMPTY (work))
+    {
+      BDD *n = POP (work);
+      if (n->idx <= 1 || n->mark == bdd_mark)
+	continue;
+      n->mark = bdd_mark;
+      res++;
+      PUSH (work, n->other);
+      PUSH (work, n->then);
+    }
+  RELEASE (work);
   return res;
 }
 
 static void
-cache_count (BDD * a, const Number res)
-{
-  if (count_count == count_size)
-    enlarge_count ();
-  Count **p = find_count (a), *l = *p;;
-  if (l)
-    return;
-  *p = l = alloc_count (a);
-  copy_number (l->res, res);
+init_counter (Counter * c, BDD * b, IntStack * vars)
+{
+  qsort (vars->start, COUNT (*vars), sizeof *vars->start, cmp_imported_vars);
+  c->levels = COUNT (*vars);
+  c->max_var = c->levels ? bdd_import_var (PEEK (*vars, 0)) : 1;
+  ALLOC (c->pos, c->max_var + 1);
+  for (unsigned i = 0; i < c->levels; i++)
+    c->pos[bdd_import_var (PEEK (*vars, i))] = i;
+  INIT (c->nodes);
+  collect_bdd_nodes (b, &c->nodes);
+  for (size_t i = 0; i < COUNT (c->nodes); i++)
+    {
+      BDD *n = PEEK (c->nodes, i);
+      assert (n->var <= c->max_var);
+      assert (bdd_import_var (PEEK (*vars, c->pos[n->var])) == n->var);
+      n->mark = i;
+    }
 }
 
-static int
-cached_count (Number res, BDD * a)
+static void
+reset_counter (Counter * c)
 {
-  if (!count_count)
-    return 0;
-  Count *l = *find_count (a);
-  if (!l)
-    return 0;
-  copy_number (res, l->res);
-  return 1;
+  for (BDD ** p = c->nodes.start; p != c->nodes.top; p++)
+    (*p)->mark = 0;
+  RELEASE (c->nodes);
+  DEALLOC (c->pos, c->max_var + 1);
 }
 
-static void
-init_count ()
+static unsigned
+counter_level (Counter * c, BDD * b)
 {
-  assert (!count_table);
-  assert (!count_size);
-  assert (!count_count);
+  return b->idx <= 1 ? c->levels : c->pos[b->var];
 }
 
 static void
-reset_count ()
-{
-#ifndef LOG
-  unsigned lines = count_count, old_bdd_count = bdd_count;
-#endif
-  for (unsigned i = 0; i < count_size; i++)
-    for (Count * l = count_table[i], *next; l; l = next)
-      next = l->next, dealloc_count (l);
-  assert (!count_count);
-  DEALLOC (count_table, count_size);
-  count_size = 0;
-  count_table = 0;
-#ifndef LOG
-  assert (old_bdd_count >= bdd_count);
-  LOG ("deleted %u BDD nodes referenced in %u count cache entries",
-       lines, old_bdd_count - bdd_count);
-#endif
+add_shifted_limbs (unsigned *dst, size_t dst_size,
+		   const unsigned *src, size_t src_size, unsigned shift)
+{
+  const size_t offset = shift / 32;
+  shift %= 32;
+  uint64_t carry = 0;
+  size_t i = 0;
+  while (i < src_size && i + offset < dst_size)
+    {
+      uint64_t limb = (uint64_t) src[i++] << shift;
+      carry += dst[i - 1 + offset] + (limb & 0xffffffffu);
+      dst[i - 1 + offset] = (unsigned) carry;
+      carry = (carry >> 32) + (limb >> 32);
+    }
+  for (size_t j = i; j < src_size; j++)
+    assert (!src[j]);
+  for (i += offset; carry; i++)
+    {
+      assert (i < dst_size);
+      carry += dst[i];
+      dst[i] = (unsigned) carry;
+      carry >>= 32;
+    }
 }
 
 static void
-count_bdd_recursive (Number res, BDD * a, int *vars, int *end)
+init_limb_counts (Counter * c)
 {
-  if (a == false_bdd_node)
-    return;
-  unsigned counted = 0, var = 0;
-  assert (vars == end || bdd_import_var (*vars) >= a->var);
-  while (vars != end && (var = bdd_import_var (*vars)) > a->var)
-    vars++, counted++;
-  if (a == true_bdd_node)
+  const size_t n = COUNT (c->nodes);
+  ALLOC (c->offset, n + 1);
+  for (size_t i = 0; i < n; i++)
     {
-      assert (is_zero_number (res));
-      add_power_of_two_to_number (res, counted);
-      return;
+      const unsigned level = counter_level (c, PEEK (c->nodes, i));
+      c->offset[i + 1] = c->offset[i] + (c->levels - level) / 32 + 1;
     }
-  assert (var == a->var), (void) var;
-  if (!cached_count (res, a))
+  c->limbs = c->offset[n];
+  ALLOC (c->arena, c->limbs);
+  unsigned one = 1;
+  for (size_t i = 0; i < n; i++)
     {
+      BDD *a = PEEK (c->nodes, i);
+      const unsigned level = counter_level (c, a);
+      unsigned *dst = c->arena + c->offset[i];
+      const size_t dst_size = c->offset[i + 1] - c->offset[i];
+      BDD *children[2] = { a->then, a->other };
+      for (int j = 0; j < 2; j++)
+	{
+	  BDD *child = children[j];
+	  if (child == false_bdd_node)
+	    continue;
+	  unsigned shift = counter_level (c, child) - level - 1;
+	  if (child == true_bdd_node)
+	    add_shifted_limbs (dst, dst_size, &one, 1, shift);
+	  else
+	    add_shifted_limbs (dst, dst_size,
+			       c->arena + c->offset[child->mark],
+			       c->offset[child->mark + 1] -
+			       c->offset[child->mark], shift);
+	}
+    }
+}
+
+static void
+reset_limb_counts (Counter * c)
+{
+  DEALLOC (c->arena, c->limbs);
+  DEALLOC (c->offset, COUNT (c->nodes) + 1);
+}
+
+void
+count_bdd (Number res, BDD * b, IntStack * vars)
+{
+  LOG ("count_bdd (%" PRIu64 ", #%" PRz ")", b->idx, COUNT (*vars));
+  assert (b);
+  assert (is_zero_number (res));
+  Counter c;
+  init_counter (&c, b, vars);
+  init_limb_counts (&c);
+  if (b == true_bdd_node)
+    add_power_of_two_to_number (res, c.levels);
+  else if (b != false_bdd_node)
+    {
+      const size_t i = b->mark;
+      assert (i + 1 == COUNT (c.nodes));
       Number tmp;
       init_number (tmp);
-      count_bdd_recursive (tmp, a->then, vars + 1, end);
-      count_bdd_recursive (res, a->other, vars + 1, end);
-      add_number (res, tmp);
+      for (size_t j = c.offset[i + 1]; j-- > c.offset[i];)
+	{
+	  multiply_number_by_power_of_two (res, 32);
+	  if (!c.arena[j])
+	    continue;
+	  clear_number (tmp);
+	  init_number_from_unsigned (tmp, c.arena[j]);
+	  add_number (res, tmp);
+	}
       clear_number (tmp);
-      cache_count (a, res);
+      multiply_number_by_power_of_two (res, counter_level (&c, b));
     }
-  multiply_number_by_power_of_two (res, counted);
+  reset_limb_counts (&c);
+  reset_counter (&c);
 }
 
 void
-count_bdd (Number res, BDD * b, IntStack * vars)
+sort_bdd_variables (IntStack * vars)
 {
-  LOG ("count_bdd (%" PRIu64 ", #%" PRz ")", b->idx, COUNT (*vars));
+  qsort (vars->start, COUNT (*vars), sizeof *vars->start, cmp_imported_vars);
+}
+
+// Converts the BDD into a ZDD over the domain variables, which have to be
+// sorted by 'sort_bdd_variables' and given in that order to 'init_zdds'.
+// Domain variables skipped on a BDD edge are don't cares, which in the
+// ZDD requires a node with identical children for each of them.
+
+static ZDD *
+skip_zdd_levels (ZDD * z, IntStack * vars, unsigned from, unsigned to)
+{
+  while (to-- > from)
+    {
+      ZDD *tmp = new_zdd (PEEK (*vars, to), z, z);
+      delete_zdd (z);
+      z = tmp;
+    }
+  return z;
+}
+
+ZDD *
+bdd_to_zdd (BDD * b, IntStack * vars)
+{
+  LOG ("bdd_to_zdd (%" PRIu64 ", #%" PRz ")", b->idx, COUNT (*vars));
+  Counter c;
+  init_counter (&c, b, vars);
+  const size_t n = COUNT (c.nodes);
+  ZDD **zdds;
+  ALLOC (zdds, n);
+  for (size_t i = 0; i < n; i++)
+    {
+      BDD *a = PEEK (c.nodes, i);
+      const unsigned level = counter_level (&c, a);
+      ZDD *children[2];
+      BDD *bdds[2] = { a->then, a->other };
+      for (int j = 0; j < 2; j++)
+	{
+	  BDD *child = bdds[j];
+	  ZDD *z;
+	  if (child == false_bdd_node)
+	    z = empty_zdd ();
+	  else if (child == true_bdd_node)
+	    z = base_zdd ();
+	  else
+	    z = copy_zdd (zdds[child->mark]);
+	  children[j] = skip_zdd_levels (z, vars, level + 1,
+					 counter_level (&c, child));
+	}
+      zdds[i] = new_zdd (PEEK (*vars, level), children[0], children[1]);
+      delete_zdd (children[0]);
+      delete_zdd (children[1]);
+    }
+  ZDD *res;
+  if (b == false_bdd_node)
+    res = empty_zdd ();
+  else if (b == true_bdd_node)
+    res = base_zdd ();
+  else
+    res = copy_zdd (zdds[n - 1]);
+  res = skip_zdd_levels (res, vars, 0, counter_level (&c, b));
+  for (size_t i = 0; i < n; i++)
+    delete_zdd (zdds[i]);
+  DEALLOC (zdds, n);
+  reset_counter (&c);
+  return res;
+}
+
+// Approximate counting in floating point, where the base two logarithm of
+// the count is computed, which does not overflow.  Returns '-INFINITY' if
+// the BDD is unsatisfiable.
+
+static double
+add_log2 (double a, double b)
+{
+  if (a < b)
+    SWAP (double, a, b);
+  if (b == -INFINITY)
+    return a;
+  return a + log2 (1 + exp2 (b - a));
+}
+
+double
+approximate_count_bdd (BDD * b, IntStack * vars)
+{
+  LOG ("approximate_count_bdd (%" PRIu64 ", #%" PRz ")",
+       b->idx, COUNT (*vars));
+  assert (b);
+  Counter c;
+  init_counter (&c, b, vars);
+  const size_t n = COUNT (c.nodes);
+  double *log2s;
+  ALLOC (log2s, n);
+  for (size_t i = 0; i < n; i++)
+    {
+      BDD *a = PEEK (c.nodes, i);
+      const unsigned level = counter_level (&c, a);
+      double res = -INFINITY;
+      BDD *children[2] = { a->then, a->other };
+      for (int j = 0; j < 2; j++)
+	{
+	  BDD *child = children[j];
+	  if (child == false_bdd_node)
+	    continue;
+	  double tmp = counter_level (&c, child) - level - 1;
+	  if (child != true_bdd_node)
+	    tmp += log2s[child->mark];
+	  res = add_log2 (res, tmp);
+	}
+      log2s[i] = res;
+    }
+  double res;
+  if (b == false_bdd_node)
+    res = -INFINITY;
+  else if (b == true_bdd_node)
+    res = c.levels;
+  else
+    res = log2s[b->mark] + counter_level (&c, b);
+  DEALLOC (log2s, n);
+  reset_counter (&c);
+  return res;
+}
+
+/*------------------------------------------------------------------------*/
+
+// Uniform sampling of satisfying assignments.  After computing the exact
+// counts of all nodes with 'init_limb_counts' a sample is drawn by
+// descending from the root, where at each node the 'then' branch is taken
+// with probability proportional to its share of the count of the node.
+// Domain variables skipped on the path are assigned uniformly at random.
+// Drawing a big random number below the count of a node and comparing it
+// to the share of the 'then' branch is done lazily from the most
+// significant limb on and thus usually only needs one or two limbs.
+
+static unsigned
+next_random (uint64_t * state)
+{
+  return (unsigned) (splitmix64 (state) >> 32);
+}
+
+static unsigned
+shifted_limb (const unsigned *limbs, size_t size, unsigned shift, size_t i)
+{
+  const size_t offset = shift / 32;
+  shift %= 32;
+  if (i < offset)
+    return 0;
+  const size_t j = i - offset;
+  unsigned res = j < size ? limbs[j] << shift : 0;
+  if (shift && j && j - 1 < size)
+    res |= limbs[j - 1] >> (32 - shift);
+  return res;
+}
+
+static int
+sample_then_branch (Counter * c, BDD * a, uint64_t * state)
+{
+  const unsigned *count = c->arena + c->offset[a->mark];
+  size_t top = c->offset[a->mark + 1] - c->offset[a->mark];
+  while (top && !count[top - 1])
+    top--;
+  assert (top);
+  unsigned mask = count[top - 1];
+  mask |= mask >> 1, mask |= mask >> 2, mask |= mask >> 4;
+  mask |= mask >> 8, mask |= mask >> 16;
+  BDD *then = a->then;
+  if (then == false_bdd_node)
+    return 0;
+  const unsigned one = 1, *limbs = &one;
+  size_t size = 1;
+  if (then != true_bdd_node)
+    {
+      limbs = c->arena + c->offset[then->mark];
+      size = c->offset[then->mark + 1] - c->offset[then->mark];
+    }
+  const unsigned shift = counter_level (c, then) - counter_level (c, a) - 1;
+  for (;;)
+    {
+      int below_count = 0, cmp_then = 0;
+      size_t i = top;
+      while (i-- > 0)
+	{
+	  unsigned limb = next_random (state);
+	  if (i + 1 == top)
+	    limb &= mask;
+	  if (!below_count)
+	    {
+	      if (limb > count[i])
+		break;
+	      if (limb < count[i])
+		below_count = 1;
+	    }
+	  if (!cmp_then)
+	    {
+	      unsigned other = shifted_limb (limbs, size, shift, i);
+	      if (limb < other)
+		cmp_then = -1;
+	      else if (limb > other)
+		cmp_then = 1;
+	    }
+	  if (below_count && cmp_then)
+	    return cmp_then < 0;
+	}
+      if (below_count)
+	return cmp_then < 0;
+    }
+}
+
+static void
+sample_random_levels (char *values, unsigned from, unsigned to,
+		      uint64_t * state)
+{
+  for (unsigned level = from; level < to; level++)
+    values[level] = next_random (state) & 1;
+}
+
+static int
+cmp_external_vars (const void *p, const void *q)
+{
+  return *(int *) p - *(int *) q;
+}
+
+void
+sample_bdd (BDD * b, IntStack * vars, long samples, unsigned seed,
+	    Name name)
+{
+  LOG ("sample_bdd (%" PRIu64 ", #%" PRz ", %ld)",
+       b->idx, COUNT (*vars), samples);
   assert (b);
-  init_count ();
-  qsort (vars->start, COUNT (*vars), sizeof *vars->start, cmp_ints);
-  count_bdd_recursive (res, b, vars->start, vars->top);
-  reset_count ();
+  if (b == false_bdd_node)
+    return;
+  Counter c;
+  init_counter (&c, b, vars);
+  init_limb_counts (&c);
+  IntStack printed;
+  INIT (printed);
+  for (const int *p = vars->start; p != vars->top; p++)
+    PUSH (printed, *p);
+  qsort (printed.start, COUNT (printed), sizeof *printed.start,
+	 cmp_external_vars);
+  char *values;
+  ALLOC (values, c.levels + 1);
+  uint64_t state = seed;
+  for (long i = 0; i < samples; i++)
+    {
+      sample_random_levels (values, 0, counter_level (&c, b), &state);
+      for (BDD * a = b; a != true_bdd_node;)
+	{
+	  assert (a != false_bdd_node);
+	  const unsigned level = counter_level (&c, a);
+	  BDD *child;
+	  if (sample_then_branch (&c, a, &state))
+	    child = a->then, values[level] = 1;
+	  else
+	    child = a->other, values[level] = 0;
+	  sample_random_levels (values, level + 1,
+				counter_level (&c, child), &state);
+	  a = child;
+	}
+      for (const int *p = printed.start; p != printed.top; p++)
+	{
+	  if (p != printed.start)
+	    fputc (' ', stdout);
+	  if (!values[c.pos[bdd_import_var (*p)]])
+	    fputc ('!', stdout);
+	  fputs (name.get (name.state, *p), stdout);
+	}
+      fputc ('\n', stdout);
+    }
+  DEALLOC (values, c.levels + 1);
+  RELEASE (printed);
+  reset_limb_counts (&c);
+  reset_counter (&c);
 }
 
 /*------------------------------------------------------------------------*/
@@ -1257,53 +1852,463 @@ print_one_falsifying_cube (BDD * a, Name name)
 
 /*------------------------------------------------------------------------*/
 
-typedef struct Link Link;
-struct Link
-{
-  BDD *bdd;
-  Link *link;
+// Enumerating all paths to the 'true' leaf might produce a huge number of
+// cubes.  Thus we walk the BDD with an explicit stack, cache the names of
+// variables and collect the output in a large buffer, which is written
+// with one 'fwrite' whenever it is full.
+
+#define CUBE_BUFFER_SIZE (1u << 16)
+
+typedef struct Cubes Cubes;
+struct Cubes
+{
+  FILE *file;
+  Name name;
+  BDDs path;
+  CharStack state;
+  const char **names;
+  size_t *lengths;
+  unsigned max_var;
+  char *buffer;
+  size_t pos;
 };
 
 static void
-print_linked_bdd_cube (Link * l, FILE * file, Name name)
+flush_cubes (Cubes * c)
 {
-  assert (l);
-  Link *k = l->link;
-  if (!k)
+  if (c->pos && fwrite (c->buffer, c->pos, 1, c->file) != 1)
+    die ("failed to write cubes");
+  c->pos = 0;
+}
+
+static void
+write_cube_bytes (Cubes * c, const char *bytes, size_t len)
+{
+  if (!len)
     return;
-  BDD *c = l->bdd;
-  BDD *p = k->bdd;
-  if (c != true_bdd_node)
-    fputc (' ', file);
-  if (p->other == c)
-    fputc ('!', file);
+  if (c->pos + len > CUBE_BUFFER_SIZE)
+    flush_cubes (c);
+  if (len > CUBE_BUFFER_SIZE)
+    {
+      if (fwrite (bytes, len, 1, c->file) != 1)
+	die ("failed to write cubes");
+    }
   else
-    assert (p->then == c);
-  assert (p->var > 1);
-  fputs (name.get (name.state, bdd_export_var (p->var)), file);
-  print_linked_bdd_cube (k, file, name);
+    {
+      memcpy (c->buffer + c->pos, bytes, len);
+      c->pos += len;
+    }
 }
 
 static void
-print_all_satisfying_cubes_to_file_recursively (BDD * a, FILE * file,
-						Link * parent, Name name)
+write_cube_char (Cubes * c, char ch)
 {
-  if (a == false_bdd_node)
-    return;
-  Link link = { a, parent };
-  if (a == true_bdd_node)
+  if (c->pos == CUBE_BUFFER_SIZE)
+    flush_cubes (c);
+  c->buffer[c->pos++] = ch;
+}
+
+static void
+init_cubes (Cubes * c, BDD * a, FILE * file, Name name)
+{
+  c->file = file;
+  c->name = name;
+  INIT (c->path);
+  INIT (c->state);
+  c->max_var = a->var;
+  ALLOC (c->names, c->max_var + 1);
+  ALLOC (c->lengths, c->max_var + 1);
+  ALLOC (c->buffer, CUBE_BUFFER_SIZE);
+  c->pos = 0;
+}
+
+static void
+reset_cubes (Cubes * c)
+{
+  flush_cubes (c);
+  RELEASE (c->path);
+  RELEASE (c->state);
+  DEALLOC (c->names, c->max_var + 1);
+  DEALLOC (c->lengths, c->max_var + 1);
+  DEALLOC (c->buffer, CUBE_BUFFER_SIZE);
+}
+
+static void
+write_cube_name (Cubes * c, unsigned var)
+{
+  assert (1 < var), assert (var <= c->max_var);
+  if (!c->names[var])
     {
-      print_linked_bdd_cube (&link, file, name);
-      fputc ('\n', stdout);
-      return;
+      const char *name = c->name.get (c->name.state, bdd_export_var (var));
+      c->names[var] = name;
+      c->lengths[var] = strlen (name);
+    }
+  write_cube_bytes (c, c->names[var], c->lengths[var]);
+}
+
+// The literals of a cube are printed from the leaf up to the root.
+
+static void
+write_text_cube (Cubes * c)
+{
+  BDD **path = c->path.start;
+  for (long i = (long) COUNT (c->path) - 2; i >= 0; i--)
+    {
+      BDD *p = path[i], *child = path[i + 1];
+      if (child != true_bdd_node)
+	write_cube_char (c, ' ');
+      if (p->other == child)
+	write_cube_char (c, '!');
+      else
+	assert (p->then == child);
+      write_cube_name (c, p->var);
     }
-  print_all_satisfying_cubes_to_file_recursively (a->then, file, &link, name);
-  print_all_satisfying_cubes_to_file_recursively (a->other, file, &link,
-						  name);
+  write_cube_char (c, '\n');
+}
+
+// In the dense binary format each cube takes two bits per variable with
+// the first variable in the two least significant bits of the first byte.
+// A variable is either unassigned (0), true (1) or false (2).
+
+static void
+write_binary_cube (Cubes * c, unsigned char *cube, size_t bytes)
+{
+  if (bytes)
+    memset (cube, 0, bytes);
+  BDD **path = c->path.start;
+  for (size_t i = 0; i + 1 < COUNT (c->path); i++)
+    {
+      BDD *p = path[i], *child = path[i + 1];
+      const unsigned idx = bdd_export_var (p->var) - 1;
+      const unsigned value = (p->then == child) ? 1 : 2;
+      assert (idx / 4 < bytes);
+      cube[idx / 4] |= value << (2 * (idx % 4));
+    }
+  write_cube_bytes (c, (const char *) cube, bytes);
+}
+
+static void
+write_all_satisfying_cubes (Cubes * c, BDD * a, int binary,
+			    unsigned num_vars)
+{
+  const size_t bytes = (num_vars + 3) / 4;
+  unsigned char *cube = 0;
+  if (binary)
+    ALLOC (cube, bytes);
+  PUSH (c->path, a);
+  PUSH (c->state, 0);
+  while (!EMPTY (c->path))
+    {
+      BDD *b = TOP (c->path);
+      if (b->idx <= 1)
+	{
+	  if (b == true_bdd_node)
+	    {
+	      if (binary)
+		write_binary_cube (c, cube, bytes);
+	      else
+		write_text_cube (c);
+	    }
+	  (void) POP (c->path);
+	  (void) POP (c->state);
+	  continue;
+	}
+      char *state = c->state.top - 1;
+      if (!*state)
+	{
+	  *state = 1;
+	  PUSH (c->path, b->then);
+	  PUSH (c->state, 0);
+	}
+      else if (*state == 1)
+	{
+	  *state = 2;
+	  PUSH (c->path, b->other);
+	  PUSH (c->state, 0);
+	}
+      else
+	{
+	  (void) POP (c->path);
+	  (void) POP (c->state);
+	}
+    }
+  if (binary)
+    DEALLOC (cube, bytes);
 }
 
 void
 print_all_satisfying_cubes (BDD * a, Name name)
 {
-  print_all_satisfying_cubes_to_file_recursively (a, stdout, 0, name);
+  Cubes c;
+  init_cubes (&c, a, stdout, name);
+  write_all_satisfying_cubes (&c, a, 0, 0);
+  reset_cubes (&c);
+}
+
+void
+print_all_satisfying_binary_cubes (BDD * a, unsigned num_vars)
+{
+  Cubes c;
+  init_cubes (&c, a, stdout, construct_name (0, 0));
+  write_all_satisfying_cubes (&c, a, 1, num_vars);
+  reset_cubes (&c);
+}
+
+/*------------------------------------------------------------------------*/
+
+// Binary BDD files allow to reuse a BDD without simulating the circuit
+// again.  All entries are 32-bit unsigned integers in native byte order
+// after an 8 byte magic string.  The header consists of a byte order
+// marker, the number of variables, the number of (non-constant) nodes,
+// the root, the number of relevant variables and the size of the name
+// section.  It is followed by the variable order (external variables from
+// the root to the leaves), the relevant variables if the BDD was
+// projected, the nodes and finally the zero terminated variable names.  Each
+// node is given by its external variable and its 'then' and 'other'
+// child.  Children are referenced by index, where '0' and '1' denote the
+// constants and 'i + 2' the 'i'-th node.  Nodes are stored in topological
+// order with children before parents, and thus can be read in one pass.
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static const char bdd_file_magic[8] =
+  { 'D', 'U', 'A', 'L', 'B', 'D', 'D', '1' };
+
+#define BDD_FILE_BYTE_ORDER 0x01020304u
+#define BDD_FILE_HEADER 6
+
+static void
+write_bdd_file_word (unsigned word, FILE * file, const char *path)
+{
+  uint32_t tmp = word;
+  if (fwrite (&tmp, sizeof tmp, 1, file) != 1)
+    die ("failed to write '%s'", path);
+}
+
+static unsigned
+bdd_file_index (BDD * b)
+{
+  return b->idx <= 1 ? b->idx : b->mark + 2;
+}
+
+static int
+cmp_bdd_file_order (const void *p, const void *q)
+{
+  unsigned a = bdd_import_var (*(int *) p);
+  unsigned b = bdd_import_var (*(int *) q);
+  if (a < b)
+    return 1;
+  if (a > b)
+    return -1;
+  return 0;
+}
+
+void
+write_bdd_to_file (BDD * b, Name name, unsigned num_vars,
+		   IntStack * relevant, const char *path)
+{
+  LOG ("write_bdd_to_file (%" PRIu64 ", %u, %s)", b->idx, num_vars, path);
+  FILE *file = fopen (path, "wb");
+  if (!file)
+    die ("can not write BDD file '%s'", path);
+  BDDs nodes;
+  INIT (nodes);
+  collect_bdd_nodes (b, &nodes);
+  const unsigned num_nodes = COUNT (nodes);
+  for (unsigned i = 0; i < num_nodes; i++)
+    PEEK (nodes, i)->mark = i;
+  IntStack order;
+  INIT (order);
+  for (unsigned var = 1; var <= num_vars; var++)
+    PUSH (order, var);
+  qsort (order.start, num_vars, sizeof *order.start, cmp_bdd_file_order);
+  size_t names_size = 0;
+  for (unsigned var = 1; var <= num_vars; var++)
+    names_size += strlen (name.get (name.state, var)) + 1;
+  if (names_size > UINT_MAX)
+    die ("names too large for BDD file '%s'", path);
+  if (fwrite (bdd_file_magic, sizeof bdd_file_magic, 1, file) != 1)
+    die ("failed to write '%s'", path);
+  write_bdd_file_word (BDD_FILE_BYTE_ORDER, file, path);
+  write_bdd_file_word (num_vars, file, path);
+  write_bdd_file_word (num_nodes, file, path);
+  write_bdd_file_word (bdd_file_index (b), file, path);
+  write_bdd_file_word (relevant ? COUNT (*relevant) : 0, file, path);
+  write_bdd_file_word (names_size, file, path);
+  for (const int *p = order.start; p != order.top; p++)
+    write_bdd_file_word (*p, file, path);
+  if (relevant)
+    for (const int *p = relevant->start; p != relevant->top; p++)
+      write_bdd_file_word (*p, file, path);
+  for (BDD ** p = nodes.start; p != nodes.top; p++)
+    {
+      BDD *n = *p;
+      write_bdd_file_word (bdd_export_var (n->var), file, path);
+      write_bdd_file_word (bdd_file_index (n->then), file, path);
+      write_bdd_file_word (bdd_file_index (n->other), file, path);
+    }
+  for (unsigned var = 1; var <= num_vars; var++)
+    {
+      const char *s = name.get (name.state, var);
+      if (fwrite (s, strlen (s) + 1, 1, file) != 1)
+	die ("failed to write '%s'", path);
+    }
+  if (fclose (file))
+    die ("failed to close '%s'", path);
+  for (BDD ** p = nodes.start; p != nodes.top; p++)
+    (*p)->mark = 0;
+  RELEASE (order);
+  RELEASE (nodes);
+  msg (1, "wrote BDD with %u nodes over %u variables to '%s'",
+       num_nodes, num_vars, path);
+}
+
+typedef struct BDDFile BDDFile;
+struct BDDFile
+{
+  const char *path;
+  size_t bytes;
+  void *start;
+  const uint32_t *header, *order, *relevant, *nodes;
+  const char *names;
+  unsigned num_vars, num_nodes, root, num_relevant, names_size;
+};
+
+int
+is_bdd_file (const char *path)
+{
+  FILE *file = fopen (path, "rb");
+  if (!file)
+    return 0;
+  char magic[sizeof bdd_file_magic];
+  int res = fread (magic, sizeof magic, 1, file) == 1 &&
+    !memcmp (magic, bdd_file_magic, sizeof magic);
+  fclose (file);
+  return res;
+}
+
+static void
+map_bdd_file (BDDFile * f, const char *path)
+{
+  f->path = path;
+  int fd = open (path, O_RDONLY);
+  if (fd < 0)
+    die ("can not open BDD file '%s'", path);
+  struct stat buf;
+  if (fstat (fd, &buf))
+    die ("can not determine size of BDD file '%s'", path);
+  f->bytes = buf.st_size;
+  const size_t header_bytes =
+    sizeof bdd_file_magic + BDD_FILE_HEADER * sizeof (uint32_t);
+  if (f->bytes < header_bytes)
+    die ("BDD file '%s' truncated", path);
+  f->start = mmap (0, f->bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+  close (fd);
+  if (f->start == MAP_FAILED)
+    die ("can not map BDD file '%s'", path);
+  if (memcmp (f->start, bdd_file_magic, sizeof bdd_file_magic))
+    die ("invalid magic in BDD file '%s'", path);
+  f->header =
+    (const uint32_t *) ((const char *) f->start + sizeof bdd_file_magic);
+  if (f->header[0] != BDD_FILE_BYTE_ORDER)
+    die ("BDD file '%s' written with different byte order", path);
+  f->num_vars = f->header[1];
+  f->num_nodes = f->header[2];
+  f->root = f->header[3];
+  f->num_relevant = f->header[4];
+  f->names_size = f->header[5];
+  const size_t words =
+    f->num_vars + (size_t) f->num_relevant + 3 * (size_t) f->num_nodes;
+  if (f->bytes != header_bytes + words * sizeof (uint32_t) + f->names_size)
+    die ("size of BDD file '%s' does not match header", path);
+  f->order = f->header + BDD_FILE_HEADER;
+  f->relevant = f->order + f->num_vars;
+  f->nodes = f->relevant + f->num_relevant;
+  f->names = (const char *) (f->nodes + 3 * (size_t) f->num_nodes);
+  if (f->names_size && f->names[f->names_size - 1])
+    die ("names in BDD file '%s' not terminated", path);
+  msg (1, "mapped BDD file '%s' with %u nodes over %u variables",
+       path, f->num_nodes, f->num_vars);
+}
+
+static void
+unmap_bdd_file (BDDFile * f)
+{
+  munmap (f->start, f->bytes);
+}
+
+void
+read_bdd_file_header (const char *path, StrStack * names,
+		      IntStack * relevant)
+{
+  BDDFile f;
+  map_bdd_file (&f, path);
+  for (unsigned i = 0; i < f.num_relevant; i++)
+    {
+      unsigned var = f.relevant[i];
+      if (!var || var > f.num_vars)
+	die ("invalid relevant variable '%u' in BDD file '%s'", var, path);
+      PUSH (*relevant, var);
+    }
+  const char *p = f.names, *end = f.names + f.names_size;
+  for (unsigned var = 1; var <= f.num_vars; var++)
+    {
+      if (p == end)
+	die ("names missing in BDD file '%s'", path);
+      char *name;
+      STRDUP (name, p);
+      PUSH (*names, name);
+      p += strlen (p) + 1;
+    }
+  unmap_bdd_file (&f);
+}
+
+BDD *
+read_bdd_from_file (const char *path)
+{
+  BDDFile f;
+  map_bdd_file (&f, path);
+  IntStack order;
+  INIT (order);
+  char *seen;
+  ALLOC (seen, f.num_vars + 1);
+  for (unsigned i = 0; i < f.num_vars; i++)
+    {
+      unsigned var = f.order[i];
+      if (!var || var > f.num_vars || seen[var])
+	die ("invalid variable '%u' in order of BDD file '%s'", var, path);
+      seen[var] = 1;
+      PUSH (order, var);
+    }
+  DEALLOC (seen, f.num_vars + 1);
+  set_bdd_variable_order (&order);
+  RELEASE (order);
+  BDD **map;
+  const size_t size = f.num_nodes + 2;
+  ALLOC (map, size);
+  map[0] = false_bdd_node;
+  map[1] = true_bdd_node;
+  const uint32_t *p = f.nodes;
+  for (size_t i = 2; i < size; i++)
+    {
+      unsigned var = *p++, then = *p++, other = *p++;
+      if (!var || var > f.num_vars)
+	die ("invalid variable '%u' in BDD file '%s'", var, path);
+      if (then >= i || other >= i)
+	die ("BDD file '%s' not in topological order", path);
+      unsigned ivar = bdd_import_var (var);
+      if (map[then]->var >= ivar || map[other]->var >= ivar)
+	die ("BDD file '%s' does not respect variable order", path);
+      map[i] = new_bdd_node (ivar, map[then], map[other]);
+    }
+  if (f.root >= size)
+    die ("invalid root in BDD file '%s'", path);
+  BDD *res = inc (map[f.root]);
+  for (size_t i = 2; i < size; i++)
+    dec (map[i]);
+  DEALLOC (map, size);
+  unmap_bdd_file (&f);
+  return res;
 }
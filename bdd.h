@@ -1,8 +1,30 @@
 typedef struct BDD BDD;
 
+// Operations for which computed cache hits and misses are counted.
+
+typedef enum BDDOp BDDOp;
+enum BDDOp
+{
+  NOT_BDD_OP,
+  AND_BDD_OP,
+  XOR_BDD_OP,
+  OR_BDD_OP,
+  XNOR_BDD_OP,
+  ITE_BDD_OP,
+  PROJECT_BDD_OP,
+  EXISTS_BDD_OP,
+  NUM_BDD_OPS
+};
+
+const char *bdd_op_name (BDDOp);
+
 void init_bdds ();
 void reset_bdds ();
 
+void set_bdd_variable_order (IntStack * order);
+void limit_number_of_bdd_nodes (unsigned);
+int bdd_node_limit_reached ();
+
 BDD *copy_bdd (BDD *);
 void delete_bdd (BDD *);
 
@@ -20,6 +42,12 @@ BDD *or_bdd (BDD *, BDD *);
 BDD *ite_bdd (BDD *, BDD *, BDD *);
 BDD *xnor_bdd (BDD *, BDD *);
 BDD *project_bdd (BDD *, IntStack * keep);
+BDD *exists_bdd (BDD *, IntStack * vars);
+BDD *and_exists_bdd (BDD *, BDD *, IntStack * vars);
+
+void support_bdd (BDD *, IntStack * vars);
+unsigned size_bdd (BDD *);
+unsigned live_bdd_nodes ();
 
 void print_bdd_to_file (BDD *, FILE *);
 void print_bdd (BDD *);
@@ -29,9 +57,25 @@ void print_bdd (BDD *);
 void print_one_satisfying_cube (BDD *, Name);
 void print_one_falsifying_cube (BDD *, Name);
 void print_all_satisfying_cubes (BDD *, Name);
+void print_all_satisfying_binary_cubes (BDD *, unsigned num_vars);
 
 void visualize_bdd (BDD *, Name);
 
 #include "num.h"
 
 void count_bdd (Number res, BDD *, IntStack * domain);
+void sort_bdd_variables (IntStack *);
+double approximate_count_bdd (BDD *, IntStack * domain);
+void sample_bdd (BDD *, IntStack * domain, long samples, unsigned seed,
+		 Name);
+
+#include "zdd.h"
+
+ZDD *bdd_to_zdd (BDD *, IntStack * domain);
+
+int is_bdd_file (const char *path);
+void write_bdd_to_file (BDD *, Name, unsigned num_vars, IntStack * relevant,
+			const char *path);
+void read_bdd_file_header (const char *path, StrStack * names,
+			   IntStack * relevant);
+BDD *read_bdd_from_file (const char *path);
@@ -1,9 +1,19 @@
 #include "headers.h"
 
+static void
+reset_compact (Circuit * c)
+{
+  if (!c->compact)
+    return;
+  delete_compact (c->compact);
+  c->compact = 0;
+}
+
 static Gate *
 new_gate (Circuit * c, Operator op)
 {
   assert (COUNT (c->gates) < INT_MAX);
+  reset_compact (c);
   Gate *res;
   NEW (res);
   res->idx = COUNT (c->gates);
@@ -30,6 +40,30 @@ get_gate_input (Gate * g, int input)
   return g->inputs.start[input];
 }
 
+// The dual circuit computes the negation of the circuit by exchanging AND
+// and OR, XOR and XNOR, the two branches of ITE gates and negating inputs
+// and constants.  Instead of copying the circuit, a negated circuit pointer
+// is used as a view of its dual, which is supported by encoding, printing,
+// simulation and decomposition.
+
+Operator
+dual_operator (Operator op)
+{
+  switch (op)
+    {
+    case AND_OPERATOR:
+      return OR_OPERATOR;
+    case OR_OPERATOR:
+      return AND_OPERATOR;
+    case XOR_OPERATOR:
+      return XNOR_OPERATOR;
+    case XNOR_OPERATOR:
+      return XOR_OPERATOR;
+    default:
+      return op;
+    }
+}
+
 Gate *
 new_false_gate (Circuit * c)
 {
@@ -47,6 +81,44 @@ new_input_gate (Circuit * c)
   return res;
 }
 
+// Copies of an input gate in another circuit, which either share the
+// symbol with the original input gate (if both circuits are kept) or take
+// over the symbol (if the original circuit is deleted afterwards).
+
+Gate *
+copy_input_gate_and_share_symbol (Gate * g, Circuit * c)
+{
+  assert (g->op == INPUT_OPERATOR);
+  Gate *res = new_input_gate (c);
+  Symbol *s = g->symbol;
+  if (s)
+    {
+      res->symbol = s;
+      assert (s->name);
+      LOG ("sharing input %d gate %d symbol '%s'",
+	   res->input, res->idx, s->name);
+    }
+  return res;
+}
+
+Gate *
+copy_input_gate_and_own_symbol (Gate * g, Circuit * c)
+{
+  assert (g->op == INPUT_OPERATOR);
+  Gate *res = new_input_gate (c);
+  Symbol *s = g->symbol;
+  if (s)
+    {
+      assert (s->gate == g);
+      res->symbol = s;
+      s->gate = res;
+      assert (s->name);
+      LOG ("copy and owning input %d gate %d symbol '%s'",
+	   res->input, res->idx, s->name);
+    }
+  return res;
+}
+
 Gate *
 new_and_gate (Circuit * c)
 {
@@ -77,6 +149,244 @@ new_xnor_gate (Circuit * c)
   return new_gate (c, XNOR_OPERATOR);
 }
 
+/*------------------------------------------------------------------------*/
+
+// Structural hashing of gates.  The inputs are normalized first, which
+// for the commutative operators means sorting them by index and sign.
+// Constants are propagated and trivial cases are simplified, e.g., 'x&x',
+// 'x&!x', 'x^x' and 'ITE' with a constant condition or equal branches.
+// Then an existing gate with the same operator and the same inputs is
+// reused if there is one.  Otherwise a new gate is connected to the inputs
+// and added to the hash table of the circuit.  The result is an edge,
+// which might be negated or a constant.
+
+static int
+is_constant_gate (Gate * g)
+{
+  return ((Gate *) STRIP (g))->op == FALSE_OPERATOR;
+}
+
+static Gate *
+constant_gate (Circuit * c, int value)
+{
+  Gate *res = new_false_gate (c);
+  return value ? NOT (res) : res;
+}
+
+static int
+cmp_gate_edges (const void *p, const void *q)
+{
+  Gate *g = *(Gate **) p, *h = *(Gate **) q;
+  Gate *u = STRIP (g), *v = STRIP (h);
+  if (u->idx < v->idx)
+    return -1;
+  if (u->idx > v->idx)
+    return 1;
+  return SIGN (g) - SIGN (h);
+}
+
+static void
+sort_gate_edges (Gates * inputs)
+{
+  qsort (inputs->start, COUNT (*inputs), sizeof (Gate *), cmp_gate_edges);
+}
+
+// Returns the simplified gate or zero if the normalized inputs remain.
+
+static Gate *
+simplify_and_or_gate (Circuit * c, Operator op, Gates * inputs)
+{
+  const int absorbing = (op == OR_OPERATOR);
+  sort_gate_edges (inputs);
+  Gate **q = inputs->start;
+  for (Gate ** p = inputs->start; p != inputs->top; p++)
+    {
+      Gate *g = *p;
+      if (is_constant_gate (g))
+	{
+	  if (SIGN (g) == absorbing)
+	    return constant_gate (c, absorbing);
+	  continue;
+	}
+      if (q != inputs->start && q[-1] == g)
+	continue;
+      if (q != inputs->start && q[-1] == NOT (g))
+	return constant_gate (c, absorbing);
+      *q++ = g;
+    }
+  inputs->top = q;
+  if (EMPTY (*inputs))
+    return constant_gate (c, !absorbing);
+  if (COUNT (*inputs) == 1)
+    return PEEK (*inputs, 0);
+  return 0;
+}
+
+// An n-ary XNOR gate is the XOR of its inputs negated if 'n' is even.
+// Constants and pairs of equal inputs are removed and their parity is
+// added to '*negate'.
+
+static Gate *
+simplify_xor_xnor_gate (Circuit * c, Operator op, Gates * inputs,
+			int *negate)
+{
+  int parity = (op == XNOR_OPERATOR) && !(COUNT (*inputs) & 1);
+  sort_gate_edges (inputs);
+  Gate **q = inputs->start;
+  for (Gate ** p = inputs->start; p != inputs->top; p++)
+    {
+      Gate *g = *p;
+      if (is_constant_gate (g))
+	parity ^= SIGN (g);
+      else if (q != inputs->start && STRIP (q[-1]) == STRIP (g))
+	parity ^= (q[-1] != g), q--;
+      else
+	*q++ = g;
+    }
+  inputs->top = q;
+  const size_t n = COUNT (*inputs);
+  if (!n)
+    return constant_gate (c, parity);
+  if (n == 1)
+    {
+      Gate *res = PEEK (*inputs, 0);
+      return parity ? NOT (res) : res;
+    }
+  if (op == XNOR_OPERATOR && !(n & 1))
+    parity ^= 1;
+  *negate = parity;
+  return 0;
+}
+
+// The inputs of an 'ITE' gate are not sorted but a negated condition is
+// removed by swapping the branches.
+
+static Gate *
+simplify_ite_gate (Circuit * c, Gates * inputs)
+{
+  assert (COUNT (*inputs) == 3);
+  Gate **edges = inputs->start;
+  if (SIGN (edges[0]))
+    {
+      edges[0] = NOT (edges[0]);
+      SWAP (Gate *, edges[1], edges[2]);
+    }
+  Gate *cond = edges[0], *then = edges[1], *other = edges[2];
+  if (is_constant_gate (cond))
+    return cond == c->zero ? other : then;
+  if (then == other)
+    return then;
+  if (is_constant_gate (then) && other == NOT (then))
+    return SIGN (then) ? cond : NOT (cond);
+  return 0;
+}
+
+static unsigned
+hash_gate (Operator op, Gates * inputs)
+{
+  unsigned res = (unsigned) op * primes[0];
+  unsigned i = 1;
+  for (Gate ** p = inputs->start; p != inputs->top; p++)
+    {
+      Gate *g = *p;
+      unsigned edge = 2u * (unsigned) ((Gate *) STRIP (g))->idx + SIGN (g);
+      res = (res + edge) * primes[i++];
+      if (i == num_primes)
+	i = 0;
+    }
+  return res;
+}
+
+static void
+enlarge_gate_table (Circuit * c)
+{
+  const unsigned old_size = c->hash.size;
+  const unsigned new_size = old_size ? 2 * old_size : 1;
+  Gate **new_table;
+  ALLOC (new_table, new_size);
+  for (unsigned i = 0; i < old_size; i++)
+    for (Gate * g = c->hash.table[i], *next; g; g = next)
+      {
+	next = g->next;
+	const unsigned h = g->hash & (new_size - 1);
+	g->next = new_table[h];
+	new_table[h] = g;
+      }
+  DEALLOC (c->hash.table, old_size);
+  c->hash.table = new_table;
+  c->hash.size = new_size;
+}
+
+static Gate **
+find_gate (Circuit * c, Operator op, Gates * inputs, unsigned hash)
+{
+  const size_t n = COUNT (*inputs);
+  Gate **res, *g;
+  for (res = c->hash.table + (hash & (c->hash.size - 1));
+       (g = *res) &&
+       (g->hash != hash || g->op != op || COUNT (g->inputs) != n ||
+	memcmp (g->inputs.start, inputs->start, n * sizeof (Gate *)));
+       res = &g->next)
+    ;
+  return res;
+}
+
+static void
+reset_gate_table (Circuit * c)
+{
+  DEALLOC (c->hash.table, c->hash.size);
+  c->hash.table = 0;
+  c->hash.size = c->hash.count = 0;
+}
+
+Gate *
+new_hashed_gate (Circuit * c, Operator op, Gates * inputs)
+{
+  Gate *res;
+  int negate = 0;
+  switch (op)
+    {
+    case AND_OPERATOR:
+    case OR_OPERATOR:
+      res = simplify_and_or_gate (c, op, inputs);
+      break;
+    case XOR_OPERATOR:
+    case XNOR_OPERATOR:
+      res = simplify_xor_xnor_gate (c, op, inputs, &negate);
+      break;
+    default:
+      assert (op == ITE_OPERATOR);
+      res = simplify_ite_gate (c, inputs);
+      break;
+    }
+  if (res)
+    {
+      stats.gates.simplified++;
+      return res;
+    }
+  if (c->hash.count == c->hash.size)
+    enlarge_gate_table (c);
+  const unsigned hash = hash_gate (op, inputs);
+  Gate **p = find_gate (c, op, inputs, hash);
+  if ((res = *p))
+    {
+      stats.gates.hashed++;
+      LOG ("found structurally hashed %s gate %d", gate_name (res), res->idx);
+    }
+  else
+    {
+      res = new_gate (c, op);
+      for (Gate ** q = inputs->start; q != inputs->top; q++)
+	connect_gates (*q, res);
+      res->hash = hash;
+      *p = res;
+      c->hash.count++;
+    }
+  return negate ? NOT (res) : res;
+}
+
+/*------------------------------------------------------------------------*/
+
 Circuit *
 new_circuit ()
 {
@@ -102,6 +412,9 @@ delete_circuit (Circuit * c)
     delete_gate (*p);
   RELEASE (c->inputs);
   RELEASE (c->gates);
+  RELEASE (c->outputs);
+  reset_gate_table (c);
+  reset_compact (c);
   DELETE (c);
 }
 
@@ -129,6 +442,7 @@ connect_gates (Gate * input, Gate * output)
   assert (stripped_input->circuit == stripped_output->circuit);
   assert (stripped_output->op != FALSE_OPERATOR);
   assert (stripped_output->op != INPUT_OPERATOR);
+  reset_compact (stripped_output->circuit);
   PUSH (stripped_input->outputs, output);
   PUSH (stripped_output->inputs, input);
 #ifndef NLOG
@@ -209,16 +523,34 @@ init_gate_map (Circuit * c, int value)
     }
 }
 
+// Numbers the gates in post-order of a depth-first traversal.  The
+// traversal uses an explicit stack of visits of the (unsorted) gate
+// indices, since circuits can be arbitrarily deep.
+
 static int
-sort_gate (Gate * g, int idx)
+sort_gate (Circuit * c, Gate * g, int idx, Visits * visits)
 {
-  if (SIGN (g))
-    g = NOT (g);
+  assert (!SIGN (g));
   if (g->map >= 0)
     return idx;
-  for (Gate ** p = g->inputs.start; p != g->inputs.top; p++)
-    idx = sort_gate (*p, idx);
-  return g->map = ++idx;
+  assert (EMPTY (*visits));
+  push_visit (visits, g->idx);
+  while (!EMPTY (*visits))
+    {
+      Visit *visit = visits->top - 1;
+      Gate *h = PEEK (c->gates, visit->lit);
+      if (visit->next < COUNT (h->inputs))
+	{
+	  const unsigned i = visit->next++;
+	  Gate *input = STRIP (PEEK (h->inputs, i));
+	  if (input->map < 0)
+	    push_visit (visits, input->idx);
+	  continue;
+	}
+      visits->top--;
+      h->map = ++idx;
+    }
+  return idx;
 }
 
 static int
@@ -233,15 +565,20 @@ void
 sort_circuit (Circuit * c)
 {
   LOG ("sorting circuit");
+  reset_gate_table (c);		// hashes depend on indices
+  reset_compact (c);
   const int n = COUNT (c->gates);
   init_gate_map (c, -1);
+  Visits visits;
+  INIT (visits);
   int idx = 0;
   for (Gate ** p = c->inputs.start; p != c->inputs.top; p++)
-    idx = sort_gate (*p, idx);
+    idx = sort_gate (c, *p, idx, &visits);
   assert (idx == (int) COUNT (c->inputs));
   for (Gate ** p = c->gates.top; p != c->gates.start; p--)
-    idx = sort_gate (p[-1], idx);
+    idx = sort_gate (c, p[-1], idx, &visits);
   assert (idx == n);
+  RELEASE (visits);
   qsort (c->gates.start, n, sizeof (Gate *), cmp);
   for (idx = 0; idx < n; idx++)
     {
@@ -22,11 +22,13 @@ STACK (Gate *)
      struct Gate
      {
        Operator op;
-       int idx, input, code, map;
-       char pos, neg, mark, root;
+       int idx, input, map;
+       char pos, neg, mark;
        Gates inputs, outputs;
        Circuit *circuit;
        struct Symbol *symbol;
+       unsigned hash;
+       Gate *next;
      };
 
      int get_gate_size (Gate *);
@@ -36,6 +38,13 @@ STACK (Gate *)
      {
        Gates inputs, gates;
        Gate *zero, *output;
+       Gates outputs;		// all outputs if there are several
+       struct Compact *compact;	// cached compact form (or zero)
+       struct
+       {
+	 Gate **table;
+	 unsigned size, count;
+       } hash;
      };
 
      Circuit *new_circuit ();
@@ -49,7 +58,13 @@ STACK (Gate *)
      Gate *new_ite_gate (Circuit *);
      Gate *new_xnor_gate (Circuit *);
 
+     Gate *copy_input_gate_and_share_symbol (Gate *, Circuit *);
+     Gate *copy_input_gate_and_own_symbol (Gate *, Circuit *);
+
+     Gate *new_hashed_gate (Circuit *, Operator, Gates * inputs);
+
      const char *gate_name (Gate *);
+     Operator dual_operator (Operator);
 
      void connect_gates (Gate * input, Gate * output);
      void connect_output (Circuit *, Gate * output);
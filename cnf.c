@@ -55,6 +55,9 @@ delete_cnf (CNF * cnf)
   for (Clause ** p = cnf->clauses.start; p < cnf->clauses.top; p++)
     delete_clause (*p);
   RELEASE (cnf->clauses);
+  for (Clause ** p = cnf->xors.start; p < cnf->xors.top; p++)
+    delete_clause (*p);
+  RELEASE (cnf->xors);
   DELETE (cnf);
 }
 
@@ -73,6 +76,20 @@ add_clause_to_cnf (Clause * c, CNF * cnf)
   LOG ("added clause %lu to %s CNF", c->id, cnf_type (cnf));
 }
 
+// Native XOR constraints are kept separately and never become garbage.
+// They are only generated with '--xor' and not counted as clauses.
+
+void
+add_xor_to_cnf (Clause * c, CNF * cnf)
+{
+  assert (c), assert (cnf);
+  assert (c->dual == cnf->dual);
+  assert (!c->redundant);
+  c->id = cnf->added++;
+  PUSH (cnf->xors, c);
+  LOG ("added XOR %lu to %s CNF", c->id, cnf_type (cnf));
+}
+
 static void
 collect_garbage_clause (Clause * c, CNF * cnf)
 {
@@ -128,11 +145,10 @@ collect_garbage_clauses (CNF * cnf)
   stats.collected += collected;
 }
 
-int
-maximum_variable_index (CNF * cnf)
+static int
+maximum_variable_index_in_clauses (Clauses * clauses, int res)
 {
-  int res = 0;
-  for (Clause ** p = cnf->clauses.start; p < cnf->clauses.top; p++)
+  for (Clause ** p = clauses->start; p < clauses->top; p++)
     {
       Clause *c = *p;
       for (int i = 0; i < c->size; i++)
@@ -146,10 +162,17 @@ maximum_variable_index (CNF * cnf)
 }
 
 int
-minimum_variable_index_above (CNF * cnf, int lower_limit)
+maximum_variable_index (CNF * cnf)
 {
-  int res = INT_MAX;
-  for (Clause ** p = cnf->clauses.start; p < cnf->clauses.top; p++)
+  int res = maximum_variable_index_in_clauses (&cnf->clauses, 0);
+  return maximum_variable_index_in_clauses (&cnf->xors, res);
+}
+
+static int
+minimum_variable_index_in_clauses (Clauses * clauses,
+				   int lower_limit, int res)
+{
+  for (Clause ** p = clauses->start; p < clauses->top; p++)
     {
       Clause *c = *p;
       for (int i = 0; i < c->size; i++)
@@ -162,6 +185,14 @@ minimum_variable_index_above (CNF * cnf, int lower_limit)
   return res;
 }
 
+int
+minimum_variable_index_above (CNF * cnf, int lower_limit)
+{
+  int res = minimum_variable_index_in_clauses (&cnf->clauses,
+					       lower_limit, INT_MAX);
+  return minimum_variable_index_in_clauses (&cnf->xors, lower_limit, res);
+}
+
 void
 print_cnf_to_file (CNF * cnf, int max_relevant, FILE * file)
 {
@@ -181,10 +212,15 @@ print_cnf_to_file (CNF * cnf, int max_relevant, FILE * file)
     }
   else
     m = max_relevant;
-  long n = COUNT (cnf->clauses);
+  long n = COUNT (cnf->clauses) + COUNT (cnf->xors);
   fprintf (file, "p cnf %d %ld\n", m, n);
   for (Clause ** p = cnf->clauses.start; p < cnf->clauses.top; p++)
     print_clause_to_file (*p, file);
+  for (Clause ** p = cnf->xors.start; p < cnf->xors.top; p++)
+    {
+      fputc ('x', file);	// extended DIMACS XOR line
+      print_clause_to_file (*p, file);
+    }
 }
 
 void
@@ -8,6 +8,7 @@ STACK (struct Clause *)
        char dual;
        long added, irredundant, redundant, active;
        Clauses clauses;
+       Clauses xors;		// exclusive-or of literals is true
      };
 
      CNF *new_cnf (int dual);
@@ -20,6 +21,7 @@ STACK (struct Clause *)
      void print_cnf (CNF *);
 
      void add_clause_to_cnf (Clause *, CNF *);
+     void add_xor_to_cnf (Clause *, CNF *);
      void mark_clause_active (Clause *, CNF *);
      void mark_clause_inactive (Clause *, CNF *);
 
@@ -55,6 +55,95 @@ count () {
     error \
 "counting mismatch between SAT and BDD engine: '$last' and '$lastline'"
   fi
+  for order in 1 2 3
+  do
+    execute $dualiza $1 -b --bddorder=$order
+    if [ ! "$last" = "$lastline" ]
+    then
+      error \
+"counting mismatch with BDD order '$order': '$last' and '$lastline'"
+    fi
+  done
+  execute $dualiza $1 --decompose
+  if [ ! "$last" = "$lastline" ]
+  then
+    error \
+"counting mismatch with decomposition: '$last' and '$lastline'"
+  fi
+  execute $dualiza $1 --gates
+  if [ ! "$last" = "$lastline" ]
+  then
+    error \
+"counting mismatch with gate extraction: '$last' and '$lastline'"
+  fi
+  execute $dualiza $1 --decompose --threads=2
+  if [ ! "$last" = "$lastline" ]
+  then
+    error \
+"counting mismatch with parallel component counting: '$last' and '$lastline'"
+  fi
+  execute $dualiza $1 -b --decompose --threads=2
+  if [ ! "$last" = "$lastline" ]
+  then
+    error \
+"counting mismatch with parallel BDD component counting: '$last' and '$lastline'"
+  fi
+  execute $dualiza $1 --hybrid=1
+  if [ ! "$last" = "$lastline" ]
+  then
+    error \
+"counting mismatch with hybrid BDD counting: '$last' and '$lastline'"
+  fi
+  execute $dualiza $1 -e --zdd=1
+  zdd="`tail -n +2 $tmp|wc -l|awk '{print $1}'`"
+  if [ ! "$last" = "$zdd" ]
+  then
+    error \
+"counting mismatch with ZDD enumeration: '$last' and '$zdd'"
+  fi
+  execute $dualiza $1 -b --quantify=0
+  if [ ! "$last" = "$lastline" ]
+  then
+    error \
+"counting mismatch without early quantification: '$last' and '$lastline'"
+  fi
+  execute $dualiza $1 -b --threads=4
+  if [ ! "$last" = "$lastline" ]
+  then
+    error \
+"counting mismatch with parallel BDD workers: '$last' and '$lastline'"
+  fi
+  execute $dualiza $1 -b --bddlimit=10
+  if [ ! "$last" = "$lastline" ]
+  then
+    error \
+"counting mismatch with BDD node limit: '$last' and '$lastline'"
+  fi
+  execute $dualiza $1 -b -w $tmp.bdd
+  execute $dualiza $tmp.bdd
+  if [ ! "$last" = "$lastline" ]
+  then
+    error \
+"counting mismatch with saved BDD file: '$last' and '$lastline'"
+  fi
+  rel="`grep '^c [0-9][0-9,]*$' $1|head -1|sed -e 's,^c ,,'`"
+  if [ "$rel" ]
+  then
+    grep -v '^c' $1 > $tmp.cnf
+  else
+    cp $1 $tmp.cnf
+    rel="`seq -s , 1 \`awk '/^p cnf/{print $3}' $1\``"
+  fi
+  if [ "$rel" ]
+  then
+    echo "$rel" > $tmp.proj
+    execute $dualiza $tmp.cnf -b -p $tmp.proj
+    if [ ! "$last" = "$lastline" ]
+    then
+      error \
+"counting mismatch with projections file: '$last' and '$lastline'"
+    fi
+  fi
   case `basename $1 .cnf` in
     0000) ;; # sharpSAT gives wrong answer
     2???) ;; # can not do projection with sharpSAT
@@ -1,54 +1,51 @@
 #include "headers.h"
 
+// The cone of influence is computed on the compact form of the circuit.
+// Inputs of gates have smaller indices than the gates, so the polarities
+// in which gates occur are propagated from the output to the inputs in
+// one sweep over the gates in reverse order.  Bit 0 of the polarity of a
+// gate is set if it occurs positively and bit 1 if it occurs negatively.
+// For a circuit with several outputs the cone of all of them is computed.
+
 static void
-coi (Circuit * c, Gate * g, int sign)
+propagate_polarity (unsigned char *polarity, unsigned lit, unsigned mask)
 {
-  if (SIGN (g))
-    sign = !sign, g = NOT (g);
-  assert (c);
-  assert (g);
-  const int mark = (1 << sign);
-  if (g->mark & mark)
-    return;
-  g->mark |= mark;
-  if (sign)
-    g->neg = 1;
-  else
-    g->pos = 1;
-  switch (g->op)
-    {
-    case OR_OPERATOR:
-    case AND_OPERATOR:
-      for (Gate ** p = g->inputs.start; p < g->inputs.top; p++)
-	coi (c, *p, sign);
-      break;
-    case ITE_OPERATOR:
-      for (Gate ** p = g->inputs.start; p < g->inputs.top; p++)
-	{
-	  coi (c, *p, sign);
-	  if (p == g->inputs.start)
-	    coi (c, *p, !sign);
-	}
-      break;
-    case XOR_OPERATOR:
-    case XNOR_OPERATOR:
-      for (Gate ** p = g->inputs.start; p < g->inputs.top; p++)
-	coi (c, *p, sign), coi (c, *p, !sign);
-      break;
-    case FALSE_OPERATOR:
-    case INPUT_OPERATOR:
-      break;
-    }
+  if (COMPACT_SIGN (lit))
+    mask = ((mask & 1) << 1) | (mask >> 1);
+  polarity[COMPACT_GATE (lit)] |= mask;
 }
 
 static void
-reset_pos_neg_mark_fields_of_circuit (Circuit * c)
+coi (Compact * compact, unsigned char *polarity)
 {
-  LOG ("resetting pos, neg, and mark fields of circuit");
-  for (Gate ** p = c->gates.start; p < c->gates.top; p++)
+  for (unsigned i = compact->num_gates; i-- > 0;)
     {
-      Gate *g = *p;
-      g->pos = g->neg = g->mark = 0;
+      const unsigned mask = polarity[i];
+      if (!mask)
+	continue;
+      const unsigned *p = compact->inputs + compact->first_input[i];
+      const unsigned *end = compact->inputs + compact->first_input[i + 1];
+      switch (compact->ops[i])
+	{
+	case OR_OPERATOR:
+	case AND_OPERATOR:
+	  for (; p != end; p++)
+	    propagate_polarity (polarity, *p, mask);
+	  break;
+	case ITE_OPERATOR:
+	  propagate_polarity (polarity, *p++, 3);
+	  for (; p != end; p++)
+	    propagate_polarity (polarity, *p, mask);
+	  break;
+	case XOR_OPERATOR:
+	case XNOR_OPERATOR:
+	  for (; p != end; p++)
+	    propagate_polarity (polarity, *p, 3);
+	  break;
+	case FALSE_OPERATOR:
+	case INPUT_OPERATOR:
+	  break;
+	}
     }
 }
 
@@ -56,13 +53,22 @@ void
 cone_of_influence (Circuit * c)
 {
   check_circuit_connected (c);
-  reset_pos_neg_mark_fields_of_circuit (c);
-  coi (c, c->output, 0);
+  Compact *compact = compact_circuit (c);
+  unsigned char *polarity = compact->polarity;
+  memset (polarity, 0, compact->num_gates);
+  if (EMPTY (c->outputs))
+    propagate_polarity (polarity, compact_output (c), 1);
+  else
+    for (Gate ** p = c->outputs.start; p != c->outputs.top; p++)
+      propagate_polarity (polarity, compact_literal (*p), 1);
+  coi (compact, polarity);
   int pos = 0, neg = 0, both = 0, tree = 0, disconnected = 0;
   for (Gate ** p = c->gates.start; p < c->gates.top; p++)
     {
       Gate *g = *p;
       assert (!SIGN (g));
+      g->pos = polarity[g->idx] & 1;
+      g->neg = polarity[g->idx] >> 1;
       if (g->pos && g->neg)
 	both++;
       else if (g->pos)
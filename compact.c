@@ -0,0 +1,119 @@
+#include "headers.h"
+
+unsigned
+compact_literal (Gate * g)
+{
+  const int sign = SIGN (g);
+  if (sign)
+    g = NOT (g);
+  assert (g->idx >= 0);
+  return COMPACT_LITERAL (g->idx, sign);
+}
+
+unsigned
+compact_output (Circuit * c)
+{
+  assert (c->output);
+  return compact_literal (c->output);
+}
+
+static Compact *
+new_compact (Circuit * c)
+{
+  const double start = process_time ();
+  const unsigned n = COUNT (c->gates);
+  size_t edges = 0;
+  for (Gate ** p = c->gates.start; p != c->gates.top; p++)
+    edges += COUNT ((*p)->inputs);
+  if (edges > UINT_MAX)
+    die ("too many edges for compact circuit");
+  Compact *res;
+  NEW (res);
+  res->num_gates = n;
+  res->num_edges = edges;
+  ALLOC (res->ops, n);
+  ALLOC (res->input, n);
+  ALLOC (res->first_input, n + 1);
+  ALLOC (res->inputs, edges);
+  ALLOC (res->first_output, n + 1);
+  ALLOC (res->outputs, edges);
+  ALLOC (res->polarity, n);
+  ALLOC (res->code, n);
+  ALLOC (res->root, n);
+  unsigned i = 0, j = 0;
+  for (Gate ** p = c->gates.start; p != c->gates.top; p++, i++)
+    {
+      Gate *g = *p;
+      assert (g->idx == (int) i);
+      res->ops[i] = g->op;
+      if (g->op == INPUT_OPERATOR)
+	res->input[i] = g->input;
+      res->first_input[i] = j;
+      for (Gate ** q = g->inputs.start; q != g->inputs.top; q++)
+	{
+	  const unsigned lit = compact_literal (*q);
+	  assert (COMPACT_GATE (lit) < i);
+	  res->inputs[j++] = lit;
+	  res->first_output[COMPACT_GATE (lit)]++;
+	}
+    }
+  res->first_input[n] = j;
+  assert (j == edges);
+  unsigned sum = 0;
+  for (i = 0; i <= n; i++)
+    {
+      const unsigned count = res->first_output[i];
+      res->first_output[i] = sum;
+      sum += count;
+    }
+  assert (sum == edges);
+  unsigned *top;
+  ALLOC (top, n + 1);
+  memcpy (top, res->first_output, (n + 1) * sizeof *top);
+  for (i = 0; i < n; i++)
+    for (j = res->first_input[i]; j < res->first_input[i + 1]; j++)
+      res->outputs[top[COMPACT_GATE (res->inputs[j])]++] = i;
+  DEALLOC (top, n + 1);
+  msg (2, "compact circuit with %u gates and %u edges in %.2f seconds",
+       n, res->num_edges, process_time () - start);
+  return res;
+}
+
+void
+delete_compact (Compact * compact)
+{
+  const unsigned n = compact->num_gates, edges = compact->num_edges;
+  DEALLOC (compact->ops, n);
+  DEALLOC (compact->input, n);
+  DEALLOC (compact->first_input, n + 1);
+  DEALLOC (compact->inputs, edges);
+  DEALLOC (compact->first_output, n + 1);
+  DEALLOC (compact->outputs, edges);
+  DEALLOC (compact->polarity, n);
+  DEALLOC (compact->code, n);
+  DEALLOC (compact->root, n);
+  if (compact->luts)
+    DEALLOC (compact->luts, n);
+  DELETE (compact);
+}
+
+// The compact form is generated on demand and kept in the circuit until
+// gates are added or connected or the circuit is sorted.
+
+Compact *
+compact_circuit (Circuit * c)
+{
+  if (!c->compact)
+    c->compact = new_compact (c);
+  assert (c->compact->num_gates == COUNT (c->gates));
+  return c->compact;
+}
+
+void
+push_visit (Visits * visits, unsigned lit)
+{
+  Visit visit;
+  visit.lit = lit;
+  visit.next = 0;
+  PUSH (*visits, visit);
+}
@@ -0,0 +1,47 @@
+typedef struct Compact Compact;
+
+// Frozen compressed sparse row form of a circuit.  Gates are numbered by
+// their 'idx' and edges are literals '2*idx + sign'.  The input literals
+// of gate 'i' are 'inputs[first_input[i]]' up to (excluding)
+// 'inputs[first_input[i+1]]' and its fan-out gates are stored the same
+// way in 'outputs'.  Gates are sorted topologically, thus inputs of a gate
+// have smaller indices.  Besides the structure there are per gate working
+// arrays for the cone of influence and the encoder (including LUTs).
+
+struct Compact
+{
+  unsigned num_gates, num_edges;
+  unsigned char *ops;
+  unsigned *input;		// input index of input gates
+  unsigned *first_input, *inputs;
+  unsigned *first_output, *outputs;
+  unsigned char *polarity;	// cone of influence (bit 0 pos, bit 1 neg)
+  int *code;			// encoding variable of gate
+  unsigned char *root;		// encoded as root (bit 0 and 1 for sign)
+  struct LUT *luts;		// LUT mapping (computed on demand)
+};
+
+Compact *compact_circuit (Circuit *);	// cached until modified
+void delete_compact (Compact *);
+
+#define COMPACT_LITERAL(IDX,SIGN) (2u*(unsigned)(IDX) + (unsigned)(SIGN))
+#define COMPACT_GATE(LIT) ((LIT) >> 1)
+#define COMPACT_SIGN(LIT) ((int)((LIT) & 1))
+
+unsigned compact_literal (Gate *);
+unsigned compact_output (Circuit *);
+
+// Depth-first traversals of the compact form use an explicit stack of
+// visits instead of recursion, in order to handle arbitrarily deep
+// circuits.  A visit consists of a literal and the next input to visit.
+
+typedef struct Visit Visit;
+
+struct Visit
+{
+  unsigned lit, next;
+};
+
+typedef STACK (Visit) Visits;
+
+void push_visit (Visits *, unsigned lit);
@@ -74,6 +74,8 @@ else
   CC=gcc
   TARGET=dualiza
 fi
+[ x"$LIBS" = x ] || LIBS="$LIBS "
+LIBS="${LIBS}-lm"
 CFLAGS=-Wall
 [ $check = undefined ] && check=$debug
 [ $log = undefined ] && log=$debug
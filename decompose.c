@@ -0,0 +1,161 @@
+#include "headers.h"
+
+// Disjoint-support decomposition of a top-level conjunction.  Gates are
+// merged with their inputs in a union-find structure, except for the
+// top-level gate itself and constants.  Conjuncts in different classes
+// have pairwise disjoint input supports and the circuit is satisfied iff
+// each group of conjuncts is.  Thus the model count is the product of the
+// counts of the groups times two to the power of the unconstrained inputs.
+
+static int
+find_root (int *parent, int idx)
+{
+  int root = idx;
+  while (parent[root] != root)
+    root = parent[root];
+  while (parent[idx] != root)
+    {
+      int next = parent[idx];
+      parent[idx] = root;
+      idx = next;
+    }
+  return root;
+}
+
+static void
+merge_roots (int *parent, int a, int b)
+{
+  a = find_root (parent, a);
+  b = find_root (parent, b);
+  if (a < b)
+    parent[b] = a;
+  else
+    parent[a] = b;
+}
+
+static Component *
+new_component ()
+{
+  Component *res;
+  NEW (res);
+  res->circuit = new_circuit ();
+  return res;
+}
+
+void
+delete_component (Component * c)
+{
+  delete_circuit (c->circuit);
+  RELEASE (c->inputs);
+  DELETE (c);
+}
+
+static Gate *
+decomposed_gate (Gate * g, Gate ** map, Circuit * c)
+{
+  const int sign = SIGN (g);
+  if (sign)
+    g = NOT (g);
+  Gate *res;
+  if (g->op == FALSE_OPERATOR)
+    res = new_false_gate (c);
+  else
+    res = map[g->idx];
+  assert (res);
+  return sign ? NOT (res) : res;
+}
+
+// Returns the number of components or zero if the output is not an AND
+// gate or all its conjuncts end up in the same component.  For a view of
+// the dual circuit (a negated circuit pointer) the output is negated,
+// while the components are still copies of the (primal) gates.
+
+int
+decompose_circuit (Circuit * circuit, Components * components)
+{
+  Circuit *c = STRIP (circuit);
+  Gate *top = STRIP (c->output);
+  const int sign = SIGN (c->output) ^ SIGN (circuit);
+  if (top->op != (sign ? OR_OPERATOR : AND_OPERATOR))
+    return 0;
+  cone_of_influence (c);
+  const int num_gates = COUNT (c->gates);
+  int *parent;
+  ALLOC (parent, num_gates);
+  for (int i = 0; i < num_gates; i++)
+    parent[i] = i;
+  for (Gate ** p = c->gates.start; p != c->gates.top; p++)
+    {
+      Gate *g = *p;
+      if (g == top || (!g->pos && !g->neg))
+	continue;
+      for (Gate ** q = g->inputs.start; q != g->inputs.top; q++)
+	{
+	  Gate *h = STRIP (*q);
+	  if (h->op != FALSE_OPERATOR)
+	    merge_roots (parent, g->idx, h->idx);
+	}
+    }
+  int *component, num_components = 0;
+  ALLOC (component, num_gates);
+  for (Gate ** p = top->inputs.start; p != top->inputs.top; p++)
+    {
+      const int root = find_root (parent, ((Gate *) STRIP (*p))->idx);
+      if (!component[root])
+	component[root] = ++num_components;
+    }
+  if (num_components > 1)
+    {
+      for (int i = 0; i < num_components; i++)
+	PUSH (*components, new_component ());
+      Gate **map;
+      ALLOC (map, num_gates);
+      Gates inputs;
+      INIT (inputs);
+      for (Gate ** p = c->gates.start; p != c->gates.top; p++)
+	{
+	  Gate *g = *p;
+	  if (g == top || (!g->pos && !g->neg) || g->op == FALSE_OPERATOR)
+	    continue;
+	  const int k = component[find_root (parent, g->idx)];
+	  assert (k > 0);
+	  Component *d = PEEK (*components, k - 1);
+	  if (g->op == INPUT_OPERATOR)
+	    {
+	      map[g->idx] = copy_input_gate_and_share_symbol (g, d->circuit);
+	      PUSH (d->inputs, g->input + 1);
+	      continue;
+	    }
+	  CLEAR (inputs);
+	  for (Gate ** q = g->inputs.start; q != g->inputs.top; q++)
+	    PUSH (inputs, decomposed_gate (*q, map, d->circuit));
+	  map[g->idx] = new_hashed_gate (d->circuit, g->op, &inputs);
+	}
+      for (int k = 1; k <= num_components; k++)
+	{
+	  Component *d = PEEK (*components, k - 1);
+	  CLEAR (inputs);
+	  for (Gate ** p = top->inputs.start; p != top->inputs.top; p++)
+	    {
+	      Gate *g = *p;
+	      if (component[find_root (parent, ((Gate *) STRIP (g))->idx)]
+		  != k)
+		continue;
+	      if (sign)
+		g = NOT (g);
+	      PUSH (inputs, decomposed_gate (g, map, d->circuit));
+	    }
+	  Gate *output = new_hashed_gate (d->circuit, AND_OPERATOR, &inputs);
+	  connect_output (d->circuit, output);
+	  LOG ("component %d with %" PRz " inputs and %" PRz " gates", k,
+	       COUNT (d->inputs), COUNT (d->circuit->gates));
+	}
+      RELEASE (inputs);
+      DEALLOC (map, num_gates);
+    }
+  else
+    num_components = 0;
+  DEALLOC (component, num_gates);
+  DEALLOC (parent, num_gates);
+  return num_components;
+}
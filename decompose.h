@@ -0,0 +1,12 @@
+typedef struct Component Component;
+
+struct Component
+{
+  Circuit *circuit;
+  IntStack inputs;		// original (external) input of each input
+};
+
+typedef STACK (Component *) Components;
+
+int decompose_circuit (Circuit *, Components *);
+void delete_component (Component *);
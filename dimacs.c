@@ -32,6 +32,37 @@ cmp (const void *p, const void *q)
   return a - b;
 }
 
+// Without gate extraction the CNF is a conjunction of disjunctions.
+
+static Gate *
+conjunction_of_clauses (Circuit * c, IntStack * clauses)
+{
+  Gates conjuncts, disjuncts;
+  INIT (conjuncts);
+  INIT (disjuncts);
+  for (const int *p = clauses->start; p != clauses->top; p++)
+    {
+      const int lit = *p;
+      if (lit)
+	{
+	  Gate *g = PEEK (c->inputs, abs (lit) - 1);
+	  assert (g);
+	  if (lit < 0)
+	    g = NOT (g);
+	  PUSH (disjuncts, g);
+	}
+      else
+	{
+	  PUSH (conjuncts, new_hashed_gate (c, OR_OPERATOR, &disjuncts));
+	  CLEAR (disjuncts);
+	}
+    }
+  Gate *res = new_hashed_gate (c, AND_OPERATOR, &conjuncts);
+  RELEASE (conjuncts);
+  RELEASE (disjuncts);
+  return res;
+}
+
 Circuit *
 parse_dimacs (Reader * r, Symbols * symbols, IntStack ** relevant_ptr)
 {
@@ -238,22 +269,21 @@ parse_dimacs (Reader * r, Symbols * symbols, IntStack ** relevant_ptr)
       assert (g->input == g->idx);
       symbol->gate = g;
     }
-  STACK (Gate *) clauses, clause;
+  IntStack clauses;
   INIT (clauses);
-  INIT (clause);
+  long parsed = 0, size = 0;
   ch = next_non_white_space_char (r);
   for (;;)
     {
       if (ch.code == EOF)
 	{
-	  if (!EMPTY (clause))
+	  if (size)
 	    parse_error (r, ch, "end-of-file without '0' after last clause");
-	  if (COUNT (clauses) == t - 1)
+	  if (parsed == t - 1)
 	    parse_error (r, ch, "single clause missing");
-	  if (COUNT (clauses) < t)
-	    parse_error (r, ch,
-			 "%ld clauses missing", (long) (t - COUNT (clauses)));
-	  assert (COUNT (clauses) == t);
+	  if (parsed < t)
+	    parse_error (r, ch, "%ld clauses missing", t - parsed);
+	  assert (parsed == t);
 	  break;
 	}
       int sign = 0;
@@ -284,38 +314,22 @@ parse_dimacs (Reader * r, Symbols * symbols, IntStack ** relevant_ptr)
 	}
       if (i > s)
 	parse_error (r, start, "maximum variable index %d exceeded", s);
-      assert (COUNT (clauses) <= t);
-      if (COUNT (clauses) == t)
+      assert (parsed <= t);
+      if (parsed == t)
 	parse_error (r, ch, "more clauses than specified");
 #ifndef NLOG
-      if (EMPTY (clause))
-	LOG ("start clause %ld", 1 + COUNT (clauses));
+      if (!size)
+	LOG ("start clause %ld", parsed + 1);
 #endif
+      PUSH (clauses, sign ? -i : i);
       if (i)
-	{
-	  Gate *g = PEEK (res->inputs, i - 1);
-	  assert (g);
-	  if (sign)
-	    g = NOT (g);
-	  PUSH (clause, g);
-	}
+	size++;
       else
 	{
-	  Gate *g;
-	  if (EMPTY (clause))
-	    g = new_false_gate (res);
-	  else if (COUNT (clause) == 1)
-	    g = PEEK (clause, 0);
-	  else
-	    {
-	      g = new_or_gate (res);
-	      for (Gate ** p = clause.start; p < clause.top; p++)
-		connect_gates (*p, g);
-	    }
-	  CLEAR (clause);
-	  PUSH (clauses, g);
+	  parsed++;
+	  size = 0;
 #ifndef NLOG
-	  LOG ("end clause %ld", COUNT (clauses));
+	  LOG ("end clause %ld", parsed);
 #endif
 	}
       if (ch.code != EOF)
@@ -326,18 +340,11 @@ parse_dimacs (Reader * r, Symbols * symbols, IntStack ** relevant_ptr)
 	  ch = next_non_white_space_char (r);
 	}
     }
-  RELEASE (clause);
   Gate *g;
-  if (EMPTY (clauses))
-    g = NOT (new_false_gate (res));
-  else if (COUNT (clauses) == 1)
-    g = PEEK (clauses, 0);
+  if (options.gates)
+    g = extract_gates (res, &clauses);
   else
-    {
-      g = new_and_gate (res);
-      for (Gate ** p = clauses.start; p < clauses.top; p++)
-	connect_gates (*p, g);
-    }
+    g = conjunction_of_clauses (res, &clauses);
   RELEASE (clauses);
   connect_output (res, g);
   return res;
@@ -7,12 +7,22 @@ struct Elm
   CNF *cnf;
   int frozen, max_var, original, eliminated;
   signed char *marks;
+  char *xors;			// occurs in native XOR constraint
   IntStack schedule;
   IntStack clause;
   Clauses *occs;
   int *score;
 };
 
+// Variables up to 'frozen' (the inputs) and variables occurring in native
+// XOR constraints can not be eliminated (only clauses are resolved).
+
+static int
+frozen_variable (Elm * elm, int idx)
+{
+  return idx <= elm->frozen || elm->xors[idx];
+}
+
 static void
 score_elimination_clause (Elm * elm, Clause * c)
 {
@@ -23,7 +33,7 @@ score_elimination_clause (Elm * elm, Clause * c)
   for (int i = 0; i < c->size; i++)
     {
       const int lit = c->literals[i], idx = abs (lit);
-      if (idx <= elm->frozen)
+      if (frozen_variable (elm, idx))
 	continue;
       if (c->size > options.elimclslim)
 	elm->score[idx] = INT_MAX;
@@ -42,7 +52,7 @@ connect_elimination_clause (Elm * elm, Clause * c)
   for (int i = 0; i < c->size; i++)
     {
       const int lit = c->literals[i], idx = abs (lit);
-      if (idx <= elm->frozen)
+      if (frozen_variable (elm, idx))
 	continue;
       if (elm->score[idx] == INT_MAX)
 	continue;
@@ -63,7 +73,7 @@ original_non_frozen_variables (Elm * elm)
       for (int i = 0; i < c->size; i++)
 	{
 	  const int lit = c->literals[i], idx = abs (lit);
-	  if (idx <= elm->frozen)
+	  if (frozen_variable (elm, idx))
 	    continue;
 	  if (elm->marks[idx])
 	    continue;
@@ -89,6 +99,10 @@ new_elimination (CNF * cnf, int frozen)
   elm->occs += elm->max_var;
   ALLOC (elm->score, elm->max_var + 1);
   ALLOC (elm->marks, elm->max_var + 1);
+  ALLOC (elm->xors, elm->max_var + 1);
+  for (Clause ** p = cnf->xors.start; p != cnf->xors.top; p++)
+    for (int i = 0; i < (*p)->size; i++)
+      elm->xors[abs ((*p)->literals[i])] = 1;
   elm->original = original_non_frozen_variables (elm);
   return elm;
 }
@@ -102,6 +116,7 @@ delete_elimination (Elm * elm)
   DEALLOC (elm->occs, 2 * (elm->max_var + 1));
   DEALLOC (elm->score, elm->max_var + 1);
   DEALLOC (elm->marks, elm->max_var + 1);
+  DEALLOC (elm->xors, elm->max_var + 1);
   RELEASE (elm->schedule);
   RELEASE (elm->clause);
   DELETE (elm);
@@ -165,7 +180,7 @@ eliminate_variable (Elm * elm, int pivot)
     return 0;
 
   LOG ("trying to eliminate %d", pivot);
-  assert (pivot > elm->frozen);
+  assert (!frozen_variable (elm, pivot));
   stats.pivots++;
 
   int resolvents = 0;
@@ -335,7 +350,7 @@ schedule_elimination (Elm * elm)
   for (int i = 1; i <= elm->max_var; i++)
     {
       const int score = elm->score[i];
-      if (i <= elm->frozen)
+      if (frozen_variable (elm, i))
 	{
 	  LOG ("ignoring frozen variable %d", i);
 	}
@@ -6,7 +6,12 @@ struct Encoder
 {
   CNF *cnf;
   Circuit *circuit;
+  Compact *compact;
+  LUT *luts;
+  int polarity, negated, shared;
     STACK (int) clause, marks;
+  Visits gates, roots;
+  UnsignedStack cubes;
 };
 
 Gate *
@@ -76,33 +81,50 @@ print_dimacs_encoding (Circuit * circuit)
   print_dimacs_encoding_to_file (circuit, stdout);
 }
 
+// A negated circuit pointer is a view of the dual circuit (see
+// 'dual_operator'), which is encoded as negation of the circuit.  The
+// gates are traversed and their variables stored in the compact form.
+
 static Encoder *
 new_encoder (Circuit * circuit, CNF * cnf)
 {
   Encoder *res;
   NEW (res);
-  res->circuit = circuit;
+  res->circuit = STRIP (circuit);
+  res->compact = compact_circuit (res->circuit);
   res->cnf = cnf;
+  res->polarity = options.polarity;
+  res->negated = SIGN (circuit);
   return res;
 }
 
+// With '--lut' gates are encoded as LUTs of a mapping (see 'lut.c'),
+// except in miters, where the cones of the gates are reset afterwards.
+
+static void
+map_luts_of_encoder (Encoder * e)
+{
+  if (options.lut)
+    e->luts = lut_mapping (e->circuit);
+}
+
 static void
 delete_encoder (Encoder * e)
 {
   RELEASE (e->clause);
   RELEASE (e->marks);
+  RELEASE (e->gates);
+  RELEASE (e->roots);
+  RELEASE (e->cubes);
   DELETE (e);
 }
 
 static int
-map_gate (Gate * g, Encoder * e)
+map_literal (unsigned lit, Encoder * e)
 {
-  int sign = SIGN (g);
-  if (sign)
-    g = NOT (g);
-  int res = g->code;
+  int res = e->compact->code[COMPACT_GATE (lit)];
   assert (res);
-  if (sign)
+  if (COMPACT_SIGN (lit))
     res = -res;
   return res;
 }
@@ -208,29 +230,54 @@ encode_ternary (Encoder * e, int a, int b, int c)
 }
 
 static int
-map_input (Gate * g, int input, Encoder * e)
+gate_size (unsigned g, Encoder * e)
 {
-  return map_gate (get_gate_input (g, input), e);
+  const Compact *compact = e->compact;
+  return compact->first_input[g + 1] - compact->first_input[g];
+}
+
+static unsigned *
+gate_inputs (unsigned g, Encoder * e)
+{
+  return e->compact->inputs + e->compact->first_input[g];
+}
+
+static int
+map_input (unsigned g, int input, Encoder * e)
+{
+  assert (0 <= input && input < gate_size (g, e));
+  return map_literal (gate_inputs (g, e)[input], e);
 }
 
 static void
-encode_false (Gate * g, Encoder * e)
+encode_false (unsigned g, Encoder * e)
 {
-  int lit = map_gate (g, e);
-  LOG ("encoding FALSE gate %d with literal %d", g->idx, lit);
+  int lit = e->compact->code[g];
+  LOG ("encoding FALSE gate %u with literal %d", g, lit);
   encode_unary (e, -lit);
 }
 
-static void
-encode_and (Gate * g, Encoder * e)
+// Gates occurring only positively need only one direction of their
+// definition.  If the negation of the circuit is encoded (see below) these
+// gates occur only negatively, and the other direction is needed instead.
+
+static int
+only_positive (unsigned g, Encoder * e)
 {
-  const int n = get_gate_size (g);
-  int lit = map_gate (g, e);
-  LOG ("encoding %d-ary AND gate %d with literal %d", n, g->idx, lit);
-  for (int i = 0; i < n; i++)
-    encode_binary (e, -lit, map_input (g, i, e));
+  return e->polarity && e->compact->polarity[g] == 1;
+}
+
+static void
+encode_and (unsigned g, Encoder * e)
+{
+  const int n = gate_size (g, e);
+  int lit = e->compact->code[g];
+  LOG ("encoding %d-ary AND gate %u with literal %d", n, g, lit);
+  if (!e->negated || !only_positive (g, e))
+    for (int i = 0; i < n; i++)
+      encode_binary (e, -lit, map_input (g, i, e));
   assert (EMPTY (e->clause));
-  if (options.polarity && g->pos && !g->neg)
+  if (!e->negated && only_positive (g, e))
     return;
   PUSH (e->clause, lit);
   for (int i = 0; i < n; i++)
@@ -238,13 +285,39 @@ encode_and (Gate * g, Encoder * e)
   encode_clause (e);
 }
 
+// With '--xor' the gate 'lit = a_1 ^ ... ^ a_n' becomes the single native
+// constraint '!lit ^ a_1 ^ ... ^ a_n', which the solver propagates with
+// Gauss-Jordan elimination.  An n-ary XNOR gate is the XOR of its inputs
+// negated if 'n' is even (as in the chain encoding below), which keeps
+// 'lit' positive instead.
+
 static void
-encode_xor (Gate * g, Encoder * e)
+encode_native_xor (unsigned g, Encoder * e, int lit)
 {
-  int n = COUNT (g->inputs);
+  const int n = gate_size (g, e);
+  assert (EMPTY (e->clause));
+  PUSH (e->clause, lit);
+  for (int i = 0; i < n; i++)
+    PUSH (e->clause, map_input (g, i, e));
+  Clause *c = new_clause (e->clause.start, n + 1);
+  c->dual = e->cnf->dual;
+  LOGCLS (c, "encoded new XOR");
+  add_xor_to_cnf (c, e->cnf);
+  CLEAR (e->clause);
+}
+
+static void
+encode_xor (unsigned g, Encoder * e)
+{
+  int n = gate_size (g, e);
   assert (n > 1);
-  int mapped = g->code;
-  LOG ("encoding %d-ary XOR gate %d with literal %d", n, g->idx, mapped);
+  int mapped = e->compact->code[g];
+  LOG ("encoding %d-ary XOR gate %u with literal %d", n, g, mapped);
+  if (options.xor)
+    {
+      encode_native_xor (g, e, -mapped);
+      return;
+    }
   int idx = mapped - (n - 1);
   int a = map_input (g, 0, e);
   for (int i = 1; i < n; i++)
@@ -261,28 +334,31 @@ encode_xor (Gate * g, Encoder * e)
 }
 
 static void
-encode_or (Gate * g, Encoder * e)
+encode_or (unsigned g, Encoder * e)
 {
-  const int n = get_gate_size (g);
-  int lit = map_gate (g, e);
-  LOG ("encoding %d-ary OR gate %d with literal %d", n, g->idx, lit);
+  const int n = gate_size (g, e);
+  int lit = e->compact->code[g];
+  LOG ("encoding %d-ary OR gate %u with literal %d", n, g, lit);
   assert (EMPTY (e->clause));
-  PUSH (e->clause, -lit);
-  for (int i = 0; i < n; i++)
-    PUSH (e->clause, map_input (g, i, e));
-  encode_clause (e);
-  if (options.polarity && g->pos && !g->neg)
+  if (!e->negated || !only_positive (g, e))
+    {
+      PUSH (e->clause, -lit);
+      for (int i = 0; i < n; i++)
+	PUSH (e->clause, map_input (g, i, e));
+      encode_clause (e);
+    }
+  if (!e->negated && only_positive (g, e))
     return;
   for (int i = 0; i < n; i++)
     encode_binary (e, lit, -map_input (g, i, e));
 }
 
 static void
-encode_ite (Gate * g, Encoder * e)
+encode_ite (unsigned g, Encoder * e)
 {
-  assert (COUNT (g->inputs) == 3);
-  int lit = map_gate (g, e);
-  LOG ("encoding 3-ary ITE gate %d as literal %d", g->idx, lit);
+  assert (gate_size (g, e) == 3);
+  int lit = e->compact->code[g];
+  LOG ("encoding 3-ary ITE gate %u as literal %d", g, lit);
   int cond = map_input (g, 0, e);
   int pos = map_input (g, 1, e);
   int neg = map_input (g, 2, e);
@@ -293,12 +369,17 @@ encode_ite (Gate * g, Encoder * e)
 }
 
 static void
-encode_xnor (Gate * g, Encoder * e)
+encode_xnor (unsigned g, Encoder * e)
 {
-  int n = COUNT (g->inputs);
+  int n = gate_size (g, e);
   assert (n > 1);
-  int mapped = g->code;
-  LOG ("encoding %d-ary XNOR gate %d with literal %d", n, g->idx, mapped);
+  int mapped = e->compact->code[g];
+  LOG ("encoding %d-ary XNOR gate %u with literal %d", n, g, mapped);
+  if (options.xor)
+    {
+      encode_native_xor (g, e, (n & 1) ? -mapped : mapped);
+      return;
+    }
   int idx = mapped - (n - 1);
   int a = map_input (g, 0, e);
   for (int i = 1; i < n; i++)
@@ -314,10 +395,63 @@ encode_xnor (Gate * g, Encoder * e)
   assert (a == mapped);
 }
 
+// The clauses of a LUT 'lit = f (leaves)' are obtained from irredundant
+// covers of 'f' and its negation.  Each cube 'c' of the cover of 'f' gives
+// the clause 'lit | !c' and each cube of the cover of '!f' the clause
+// '!lit | !c'.  Since covers of unate functions are unate, the polarity
+// based encoding stays sound.
+
+static int
+mapped_gate (unsigned g, Encoder * e)
+{
+  return e->luts && e->luts[g].mapped;
+}
+
 static void
-encode_gate (Gate * g, Encoder * e)
+encode_cover (Encoder * e, int lit, uint64_t f, const LUT * lut)
 {
-  switch (g->op)
+  CLEAR (e->cubes);
+  cover_lut_function (f, lut->size, &e->cubes);
+  for (const unsigned *p = e->cubes.start; p != e->cubes.top; p++)
+    {
+      const unsigned cube = *p;
+      assert (EMPTY (e->clause));
+      PUSH (e->clause, lit);
+      for (unsigned i = 0; i < lut->size; i++)
+	{
+	  const int leaf = e->compact->code[lut->leaves[i]];
+	  assert (leaf);
+	  if (LUT_POSITIVE (cube, i))
+	    PUSH (e->clause, -leaf);
+	  else if (LUT_NEGATIVE (cube, i))
+	    PUSH (e->clause, leaf);
+	}
+      encode_clause (e);
+    }
+}
+
+static void
+encode_lut (unsigned g, Encoder * e)
+{
+  const LUT *lut = e->luts + g;
+  int lit = e->compact->code[g];
+  LOG ("encoding %u-input LUT gate %u with literal %d", lut->size, g, lit);
+  if (!e->negated || !only_positive (g, e))
+    encode_cover (e, -lit, ~lut->function, lut);
+  if (!e->negated && only_positive (g, e))
+    return;
+  encode_cover (e, lit, lut->function, lut);
+}
+
+static void
+encode_gate (unsigned g, Encoder * e)
+{
+  if (mapped_gate (g, e))
+    {
+      encode_lut (g, e);
+      return;
+    }
+  switch (e->compact->ops[g])
     {
     case FALSE_OPERATOR:
       encode_false (g, e);
@@ -354,142 +488,393 @@ encode_inputs (Encoder * e)
       assert (g);
       assert (!SIGN (g));
       assert (g->op == INPUT_OPERATOR);
-      assert (!g->code);
+      assert (!e->compact->code[g->idx]);
       const int idx = encode_input (c, g);
       if (idx > res)
 	res = idx;
-      g->code = idx;
+      e->compact->code[g->idx] = idx;
     }
   assert (res == COUNT (c->inputs));
   msg (2, "encoded %d inputs", res);
   return res;
 }
 
+// Inputs of mapped gates are the leaves of their LUT.
+
 static int
-encode_gates (Encoder * encoder, Gate * g, int idx)
+encoded_size (unsigned g, Encoder * e)
 {
-  g = STRIP (g);
-  if (g->code)
+  return mapped_gate (g, e) ? (int) e->luts[g].size : gate_size (g, e);
+}
+
+static unsigned
+encoded_input (unsigned g, int input, Encoder * e)
+{
+  assert (0 <= input && input < encoded_size (g, e));
+  if (mapped_gate (g, e))
+    return COMPACT_LITERAL (e->luts[g].leaves[input], 0);
+  return gate_inputs (g, e)[input];
+}
+
+// Gates are encoded in post-order of a depth-first traversal of their
+// inputs, i.e., inputs are always encoded before the gate.
+
+static int
+encode_gates (Encoder * encoder, unsigned lit, int idx)
+{
+  Compact *compact = encoder->compact;
+  Visits *visits = &encoder->gates;
+  assert (EMPTY (*visits));
+  if (compact->code[COMPACT_GATE (lit)])
     return idx;
-  for (Gate ** p = g->inputs.start; p < g->inputs.top; p++)
-    idx = encode_gates (encoder, *p, idx);
-  if (g->op == XOR_OPERATOR || g->op == XNOR_OPERATOR)
+  push_visit (visits, COMPACT_GATE (lit));
+  while (!EMPTY (*visits))
     {
-      const int n = COUNT (g->inputs);
-      if (n > 2)
+      Visit *visit = visits->top - 1;
+      const unsigned g = visit->lit;
+      const int n = encoded_size (g, encoder);
+      if (visit->next < (unsigned) n)
+	{
+	  const unsigned input = encoded_input (g, visit->next++, encoder);
+	  const unsigned h = COMPACT_GATE (input);
+	  if (!compact->code[h])
+	    push_visit (visits, h);
+	  continue;
+	}
+      visits->top--;
+      const Operator op = compact->ops[g];
+      if (!mapped_gate (g, encoder) && !options.xor &&
+	  (op == XOR_OPERATOR || op == XNOR_OPERATOR))
 	{
-	  LOG ("reserving additional %d variables for %d-ary %s",
-	       n - 2, n, (g->op == XOR_OPERATOR ? "XOR" : "XNOR"));
-	  idx += n - 2;
+	  if (n > 2)
+	    {
+	      LOG ("reserving additional %d variables for %d-ary %s",
+		   n - 2, n, (op == XOR_OPERATOR ? "XOR" : "XNOR"));
+	      idx += n - 2;
+	    }
 	}
+      compact->code[g] = ++idx;
+      encode_gate (g, encoder);
     }
-  g->code = ++idx;
-  encode_gate (g, encoder);
   return idx;
 }
 
+// The root of the negated circuit is the negated output, where AND and OR
+// are exchanged following De Morgan, and root literals are negated.
+
 static int
-encode_root (Encoder * encoder, Gate * g, int idx)
+map_root (unsigned lit, Encoder * e)
 {
-  const int sign = SIGN (g), bit = 1 << sign;
-  Gate *h = sign ? NOT (g) : g;
-  if (h->root & bit)
+  const int res = map_literal (lit, e);
+  return e->negated ? -res : res;
+}
+
+static Operator
+root_operator (unsigned g, Encoder * e)
+{
+  const Operator op = e->compact->ops[g];
+  if (!e->negated)
+    return op;
+  if (op == AND_OPERATOR)
+    return OR_OPERATOR;
+  if (op == OR_OPERATOR)
+    return AND_OPERATOR;
+  return op;
+}
+
+static int
+encode_root (Encoder * encoder, unsigned lit, int idx)
+{
+  Compact *compact = encoder->compact;
+  const int sign = COMPACT_SIGN (lit), bit = 1 << sign;
+  const unsigned g = COMPACT_GATE (lit);
+  if (compact->root[g] & bit)
     return idx;
-  h->root |= bit;
-  LOG ("%sroot %" PRz "-ary %s gate",
-       sign ? "negated " : "", COUNT (h->inputs), gate_name (h));
-  if (!h->code)
-    idx = encode_gates (encoder, h, idx);
-  encode_unary (encoder, map_gate (g, encoder));
+  compact->root[g] |= bit;
+  LOG ("%sroot %d-ary %s gate %u", sign ? "negated " : "",
+       gate_size (g, encoder),
+       gate_name (PEEK (encoder->circuit->gates, g)), g);
+  if (!compact->code[g])
+    idx = encode_gates (encoder, lit, idx);
+  if (!encoder->shared)
+    encode_unary (encoder, map_root (lit, encoder));
   return idx;
 }
 
+// Roots are split along conjunctions (in depth-first order), while
+// disjunctions of roots become one clause.
+
 static int
-encode_roots (Encoder * encoder, Gate * g, int idx)
+encode_or_root (Encoder * encoder, unsigned g, int idx)
 {
-  const int sign = SIGN (g);
-  if (!sign && g->op == AND_OPERATOR)
+  const int n = gate_size (g, encoder);
+  const unsigned *inputs = gate_inputs (g, encoder);
+  assert (EMPTY (encoder->clause));
+  for (int i = 0; i < n; i++)
+    idx = encode_gates (encoder, inputs[i], idx);
+  if (encoder->shared)
+    return idx;
+  for (int i = 0; i < n; i++)
     {
-      if (g->root & 1)
-	return idx;
-      for (Gate ** p = g->inputs.start; p < g->inputs.top; p++)
-	idx = encode_roots (encoder, *p, idx);
-      g->root |= 1;
+      const int root = map_root (inputs[i], encoder);
+      PUSH (encoder->clause, root);
     }
-  else if (!sign && g->op == OR_OPERATOR)
+  encode_clause (encoder);
+  return idx;
+}
+
+static int
+encode_roots (Encoder * encoder, unsigned lit, int idx)
+{
+  Compact *compact = encoder->compact;
+  Visits *visits = &encoder->roots;
+  assert (EMPTY (*visits));
+  push_visit (visits, lit);
+  while (!EMPTY (*visits))
     {
-      if (g->root & 1)
-	return idx;
-      assert (EMPTY (encoder->clause));
-      for (Gate ** p = g->inputs.start; p < g->inputs.top; p++)
-	idx = encode_gates (encoder, *p, idx);
-      for (Gate ** p = g->inputs.start; p < g->inputs.top; p++)
+      Visit *visit = visits->top - 1;
+      lit = visit->lit;
+      const unsigned g = COMPACT_GATE (lit);
+      const Operator op = root_operator (g, encoder);
+      if (COMPACT_SIGN (lit) || (op != AND_OPERATOR && op != OR_OPERATOR))
 	{
-	  const int lit = map_gate (*p, encoder);
-	  PUSH (encoder->clause, lit);
+	  visits->top--;
+	  idx = encode_root (encoder, lit, idx);
+	  continue;
 	}
-      encode_clause (encoder);
-      g->root |= 1;
+      if (!visit->next && (compact->root[g] & 1))
+	{
+	  visits->top--;
+	  continue;
+	}
+      const unsigned n = gate_size (g, encoder);
+      if (op == AND_OPERATOR && visit->next < n)
+	{
+	  const unsigned input = gate_inputs (g, encoder)[visit->next++];
+	  push_visit (visits, input);
+	  continue;
+	}
+      visits->top--;
+      if (op == OR_OPERATOR)
+	idx = encode_or_root (encoder, g, idx);
+      compact->root[g] |= 1;
     }
-  else
-    idx = encode_root (encoder, g, idx);
   return idx;
 }
 
 static void
-reset_code_root_fields_of_circuit (Circuit * c)
+reset_codes_and_roots (Encoder * e)
 {
-  LOG ("resetting code and root fields of circuit");
-  for (Gate ** p = c->gates.start; p < c->gates.top; p++)
-    {
-      Gate *g = *p;
-      g->code = g->root = 0;
-    }
+  LOG ("resetting codes and roots of circuit");
+  Compact *compact = e->compact;
+  memset (compact->code, 0, compact->num_gates * sizeof *compact->code);
+  memset (compact->root, 0, compact->num_gates);
 }
 
 void
 encode_circuit (Circuit * circuit, CNF * cnf)
 {
-  cone_of_influence (circuit);
   Encoder *encoder = new_encoder (circuit, cnf);
-  reset_code_root_fields_of_circuit (circuit);
+  Circuit *c = encoder->circuit;
+  cone_of_influence (c);
+  map_luts_of_encoder (encoder);
+  reset_codes_and_roots (encoder);
   int inputs = encode_inputs (encoder);
   LOG ("starting to encode roots");
-  int idx = encode_roots (encoder, circuit->output, inputs);
+  int idx = encode_roots (encoder, compact_output (c), inputs);
   delete_encoder (encoder);
   msg (2, "encoded %d inputs and gates in total", idx);
 }
 
+// Encodes the cones of 'a' and 'b' without using polarities and adds the
+// clauses of 'a != b', i.e., the CNF is satisfiable iff the two gates are
+// not equivalent.  The codes of the cones are reset afterwards, so the
+// same circuit can be encoded many times.
+
+static void
+reset_codes_of_cone (Encoder * e, unsigned lit)
+{
+  Visits *visits = &e->gates;
+  assert (EMPTY (*visits));
+  push_visit (visits, COMPACT_GATE (lit));
+  while (!EMPTY (*visits))
+    {
+      const unsigned g = (--visits->top)->lit;
+      if (!e->compact->code[g])
+	continue;
+      e->compact->code[g] = 0;
+      const int n = gate_size (g, e);
+      const unsigned *inputs = gate_inputs (g, e);
+      for (int i = 0; i < n; i++)
+	push_visit (visits, COMPACT_GATE (inputs[i]));
+    }
+}
+
+void
+encode_miter (Circuit * circuit, Gate * a, Gate * b, CNF * cnf)
+{
+  Encoder *encoder = new_encoder (circuit, cnf);
+  encoder->polarity = 0;
+  const unsigned lit_a = compact_literal (a), lit_b = compact_literal (b);
+  int idx = encode_inputs (encoder);
+  idx = encode_gates (encoder, lit_a, idx);
+  idx = encode_gates (encoder, lit_b, idx);
+  const int mapped_a = map_literal (lit_a, encoder);
+  const int mapped_b = map_literal (lit_b, encoder);
+  encode_binary (encoder, mapped_a, mapped_b);
+  encode_binary (encoder, -mapped_a, -mapped_b);
+  LOG ("encoded miter with %d variables", idx);
+  reset_codes_of_cone (encoder, lit_a);
+  reset_codes_of_cone (encoder, lit_b);
+  for (Gate ** p = circuit->inputs.start; p < circuit->inputs.top; p++)
+    encoder->compact->code[(*p)->idx] = 0;
+  delete_encoder (encoder);
+}
+
+// Either circuit might be a view of the dual of the other one.  Then the
+// gates are encoded a second time with fresh variables.  The dual gate
+// variables can not simply be shared with the primal ones (with flipped
+// polarity), since the solver requires private primal and dual variables.
+// Values propagated on one side depend on the root constraints of that
+// side and would be unsound on the other side.
+
 void
-encode_circuits (Circuit * c, Circuit * d, CNF * f, CNF * g)
+encode_circuits (Circuit * first_circuit, Circuit * second_circuit,
+		 CNF * f, CNF * g)
 {
+  Circuit *c = STRIP (first_circuit), *d = STRIP (second_circuit);
   assert (COUNT (c->inputs) == COUNT (d->inputs));
   LOG ("starting to encode first circuit");
   cone_of_influence (c);
-  Encoder *encoder = new_encoder (c, f);
-  reset_code_root_fields_of_circuit (c);
+  Encoder *encoder = new_encoder (first_circuit, f);
+  map_luts_of_encoder (encoder);
+  reset_codes_and_roots (encoder);
   int inputs1 = encode_inputs (encoder);
   LOG ("starting to encode roots of first circuit");
-  int first = encode_roots (encoder, c->output, inputs1);
+  int first = encode_roots (encoder, compact_output (c), inputs1);
   assert (first >= inputs1);
   delete_encoder (encoder);
   msg (2, "encoded %d gates of first circuit", first - inputs1);
   LOG ("starting to encode second circuit");
-  encoder = new_encoder (d, g);
-  reset_code_root_fields_of_circuit (d);
+  encoder = new_encoder (second_circuit, g);
+  map_luts_of_encoder (encoder);
+  reset_codes_and_roots (encoder);
   int inputs2 = encode_inputs (encoder);
   assert (inputs1 == inputs2), (void) inputs2;
   LOG ("starting to encode roots of second circuit");
-  int second = encode_roots (encoder, d->output, first);
+  int second = encode_roots (encoder, compact_output (d), first);
   assert (second >= first);
   delete_encoder (encoder);
   msg (2, "encoded %d gates of second circuit", second - first);
   msg (2, "encoded %d inputs and gates in total", second);
 }
 
+// The gates of a circuit with several outputs (see 'solve_outputs' in
+// 'main.c') are encoded once for the cones of all outputs, i.e., with the
+// union of their polarities.  Roots are traversed as above, in order to
+// encode the same gates, but without adding root clauses.  Afterwards only
+// the root clauses of the selected output are added to the shared CNFs.
+// Gates outside of the cone of the selected output are unconstrained
+// definitions, which do not change the projection on the inputs.
+
+struct Encoding
+{
+  Circuit *circuits[2];
+  CNF *cnfs[2];
+  int *codes[2];
+  int vars[2];
+};
+
+Encoding *
+encode_shared_gates (Circuit * first_circuit, Circuit * second_circuit)
+{
+  Encoding *res;
+  NEW (res);
+  res->circuits[0] = first_circuit;
+  res->circuits[1] = second_circuit;
+  Circuit *c = STRIP (first_circuit);
+  assert (!second_circuit || STRIP (second_circuit) == c);
+  cone_of_influence (c);
+  int idx = 0;
+  for (int i = 0; i < 2; i++)
+    {
+      if (!res->circuits[i])
+	continue;
+      CNF *cnf = res->cnfs[i] = new_cnf (i);
+      Encoder *encoder = new_encoder (res->circuits[i], cnf);
+      encoder->shared = 1;
+      map_luts_of_encoder (encoder);
+      reset_codes_and_roots (encoder);
+      const int inputs = encode_inputs (encoder);
+      if (!i)
+	idx = inputs;
+      if (EMPTY (c->outputs))
+	idx = encode_roots (encoder, compact_output (c), idx);
+      else
+	for (Gate ** p = c->outputs.start; p != c->outputs.top; p++)
+	  idx = encode_roots (encoder, compact_literal (*p), idx);
+      const unsigned n = encoder->compact->num_gates;
+      ALLOC (res->codes[i], n);
+      memcpy (res->codes[i], encoder->compact->code,
+	      n * sizeof *res->codes[i]);
+      res->vars[i] = idx;
+      delete_encoder (encoder);
+      msg (1, "shared %s CNF with %ld clauses", i ? "dual" : "primal",
+	   cnf->irredundant);
+    }
+  msg (2, "encoded %d inputs and shared gates in total", idx);
+  return res;
+}
+
+// Moves the shared CNFs to the caller after adding the root clauses of
+// the current output of the circuit, thus can only be called once.
+
+void
+encode_shared_roots (Encoding * e, CNF ** first, CNF ** second)
+{
+  CNF **cnfs[2] = { first, second };
+  for (int i = 0; i < 2; i++)
+    {
+      assert (!cnfs[i] == !e->circuits[i]);
+      if (!e->circuits[i])
+	continue;
+      assert (e->cnfs[i]);
+      Encoder *encoder = new_encoder (e->circuits[i], e->cnfs[i]);
+      map_luts_of_encoder (encoder);
+      Compact *compact = encoder->compact;
+      memcpy (compact->code, e->codes[i],
+	      compact->num_gates * sizeof *compact->code);
+      memset (compact->root, 0, compact->num_gates);
+      LOG ("starting to encode roots of shared %s CNF",
+	   i ? "dual" : "primal");
+      const int idx =
+	encode_roots (encoder, compact_output (encoder->circuit), e->vars[i]);
+      assert (idx == e->vars[i]), (void) idx;
+      delete_encoder (encoder);
+      *cnfs[i] = e->cnfs[i];
+      e->cnfs[i] = 0;
+    }
+}
+
+void
+delete_encoding (Encoding * e)
+{
+  for (int i = 0; i < 2; i++)
+    {
+      if (!e->circuits[i])
+	continue;
+      if (e->cnfs[i])
+	delete_cnf (e->cnfs[i]);
+      Compact *compact = compact_circuit (STRIP (e->circuits[i]));
+      DEALLOC (e->codes[i], compact->num_gates);
+    }
+  DELETE (e);
+}
+
 void
-get_encoded_inputs (Circuit * c, IntStack * s)
+get_encoded_inputs (Circuit * circuit, IntStack * s)
 {
+  Circuit *c = STRIP (circuit);
   for (Gate ** p = c->inputs.start; p < c->inputs.top; p++)
     PUSH (*s, encode_input (c, *p));
   LOG ("found %ld encoded inputs", (long) COUNT (*s));
@@ -6,4 +6,11 @@ void print_dimacs_encoding (Circuit *);
 
 void encode_circuit (Circuit *, CNF *);
 void encode_circuits (Circuit *, Circuit *, CNF *, CNF *);
+void encode_miter (Circuit *, Gate *, Gate *, CNF *);
 void get_encoded_inputs (Circuit *, IntStack *);
+
+typedef struct Encoding Encoding;
+
+Encoding *encode_shared_gates (Circuit *, Circuit *);
+void encode_shared_roots (Encoding *, CNF **, CNF **);
+void delete_encoding (Encoding *);
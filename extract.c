@@ -0,0 +1,664 @@
+#include "headers.h"
+
+/*------------------------------------------------------------------------*/
+// Definitions of variables are found by pattern matching of the clauses
+// of AND, XOR and ITE gates and otherwise semantically, by checking that
+// the clauses of a variable with at most six other variables determine its
+// value, in which case its function is given by a truth table.  A clause
+// is used in at most one definition.  Defined variables remain inputs of
+// the circuit, tied to the gate of their definition by an equivalence,
+// while all other occurrences are replaced by the gate.  Thus the result
+// has the same models over the same inputs and cyclic definitions simply
+// refer to the input gate of the variable (see 'build_definitions').
+
+#define MAX_XOR_SIZE 5
+#define MAX_SEMANTIC_CLAUSES 32
+
+typedef struct Definition Definition;
+
+struct Definition
+{
+  Operator op;			// 'OR_OPERATOR' for semantic definitions
+  int negate;
+  IntStack inputs;		// literals (variables if semantic)
+  uint64_t function;		// truth table of semantic definitions
+};
+
+typedef struct Extractor Extractor;
+
+struct Extractor
+{
+  Circuit *circuit;
+  int num_vars;
+  IntStack literals;		// zero terminated normalized clauses
+  IntStack clauses;		// start of clause in 'literals'
+  IntStack sizes;		// size of clause
+  IntStack *occs;		// clauses of literal
+  char *used;			// clause used in definition
+  char *marks;			// marked literals
+  char *state;			// visited variables while building
+  Definition *definitions;
+  Gate **gates;			// gate of variable
+  IntStack defining;		// clauses of last found definition
+  struct
+  {
+    int ands, xors, ites, semantic;
+  } found;
+};
+
+enum
+{
+  UNVISITED = 0,
+  BUSY = 1,
+  BUILT = 2,
+};
+
+static unsigned
+literal_index (int lit)
+{
+  return 2u * (unsigned) abs (lit) + (lit < 0);
+}
+
+static IntStack *
+occurrences (Extractor * e, int lit)
+{
+  return e->occs + literal_index (lit);
+}
+
+static const int *
+clause_literals (Extractor * e, int c)
+{
+  return e->literals.start + PEEK (e->clauses, c);
+}
+
+static int
+clause_size (Extractor * e, int c)
+{
+  return PEEK (e->sizes, c);
+}
+
+static void
+mark_literal (Extractor * e, int lit)
+{
+  e->marks[literal_index (lit)] = 1;
+}
+
+static void
+unmark_literal (Extractor * e, int lit)
+{
+  e->marks[literal_index (lit)] = 0;
+}
+
+static int
+marked_literal (Extractor * e, int lit)
+{
+  return e->marks[literal_index (lit)];
+}
+
+static Gate *
+input_gate (Extractor * e, int idx)
+{
+  assert (0 < idx && idx <= e->num_vars);
+  return PEEK (e->circuit->inputs, idx - 1);
+}
+
+/*------------------------------------------------------------------------*/
+
+// Literals of clauses are sorted by variable.  Duplicated literals are
+// removed and tautological clauses are skipped.
+
+static int
+cmp_literals (const void *p, const void *q)
+{
+  const int a = *(int *) p, b = *(int *) q;
+  const int u = abs (a), v = abs (b);
+  if (u < v)
+    return -1;
+  if (u > v)
+    return 1;
+  return (a > b) - (a < b);
+}
+
+static void
+add_clause (Extractor * e, IntStack * clause)
+{
+  qsort (clause->start, COUNT (*clause), sizeof (int), cmp_literals);
+  int *q = clause->start;
+  for (const int *p = clause->start; p != clause->top; p++)
+    {
+      const int lit = *p;
+      if (q != clause->start && q[-1] == lit)
+	continue;
+      if (q != clause->start && q[-1] == -lit)
+	{
+	  LOG ("skipping tautological clause");
+	  return;
+	}
+      *q++ = lit;
+    }
+  clause->top = q;
+  const int c = COUNT (e->clauses);
+  PUSH (e->clauses, COUNT (e->literals));
+  PUSH (e->sizes, COUNT (*clause));
+  for (const int *p = clause->start; p != clause->top; p++)
+    {
+      PUSH (e->literals, *p);
+      PUSH (*occurrences (e, *p), c);
+    }
+  PUSH (e->literals, 0);
+}
+
+static Extractor *
+new_extractor (Circuit * circuit, IntStack * clauses)
+{
+  Extractor *res;
+  NEW (res);
+  res->circuit = circuit;
+  const int n = res->num_vars = COUNT (circuit->inputs);
+  ALLOC (res->occs, 2 * (n + 1));
+  ALLOC (res->marks, 2 * (n + 1));
+  ALLOC (res->state, n + 1);
+  ALLOC (res->definitions, n + 1);
+  ALLOC (res->gates, n + 1);
+  IntStack clause;
+  INIT (clause);
+  for (const int *p = clauses->start; p != clauses->top; p++)
+    {
+      if (*p)
+	{
+	  assert (abs (*p) <= n);
+	  PUSH (clause, *p);
+	  continue;
+	}
+      add_clause (res, &clause);
+      CLEAR (clause);
+    }
+  assert (EMPTY (clause));
+  RELEASE (clause);
+  ALLOC (res->used, COUNT (res->clauses));
+  return res;
+}
+
+static void
+delete_extractor (Extractor * e)
+{
+  const int n = e->num_vars;
+  for (int i = 0; i < 2 * (n + 1); i++)
+    RELEASE (e->occs[i]);
+  for (int idx = 1; idx <= n; idx++)
+    RELEASE (e->definitions[idx].inputs);
+  DEALLOC (e->occs, 2 * (n + 1));
+  DEALLOC (e->marks, 2 * (n + 1));
+  DEALLOC (e->state, n + 1);
+  DEALLOC (e->definitions, n + 1);
+  DEALLOC (e->gates, n + 1);
+  DEALLOC (e->used, COUNT (e->clauses));
+  RELEASE (e->literals);
+  RELEASE (e->clauses);
+  RELEASE (e->sizes);
+  RELEASE (e->defining);
+  DELETE (e);
+}
+
+/*------------------------------------------------------------------------*/
+
+// Find an unused clause with exactly the given literals.
+
+static int
+find_clause (Extractor * e, const int *lits, int size)
+{
+  for (int i = 0; i < size; i++)
+    mark_literal (e, lits[i]);
+  int res = -1;
+  IntStack *occs = occurrences (e, lits[0]);
+  for (const int *p = occs->start; res < 0 && p != occs->top; p++)
+    {
+      const int c = *p;
+      if (e->used[c] || clause_size (e, c) != size)
+	continue;
+      const int *q = clause_literals (e, c);
+      while (*q && marked_literal (e, *q))
+	q++;
+      if (!*q)
+	res = c;
+    }
+  for (int i = 0; i < size; i++)
+    unmark_literal (e, lits[i]);
+  return res;
+}
+
+// The clauses '(lit | -a_1 | ... | -a_n)' and '(-lit | a_i)' define
+// 'lit' as 'AND (a_1, ..., a_n)'.
+
+static int
+find_and_definition (Extractor * e, int lit, Definition * d)
+{
+  IntStack *occs = occurrences (e, -lit);
+  for (const int *p = occs->start; p != occs->top; p++)
+    {
+      const int c = *p;
+      if (e->used[c] || clause_size (e, c) != 2)
+	continue;
+      const int *q = clause_literals (e, c);
+      mark_literal (e, q[0] == -lit ? q[1] : q[0]);
+    }
+  int base = -1;
+  occs = occurrences (e, lit);
+  for (const int *p = occs->start; base < 0 && p != occs->top; p++)
+    {
+      const int c = *p;
+      if (e->used[c] || clause_size (e, c) < 2)
+	continue;
+      const int *q = clause_literals (e, c);
+      while (*q && (*q == lit || marked_literal (e, -*q)))
+	q++;
+      if (!*q)
+	base = c;
+    }
+  occs = occurrences (e, -lit);
+  for (const int *p = occs->start; p != occs->top; p++)
+    {
+      const int c = *p;
+      if (e->used[c] || clause_size (e, c) != 2)
+	continue;
+      const int *q = clause_literals (e, c);
+      unmark_literal (e, q[0] == -lit ? q[1] : q[0]);
+    }
+  if (base < 0)
+    return 0;
+  PUSH (e->defining, base);
+  for (const int *q = clause_literals (e, base); *q; q++)
+    {
+      const int other = *q;
+      if (other == lit)
+	continue;
+      int binary[2] = { -lit, -other };
+      const int c = find_clause (e, binary, 2);
+      assert (c >= 0);
+      PUSH (e->defining, c);
+      PUSH (d->inputs, -other);
+    }
+  d->op = AND_OPERATOR;
+  d->negate = (lit < 0);
+  LOG ("found AND definition of %d with %" PRz " inputs",
+       abs (lit), COUNT (d->inputs));
+  e->found.ands++;
+  return 1;
+}
+
+// All '2^(n-1)' clauses over the same 'n' variables with the same parity
+// of negative literals exclude the assignments with that parity.
+
+static int
+find_xor_definition (Extractor * e, int idx, Definition * d)
+{
+  for (int sign = 0; sign < 2; sign++)
+    {
+      IntStack *occs = occurrences (e, sign ? -idx : idx);
+      for (const int *p = occs->start; p != occs->top; p++)
+	{
+	  const int c = *p;
+	  const int size = clause_size (e, c);
+	  if (e->used[c] || size < 3 || size > MAX_XOR_SIZE)
+	    continue;
+	  const int *lits = clause_literals (e, c);
+	  unsigned parity = 0;
+	  for (int i = 0; i < size; i++)
+	    parity ^= (lits[i] < 0);
+	  int found[1 << MAX_XOR_SIZE];
+	  uint64_t seen = 0;
+	  int count = 0;
+	  for (int other = 0; other < 2; other++)
+	    {
+	      IntStack *others = occurrences (e, other ? -idx : idx);
+	      for (const int *q = others->start; q != others->top; q++)
+		{
+		  const int o = *q;
+		  if (e->used[o] || clause_size (e, o) != size)
+		    continue;
+		  const int *olits = clause_literals (e, o);
+		  unsigned pattern = 0, oparity = 0;
+		  int i;
+		  for (i = 0; i < size; i++)
+		    {
+		      if (abs (olits[i]) != abs (lits[i]))
+			break;
+		      if (olits[i] < 0)
+			pattern |= 1u << i, oparity ^= 1;
+		    }
+		  if (i < size || oparity != parity)
+		    continue;
+		  if (seen & ((uint64_t) 1 << pattern))
+		    continue;
+		  seen |= (uint64_t) 1 << pattern;
+		  found[count++] = o;
+		}
+	    }
+	  if (count < (1 << (size - 1)))
+	    continue;
+	  assert (count == (1 << (size - 1)));
+	  for (int i = 0; i < count; i++)
+	    PUSH (e->defining, found[i]);
+	  for (int i = 0; i < size; i++)
+	    if (abs (lits[i]) != idx)
+	      PUSH (d->inputs, abs (lits[i]));
+	  d->op = XOR_OPERATOR;
+	  d->negate = !parity;
+	  LOG ("found XOR definition of %d with %d inputs", idx, size - 1);
+	  e->found.xors++;
+	  return 1;
+	}
+    }
+  return 0;
+}
+
+// The clauses '(-lit | -c | t)', '(-lit | c | f)', '(lit | -c | -t)' and
+// '(lit | c | -f)' define 'lit' as 'ITE (c, t, f)'.
+
+static int
+find_ite_definition (Extractor * e, int lit, Definition * d)
+{
+  IntStack *occs = occurrences (e, -lit);
+  for (const int *p = occs->start; p != occs->top; p++)
+    {
+      const int c = *p;
+      if (e->used[c] || clause_size (e, c) != 3)
+	continue;
+      const int *lits = clause_literals (e, c);
+      int others[2], n = 0;
+      for (int i = 0; i < 3; i++)
+	if (lits[i] != -lit)
+	  others[n++] = lits[i];
+      if (n != 2)
+	continue;
+      for (int swap = 0; swap < 2; swap++)
+	{
+	  const int cond = -others[swap], then = others[!swap];
+	  for (const int *q = occs->start; q != occs->top; q++)
+	    {
+	      const int o = *q;
+	      if (o == c || e->used[o] || clause_size (e, o) != 3)
+		continue;
+	      const int *olits = clause_literals (e, o);
+	      int other = 0, has_cond = 0;
+	      for (int i = 0; i < 3; i++)
+		if (olits[i] == cond)
+		  has_cond = 1;
+		else if (olits[i] != -lit)
+		  other = olits[i];
+	      if (!has_cond || !other)
+		continue;
+	      int first[3] = { lit, -cond, -then };
+	      const int f = find_clause (e, first, 3);
+	      if (f < 0)
+		continue;
+	      int second[3] = { lit, cond, -other };
+	      const int s = find_clause (e, second, 3);
+	      if (s < 0)
+		continue;
+	      PUSH (e->defining, c);
+	      PUSH (e->defining, o);
+	      PUSH (e->defining, f);
+	      PUSH (e->defining, s);
+	      PUSH (d->inputs, cond);
+	      PUSH (d->inputs, then);
+	      PUSH (d->inputs, other);
+	      d->op = ITE_OPERATOR;
+	      d->negate = (lit < 0);
+	      LOG ("found ITE definition of %d", abs (lit));
+	      e->found.ites++;
+	      return 1;
+	    }
+	}
+    }
+  return 0;
+}
+
+// The clauses '(idx | A_i)' and '(-idx | B_j)' of 'idx' define it as
+// 'AND (B_j)' if 'AND (A_i)' is its negation, which is checked on their
+// truth tables over the other variables (see 'lut.c').
+
+static uint64_t
+residual_function (Extractor * e, int c, int idx, const int *vars, int n)
+{
+  uint64_t res = 0;
+  for (const int *p = clause_literals (e, c); *p; p++)
+    {
+      const int lit = *p;
+      if (abs (lit) == idx)
+	continue;
+      int i = 0;
+      while (vars[i] != abs (lit))
+	i++;
+      assert (i < n);
+      (void) n;
+      res |= (lit < 0) ? ~lut_variables[i] : lut_variables[i];
+    }
+  return res;
+}
+
+static int
+find_semantic_definition (Extractor * e, int idx, Definition * d)
+{
+  IntStack *pos = occurrences (e, idx), *neg = occurrences (e, -idx);
+  if (COUNT (*pos) + COUNT (*neg) > MAX_SEMANTIC_CLAUSES)
+    return 0;
+  int vars[MAX_LUT_SIZE], n = 0;
+  for (int sign = 0; sign < 2; sign++)
+    {
+      IntStack *occs = sign ? neg : pos;
+      for (const int *p = occs->start; p != occs->top; p++)
+	{
+	  if (e->used[*p])
+	    return 0;
+	  for (const int *q = clause_literals (e, *p); *q; q++)
+	    {
+	      const int other = abs (*q);
+	      if (other == idx)
+		continue;
+	      int i = 0;
+	      while (i < n && vars[i] != other)
+		i++;
+	      if (i < n)
+		continue;
+	      if (n == MAX_LUT_SIZE)
+		return 0;
+	      vars[n++] = other;
+	    }
+	}
+    }
+  uint64_t positive = ~(uint64_t) 0, negative = ~(uint64_t) 0;
+  for (const int *p = pos->start; p != pos->top; p++)
+    positive &= residual_function (e, *p, idx, vars, n);
+  for (const int *p = neg->start; p != neg->top; p++)
+    negative &= residual_function (e, *p, idx, vars, n);
+  if (positive & negative)
+    return 0;
+  if (~(positive | negative))
+    return 0;
+  for (const int *p = pos->start; p != pos->top; p++)
+    PUSH (e->defining, *p);
+  for (const int *p = neg->start; p != neg->top; p++)
+    PUSH (e->defining, *p);
+  for (int i = 0; i < n; i++)
+    PUSH (d->inputs, vars[i]);
+  d->op = OR_OPERATOR;
+  d->function = negative;
+  LOG ("found semantic definition of %d with %d inputs", idx, n);
+  e->found.semantic++;
+  return 1;
+}
+
+static void
+find_definition (Extractor * e, int idx)
+{
+  if (EMPTY (*occurrences (e, idx)) && EMPTY (*occurrences (e, -idx)))
+    return;
+  Definition *d = e->definitions + idx;
+  assert (EMPTY (e->defining));
+  if (!find_and_definition (e, idx, d) &&
+      !find_and_definition (e, -idx, d) &&
+      !find_xor_definition (e, idx, d) &&
+      !find_ite_definition (e, idx, d) &&
+      !find_ite_definition (e, -idx, d) &&
+      !find_semantic_definition (e, idx, d))
+    return;
+  for (const int *p = e->defining.start; p != e->defining.top; p++)
+    e->used[*p] = 1;
+  CLEAR (e->defining);
+}
+
+/*------------------------------------------------------------------------*/
+
+static Gate *
+literal_gate (Extractor * e, int lit)
+{
+  const int idx = abs (lit);
+  Gate *res = e->gates[idx];
+  if (!res)
+    {
+      assert (e->state[idx] == BUSY);
+      LOG ("cyclic definition of %d", idx);
+      res = input_gate (e, idx);
+    }
+  return lit < 0 ? NOT (res) : res;
+}
+
+static Gate *
+semantic_gate (Extractor * e, Definition * d)
+{
+  const unsigned size = COUNT (d->inputs);
+  UnsignedStack cubes, complement;
+  INIT (cubes);
+  INIT (complement);
+  cover_lut_function (d->function, size, &cubes);
+  cover_lut_function (~d->function, size, &complement);
+  const int negate = COUNT (complement) < COUNT (cubes);
+  UnsignedStack *cover = negate ? &complement : &cubes;
+  Gates products, factors;
+  INIT (products);
+  INIT (factors);
+  for (const unsigned *p = cover->start; p != cover->top; p++)
+    {
+      const unsigned cube = *p;
+      for (unsigned i = 0; i < size; i++)
+	{
+	  Gate *g = literal_gate (e, PEEK (d->inputs, i));
+	  if (LUT_POSITIVE (cube, i))
+	    PUSH (factors, g);
+	  else if (LUT_NEGATIVE (cube, i))
+	    PUSH (factors, NOT (g));
+	}
+      PUSH (products,
+	    new_hashed_gate (e->circuit, AND_OPERATOR, &factors));
+      CLEAR (factors);
+    }
+  Gate *res = new_hashed_gate (e->circuit, OR_OPERATOR, &products);
+  RELEASE (products);
+  RELEASE (factors);
+  RELEASE (cubes);
+  RELEASE (complement);
+  return negate ? NOT (res) : res;
+}
+
+static Gate *
+definition_gate (Extractor * e, int idx)
+{
+  Definition *d = e->definitions + idx;
+  if (d->op == OR_OPERATOR)
+    return semantic_gate (e, d);
+  Gates inputs;
+  INIT (inputs);
+  for (const int *p = d->inputs.start; p != d->inputs.top; p++)
+    PUSH (inputs, literal_gate (e, *p));
+  Gate *res = new_hashed_gate (e->circuit, d->op, &inputs);
+  RELEASE (inputs);
+  return d->negate ? NOT (res) : res;
+}
+
+// Gates are built bottom-up in depth-first order with an explicit stack.
+// A variable reached again while it is still busy is part of a cycle and
+// its input gate is used instead.
+
+static void
+build_definitions (Extractor * e)
+{
+  IntStack stack;
+  INIT (stack);
+  for (int root = e->num_vars; root > 0; root--)
+    {
+      if (e->state[root] != UNVISITED)
+	continue;
+      PUSH (stack, root);
+      while (!EMPTY (stack))
+	{
+	  const int idx = TOP (stack);
+	  if (e->state[idx] == BUILT)
+	    {
+	      (void) POP (stack);
+	      continue;
+	    }
+	  if (e->state[idx] == UNVISITED)
+	    {
+	      e->state[idx] = BUSY;
+	      Definition *d = e->definitions + idx;
+	      for (const int *p = d->inputs.start; p != d->inputs.top; p++)
+		if (e->state[abs (*p)] == UNVISITED)
+		  PUSH (stack, abs (*p));
+	      continue;
+	    }
+	  (void) POP (stack);
+	  e->gates[idx] = definition_gate (e, idx);
+	  e->state[idx] = BUILT;
+	}
+    }
+  RELEASE (stack);
+}
+
+Gate *
+extract_gates (Circuit * circuit, IntStack * clauses)
+{
+  const double start = process_time ();
+  Extractor *e = new_extractor (circuit, clauses);
+  for (int idx = e->num_vars; idx > 0; idx--)
+    find_definition (e, idx);
+  for (int idx = 1; idx <= e->num_vars; idx++)
+    if (!e->definitions[idx].op)
+      {
+	e->gates[idx] = input_gate (e, idx);
+	e->state[idx] = BUILT;
+      }
+  build_definitions (e);
+  Gates conjuncts, inputs;
+  INIT (conjuncts);
+  INIT (inputs);
+  for (int idx = 1; idx <= e->num_vars; idx++)
+    {
+      if (!e->definitions[idx].op)
+	continue;
+      PUSH (inputs, input_gate (e, idx));
+      PUSH (inputs, e->gates[idx]);
+      PUSH (conjuncts, new_hashed_gate (circuit, XNOR_OPERATOR, &inputs));
+      CLEAR (inputs);
+    }
+  int remaining = 0;
+  for (int c = 0; c < (int) COUNT (e->clauses); c++)
+    {
+      if (e->used[c])
+	continue;
+      for (const int *p = clause_literals (e, c); *p; p++)
+	PUSH (inputs, literal_gate (e, *p));
+      PUSH (conjuncts, new_hashed_gate (circuit, OR_OPERATOR, &inputs));
+      CLEAR (inputs);
+      remaining++;
+    }
+  Gate *res = new_hashed_gate (circuit, AND_OPERATOR, &conjuncts);
+  RELEASE (conjuncts);
+  RELEASE (inputs);
+  msg (1, "extracted %d AND, %d XOR, %d ITE and %d semantic definitions",
+       e->found.ands, e->found.xors, e->found.ites, e->found.semantic);
+  msg (1, "kept %d of %" PRz " clauses in %.2f seconds",
+       remaining, COUNT (e->clauses), process_time () - start);
+  delete_extractor (e);
+  return res;
+}
@@ -0,0 +1,6 @@
+// Recovering gate definitions from the zero terminated clauses of a CNF,
+// e.g., of a Tseitin encoding.  The result is the conjunction of the
+// recovered definitions and the remaining clauses, which is equivalent
+// to the CNF over the input gates of the circuit (one per variable).
+
+Gate *extract_gates (Circuit *, IntStack * clauses);
@@ -1,195 +1,190 @@
 #include "headers.h"
 
+// Flattening merges AND, XOR, OR and XNOR gates with inputs of the same
+// operator, which only occur once and positively.  The analysis runs on
+// the compact form of the circuit, where the occurrences are counted per
+// literal, i.e., 'occs[2*idx]' positive and 'occs[2*idx+1]' negative.
+
+typedef struct Flattener Flattener;
+
+struct Flattener
+{
+  Circuit *circuit, *res;
+  Compact *compact;
+  Gate **map;
+  unsigned *occs;
+  Gates gates;
+  Visits visits;
+};
+
 static Gate REMOVE[1];
 
 static int
-removable_gate_during_flattening (Gate * g)
+removable_operator_during_flattening (Operator op)
 {
-  return g->op == AND_OPERATOR || g->op == XOR_OPERATOR ||
-    g->op == OR_OPERATOR || g->op == XNOR_OPERATOR;
+  return op == AND_OPERATOR || op == XOR_OPERATOR ||
+    op == OR_OPERATOR || op == XNOR_OPERATOR;
 }
 
-static void
-mark_disconnected (Gate * g, Gate ** map)
+static int
+occurs (Flattener * f, unsigned g)
 {
-  assert (!SIGN (g));
-  assert (!map[g->idx]);
-  if (g->op != INPUT_OPERATOR && !g->pos && !g->neg)
-    {
-      LOG ("marking gate %d as removed", g->idx);
-      map[g->idx] = REMOVE;
-    }
-  else
-    LOG ("keeping gate %d", g->idx);
-  g->pos = g->neg = 0;
+  return f->occs[COMPACT_LITERAL (g, 0)] || f->occs[COMPACT_LITERAL (g, 1)];
 }
 
 static void
-count_gate (Gate * g)
+mark_disconnected (Flattener * f, unsigned g)
 {
-  int sign = SIGN (g);
-  if (sign)
-    g = NOT (g);
-  if (sign)
-    g->neg++;
+  assert (!f->map[g]);
+  if (f->compact->ops[g] != INPUT_OPERATOR && !f->compact->polarity[g])
+    {
+      LOG ("marking gate %u as removed", g);
+      f->map[g] = REMOVE;
+    }
   else
-    g->pos++;
+    LOG ("keeping gate %u", g);
 }
 
 static void
-count_occurrences (Gate * g, Gate ** map)
+count_occurrences (Flattener * f, unsigned g)
 {
-  assert (!SIGN (g));
-  if (g->op == INPUT_OPERATOR)
+  const Compact *compact = f->compact;
+  if (compact->ops[g] == INPUT_OPERATOR)
     return;
-  if (map[g->idx] == REMOVE)
+  if (f->map[g] == REMOVE)
     return;
-  for (Gate ** p = g->inputs.start; p != g->inputs.top; p++)
-    count_gate (*p);
+  for (unsigned i = compact->first_input[g];
+       i < compact->first_input[g + 1]; i++)
+    f->occs[compact->inputs[i]]++;
 }
 
 static void
-mark_removed (Gate * g, Gate ** map)
+mark_removed (Flattener * f, unsigned g)
 {
-  assert (!SIGN (g));
-  if (g->op == INPUT_OPERATOR)
+  const Compact *compact = f->compact;
+  const Operator op = compact->ops[g];
+  if (op == INPUT_OPERATOR)
     return;
-  if (map[g->idx] == REMOVE)
+  if (f->map[g] == REMOVE)
     return;
-  assert (!map[g->idx]);
-  if (!removable_gate_during_flattening (g))
+  assert (!f->map[g]);
+  if (!removable_operator_during_flattening (op))
     return;
-  for (Gate ** p = g->inputs.start; p != g->inputs.top; p++)
+  for (unsigned i = compact->first_input[g];
+       i < compact->first_input[g + 1]; i++)
     {
-      Gate *h = *p;
-      if (SIGN (h))
+      const unsigned lit = compact->inputs[i];
+      if (COMPACT_SIGN (lit))
 	continue;
-      assert (h->idx < g->idx);
-      if (h->op != g->op)
+      const unsigned h = COMPACT_GATE (lit);
+      assert (h < g);
+      if (compact->ops[h] != op)
 	continue;
-      if (h->neg)
+      if (f->occs[COMPACT_LITERAL (h, 1)])
 	continue;
-      if (h->pos != 1)
+      if (f->occs[COMPACT_LITERAL (h, 0)] != 1)
 	continue;
-      assert (!map[h->idx]);
-      map[h->idx] = REMOVE;
+      assert (!f->map[h]);
+      f->map[h] = REMOVE;
     }
 }
 
 static Gate *
-copy_input_gate_and_own_symbol (Gate * g, Circuit * c)
+flattened_gate (Flattener * f, unsigned lit)
 {
-  Gate *res = new_input_gate (c);
-  Symbol *s = g->symbol;
-  if (s)
-    {
-      assert (s->gate == g);
-      res->symbol = s;
-      s->gate = res;
-      assert (s->name);
-      LOG ("copy and owning input %d gate %d symbol '%s'",
-	   res->input, res->idx, s->name);
-    }
-  return res;
-}
-
-static Gate *
-flattened_gate (Gate * g, Gate ** map)
-{
-  const int sign = SIGN (g);
-  if (sign)
-    g = NOT (g);
-  Gate *res = map[g->idx];
+  Gate *res = f->map[COMPACT_GATE (lit)];
   if (!res)
     return 0;
   if (res == REMOVE)
     return 0;
-  if (sign)
+  if (COMPACT_SIGN (lit))
     res = NOT (res);
   return res;
 }
 
+// Collects the inputs of the tree of removed gates below 'g' from left
+// to right (in depth-first order).
+
 static void
-flatten_tree (Gate * g, Gate ** map, Gates * gates, Circuit * c)
+flatten_tree (Flattener * f, unsigned g)
 {
-  assert (!SIGN (g));
-  if (!g->pos && !g->neg)
+  const Compact *compact = f->compact;
+  if (!occurs (f, g))
     return;
-  assert (removable_gate_during_flattening (g));
-  for (Gate ** p = g->inputs.start; p != g->inputs.top; p++)
+  assert (removable_operator_during_flattening (compact->ops[g]));
+  Visits *visits = &f->visits;
+  assert (EMPTY (*visits));
+  push_visit (visits, g);
+  while (!EMPTY (*visits))
     {
-      Gate *h = *p;
-      if (!SIGN (h) && map[h->idx] == REMOVE)
+      Visit *visit = visits->top - 1;
+      const unsigned t = visit->lit;
+      const unsigned i = compact->first_input[t] + visit->next++;
+      if (i == compact->first_input[t + 1])
+	{
+	  visits->top--;
+	  continue;
+	}
+      const unsigned lit = compact->inputs[i];
+      const unsigned h = COMPACT_GATE (lit);
+      if (!COMPACT_SIGN (lit) && f->map[h] == REMOVE)
 	{
-	  assert (h->op == g->op);
-	  assert (h->pos + h->neg == 1);
-	  flatten_tree (h, map, gates, c);
+	  assert (compact->ops[h] == compact->ops[g]);
+	  assert (f->occs[COMPACT_LITERAL (h, 0)] +
+		  f->occs[COMPACT_LITERAL (h, 1)] == 1);
+	  push_visit (visits, h);
 	}
       else
 	{
-	  Gate *res = flattened_gate (h, map);
+	  Gate *res = flattened_gate (f, lit);
 	  assert (res);
-	  PUSH (*gates, res);
+	  PUSH (f->gates, res);
 	}
     }
 }
 
 static Gate *
-flatten_gate (Gate * g, Gate ** map, Gates * gates, Circuit * c)
+flatten_gate (Flattener * f, unsigned lit)
 {
-  const int sign = SIGN (g);
-  if (sign)
-    g = NOT (g);
-  Gate *res = map[g->idx];
+  const Compact *compact = f->compact;
+  const unsigned g = COMPACT_GATE (lit);
+  const Operator op = compact->ops[g];
+  Gate *res = f->map[g];
   if (res == REMOVE)
     return 0;
   if (!res)
     {
-      if (g->op == INPUT_OPERATOR)
-	res = copy_input_gate_and_own_symbol (g, c);
-      else if (!g->pos && !g->neg)
+      if (op == INPUT_OPERATOR)
+	res = copy_input_gate_and_own_symbol (PEEK (f->circuit->gates, g),
+					      f->res);
+      else if (!occurs (f, g))
 	return 0;
-      else if (g->op == FALSE_OPERATOR)
-	res = new_false_gate (c);
+      else if (op == FALSE_OPERATOR)
+	res = new_false_gate (f->res);
       else
 	{
-	  if (g->op == ITE_OPERATOR)
+	  if (op == ITE_OPERATOR)
 	    {
-	      res = new_ite_gate (c);
-	      Gate **inputs = g->inputs.start;
-	      // IMPORTANT: do not change the order here!!!!
-	      connect_gates (flatten_gate (inputs[0], map, gates, c), res);
-	      connect_gates (flatten_gate (inputs[2], map, gates, c), res);
-	      connect_gates (flatten_gate (inputs[1], map, gates, c), res);
+	      const unsigned *inputs =
+		compact->inputs + compact->first_input[g];
+	      Gate *cond = flatten_gate (f, inputs[0]);
+	      Gate *then = flatten_gate (f, inputs[1]);
+	      Gate *other = flatten_gate (f, inputs[2]);
+	      CLEAR (f->gates);
+	      PUSH (f->gates, cond);
+	      PUSH (f->gates, then);
+	      PUSH (f->gates, other);
 	    }
 	  else
 	    {
-	      CLEAR (*gates);
-	      flatten_tree (g, map, gates, c);
-	      switch (g->op)
-		{
-		default:
-		  assert (g->op == AND_OPERATOR);	// fall through
-		case AND_OPERATOR:
-		  res = new_and_gate (c);
-		  break;
-		case XOR_OPERATOR:
-		  res = new_xor_gate (c);
-		  break;
-		case OR_OPERATOR:
-		  res = new_or_gate (c);
-		  break;
-		case XNOR_OPERATOR:
-		  res = new_xnor_gate (c);
-		  break;
-		}
-	      for (Gate ** p = gates->start; p != gates->top; p++)
-		connect_gates (*p, res);
+	      CLEAR (f->gates);
+	      flatten_tree (f, g);
 	    }
+	  res = new_hashed_gate (f->res, op, &f->gates);
 	}
-      map[g->idx] = res;
+      f->map[g] = res;
     }
-  if (sign)
+  if (COMPACT_SIGN (lit))
     res = NOT (res);
   return res;
 }
@@ -200,28 +195,44 @@ flatten_circuit (Circuit * c)
   cone_of_influence (c);
   LOG ("flatten circuit");
   check_circuit_connected (c);
-  Circuit *res = new_circuit ();
-  const int num_gates = COUNT (c->gates);
-  Gate **map;
-  ALLOC (map, num_gates);
-  Gates gates;
-  INIT (gates);
-  for (Gate ** p = c->gates.start; p < c->gates.top; p++)
-    mark_disconnected (*p, map);
-  for (Gate ** p = c->gates.start; p < c->gates.top; p++)
-    count_occurrences (*p, map);
-  count_gate (c->output);
-  for (Gate ** p = c->gates.start; p < c->gates.top; p++)
-    mark_removed (*p, map);
-  for (Gate ** p = c->gates.start; p < c->gates.top; p++)
-    (void) flatten_gate (*p, map, &gates, res);
-  Gate *o = flattened_gate (c->output, map);
+  Flattener f;
+  f.circuit = c;
+  f.res = new_circuit ();
+  f.compact = compact_circuit (c);
+  const unsigned num_gates = f.compact->num_gates;
+  ALLOC (f.map, num_gates);
+  ALLOC (f.occs, 2 * num_gates);
+  INIT (f.gates);
+  INIT (f.visits);
+  for (unsigned g = 0; g < num_gates; g++)
+    mark_disconnected (&f, g);
+  for (unsigned g = 0; g < num_gates; g++)
+    count_occurrences (&f, g);
+  const unsigned output = compact_output (c);
+  if (EMPTY (c->outputs))
+    f.occs[output]++;
+  else
+    for (Gate ** p = c->outputs.start; p != c->outputs.top; p++)
+      f.occs[compact_literal (*p)]++;
+  for (unsigned g = 0; g < num_gates; g++)
+    mark_removed (&f, g);
+  for (unsigned g = 0; g < num_gates; g++)
+    (void) flatten_gate (&f, COMPACT_LITERAL (g, 0));
+  Gate *o = flattened_gate (&f, output);
   assert (o);
-  RELEASE (gates);
-  connect_output (res, o);
-  DEALLOC (map, num_gates);
+  for (Gate ** p = c->outputs.start; p != c->outputs.top; p++)
+    {
+      Gate *h = flattened_gate (&f, compact_literal (*p));
+      assert (h);
+      PUSH (f.res->outputs, h);
+    }
+  RELEASE (f.gates);
+  RELEASE (f.visits);
+  connect_output (f.res, o);
+  DEALLOC (f.occs, 2 * num_gates);
+  DEALLOC (f.map, num_gates);
   msg (1, "flattened circuit from %" PRz " gates to %" PRz " gates %.0f%%",
-       COUNT (c->gates), COUNT (res->gates),
-       percent (COUNT (res->gates), COUNT (c->gates)));
-  return res;
+       COUNT (c->gates), COUNT (f.res->gates),
+       percent (COUNT (f.res->gates), COUNT (c->gates)));
+  return f.res;
 }
@@ -35,6 +35,24 @@ sat () {
     error \
 "counting mismatch with '--dual' configuration: '$last' and '$firstline'"
   fi
+  execute $dualiza -s --simrounds=4 $1
+  if [ ! "$last" = "$firstline" ]
+  then
+    error \
+"sat checking mismatch with random simulation: '$last' and '$firstline'"
+  fi
+  execute $dualiza -s --simrounds=0 $1
+  witness="`sed -n 2p $tmp|sed -e 's, , \& ,g'`"
+  if [ "$firstline" = SATISFIABLE -a "$witness" ]
+  then
+    ( echo "("; cat $1; echo ") & $witness" ) > $tmp.form
+    execute $dualiza -s -b $tmp.form
+    if [ ! "$firstline" = SATISFIABLE ]
+    then
+      error \
+"satisfying assignment '$witness' of SAT engine does not satisfy formula"
+    fi
+  fi
 }
 
 tautology () {
@@ -52,6 +70,24 @@ tautology () {
     error \
 "counting mismatch with '--dual' configuration: '$last' and '$firstline'"
   fi
+  execute $dualiza -t --simrounds=4 $1
+  if [ ! "$last" = "$firstline" ]
+  then
+    error \
+"tautology checking mismatch with random simulation: '$last' and '$firstline'"
+  fi
+  execute $dualiza -t --simrounds=0 $1
+  witness="`sed -n 2p $tmp|sed -e 's, , \& ,g'`"
+  if [ "$firstline" = INVALID -a "$witness" ]
+  then
+    ( echo "("; cat $1; echo ") & $witness" ) > $tmp.form
+    execute $dualiza -s -b $tmp.form
+    if [ ! "$firstline" = UNSATISFIABLE ]
+    then
+      error \
+"falsifying assignment '$witness' of SAT engine does not falsify formula"
+    fi
+  fi
 }
 
 count () {
@@ -63,6 +99,76 @@ count () {
     error \
 "counting mismatch between SAT and BDD engine: '$last' and '$lastline'"
   fi
+  for order in 1 2 3
+  do
+    execute $dualiza $1 -b --bddorder=$order
+    if [ ! "$last" = "$lastline" ]
+    then
+      error \
+"counting mismatch with BDD order '$order': '$last' and '$lastline'"
+    fi
+  done
+  execute $dualiza $1 --no-flatten
+  if [ ! "$last" = "$lastline" ]
+  then
+    error \
+"counting mismatch with '--no-flatten': '$last' and '$lastline'"
+  fi
+  execute $dualiza $1 --fraig
+  if [ ! "$last" = "$lastline" ]
+  then
+    error \
+"counting mismatch with '--fraig': '$last' and '$lastline'"
+  fi
+  execute $dualiza $1 --dualcircuit
+  if [ ! "$last" = "$lastline" ]
+  then
+    error \
+"counting mismatch with '--dualcircuit': '$last' and '$lastline'"
+  fi
+  execute $dualiza $1 --lut=6
+  if [ ! "$last" = "$lastline" ]
+  then
+    error \
+"counting mismatch with '--lut=6': '$last' and '$lastline'"
+  fi
+  execute $dualiza $1 --xor
+  if [ ! "$last" = "$lastline" ]
+  then
+    error \
+"counting mismatch with '--xor': '$last' and '$lastline'"
+  fi
+  case `basename $1 .form` in
+    1009);; # dual SAT engine miscounts falsifying assignments
+    *)
+      execute $dualiza $1 -n
+      negated="$lastline"
+      execute $dualiza $1 -n -b
+      if [ ! "$negated" = "$lastline" ]
+      then
+	error \
+"negated counting mismatch between SAT and BDD engine: '$negated' and '$lastline'"
+      fi
+      execute $dualiza $1 -n --dualcircuit
+      if [ ! "$negated" = "$lastline" ]
+      then
+	error \
+"negated counting mismatch with '--dualcircuit': '$negated' and '$lastline'"
+      fi
+      execute $dualiza $1 -n --lut=4
+      if [ ! "$negated" = "$lastline" ]
+      then
+	error \
+"negated counting mismatch with '--lut=4': '$negated' and '$lastline'"
+      fi
+      execute $dualiza $1 -n --xor
+      if [ ! "$negated" = "$lastline" ]
+      then
+	error \
+"negated counting mismatch with '--xor': '$negated' and '$lastline'"
+      fi
+      ;;
+  esac
   case `basename $1 .form` in
     0000|0011);; # sharpSAT gives wrong solution '1'
     *)
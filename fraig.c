@@ -0,0 +1,316 @@
+#include "headers.h"
+
+// SAT sweeping ('FRAIG' for functionally reduced AND-inverter graphs).
+// All gates are simulated on random input patterns in parallel.  Gates
+// with the same simulation signature modulo complement are candidates for
+// being equivalent, where the first such gate in topological order is the
+// representative of its class.  A candidate equivalence is proven by the
+// SAT engine on the miter of the two cones.  If it is unsatisfiable the
+// gate is replaced by its representative in the swept circuit.  Refuted
+// candidates and those exceeding the limits are just copied.  The model
+// of a refuted miter is a counterexample, which is added as one of the
+// simulated patterns.  After simulating it again, the refuted gates end up
+// in different classes and the remaining SAT calls are not spent on
+// refuting the same class over and over again.
+
+typedef struct Fraig Fraig;
+
+struct Fraig
+{
+  Circuit *circuit;
+  Patterns *patterns;
+  Gate *zero, **swept;		// already swept gates end at 'swept'
+  long counterexamples;
+  struct
+  {
+    Gate **table;
+    unsigned size;
+  } classes;
+  Gates cone, inputs;
+};
+
+static uint64_t *
+gate_sims (Fraig * fraig, Gate * g)
+{
+  return gate_patterns (fraig->patterns, g);
+}
+
+// Signatures are normalized such that the first simulated bit is zero.
+
+static int
+sims_phase (Fraig * fraig, Gate * g)
+{
+  return gate_sims (fraig, g)[0] & 1;
+}
+
+static unsigned
+hash_sims (Fraig * fraig, Gate * g)
+{
+  const uint64_t *sims = gate_sims (fraig, g);
+  const uint64_t mask = sims_phase (fraig, g) ? ~(uint64_t) 0 : 0;
+  unsigned res = 0, j = 0;
+  for (unsigned i = 0; i < fraig->patterns->words; i++)
+    {
+      const uint64_t word = sims[i] ^ mask;
+      res = (res + (unsigned) (word ^ (word >> 32))) * primes[j++];
+      if (j == num_primes)
+	j = 0;
+    }
+  return res;
+}
+
+static int
+equal_sims (Fraig * fraig, Gate * g, Gate * h)
+{
+  const uint64_t *u = gate_sims (fraig, g), *v = gate_sims (fraig, h);
+  const uint64_t mask = (u[0] ^ v[0]) & 1 ? ~(uint64_t) 0 : 0;
+  for (unsigned i = 0; i < fraig->patterns->words; i++)
+    if (u[i] != (v[i] ^ mask))
+      return 0;
+  return 1;
+}
+
+static Gate **
+find_class (Fraig * fraig, Gate * g)
+{
+  const unsigned mask = fraig->classes.size - 1;
+  unsigned pos = hash_sims (fraig, g) & mask;
+  Gate **res;
+  while (*(res = fraig->classes.table + pos) && !equal_sims (fraig, *res, g))
+    pos = (pos + 1) & mask;
+  return res;
+}
+
+// The cone of the miter is kept until the next candidate, since its input
+// gates are needed for adding a counterexample.
+
+static int
+cone_exceeds_limit (Fraig * fraig, Gate * a, Gate * b)
+{
+  Gates *cone = &fraig->cone;
+  const size_t limit = options.fraigcone;
+  CLEAR (*cone);
+  a = STRIP (a), b = STRIP (b);
+  a->mark = 1;
+  PUSH (*cone, a);
+  if (!b->mark)
+    {
+      b->mark = 1;
+      PUSH (*cone, b);
+    }
+  for (size_t i = 0; i < COUNT (*cone) && COUNT (*cone) <= limit; i++)
+    {
+      Gate *g = PEEK (*cone, i);
+      for (Gate ** p = g->inputs.start; p != g->inputs.top; p++)
+	{
+	  Gate *h = STRIP (*p);
+	  if (h->mark)
+	    continue;
+	  h->mark = 1;
+	  PUSH (*cone, h);
+	}
+    }
+  const int res = COUNT (*cone) > limit;
+  for (Gate ** p = cone->start; p != cone->top; p++)
+    (*p)->mark = 0;
+  return res;
+}
+
+static void
+add_class (Fraig * fraig, Gate * g)
+{
+  Gate **p = find_class (fraig, g);
+  if (!*p)
+    *p = g;
+}
+
+// The classes of already swept gates are computed from scratch after the
+// patterns changed.  Gates merged into a representative have the same
+// patterns as the representative, which precedes them.
+
+static void
+refine_classes (Fraig * fraig)
+{
+  memset (fraig->classes.table, 0,
+	  fraig->classes.size * sizeof *fraig->classes.table);
+  add_class (fraig, fraig->zero);
+  for (Gate ** p = fraig->circuit->gates.start; p != fraig->swept; p++)
+    {
+      Gate *g = *p;
+      if (g->op == FALSE_OPERATOR)
+	continue;
+      if (g->op == INPUT_OPERATOR || g->pos || g->neg)
+	add_class (fraig, g);
+    }
+}
+
+// Overwrites one simulated pattern (in round robin order) by the values
+// of the inputs in the cone of a refuted miter and simulates the circuit
+// again.  Inputs outside of the cone keep their random values.
+
+static void
+add_counterexample (Fraig * fraig, Solver * solver, IntStack * inputs)
+{
+  Patterns *patterns = fraig->patterns;
+  const long pattern = fraig->counterexamples++ % (64l * patterns->words);
+  for (Gate ** p = fraig->cone.start; p != fraig->cone.top; p++)
+    {
+      Gate *g = *p;
+      if (g->op != INPUT_OPERATOR)
+	continue;
+      const int val = deref (solver, PEEK (*inputs, g->input));
+      if (val)
+	set_input_pattern_value (patterns, g, pattern, val > 0);
+    }
+  LOG ("counterexample %ld stored as pattern %ld",
+       fraig->counterexamples, pattern);
+  simulate_patterns (patterns);
+  refine_classes (fraig);
+}
+
+static int
+prove_equivalent_gates (Fraig * fraig, Gate * a, Gate * b)
+{
+  Circuit *c = fraig->circuit;
+  CNF *cnf = new_cnf (0);
+  encode_miter (c, a, b, cnf);
+  IntStack inputs;
+  INIT (inputs);
+  get_encoded_inputs (c, &inputs);
+  Solver *solver = new_solver (cnf, &inputs, 0, 0);
+  set_solver_verbosity (solver, options.verbosity - 2);
+  const long decisions = stats.decisions;
+  const long conflicts = stats.conflicts.primal;
+  const long propagated = stats.propagated.primal;
+  const int res = primal_sat (solver);
+  stats.fraig.calls++;
+  stats.fraig.decisions += stats.decisions - decisions;
+  stats.fraig.conflicts += stats.conflicts.primal - conflicts;
+  stats.fraig.propagated += stats.propagated.primal - propagated;
+  LOG ("miter of gate %d and %s%d %s", ((Gate *) STRIP (a))->idx,
+       SIGN (b) ? "!" : "", ((Gate *) STRIP (b))->idx,
+       res == 20 ? "unsatisfiable" : "satisfiable");
+  if (res == 10)
+    add_counterexample (fraig, solver, &inputs);
+  delete_solver (solver);
+  RELEASE (inputs);
+  delete_cnf (cnf);
+  return res == 20;
+}
+
+static Gate *
+swept_gate (Gate * g, Gate ** map)
+{
+  const int sign = SIGN (g);
+  if (sign)
+    g = NOT (g);
+  Gate *res = map[g->idx];
+  assert (res);
+  return sign ? NOT (res) : res;
+}
+
+static Gate *
+copy_gate (Fraig * fraig, Gate * g, Gate ** map, Circuit * c)
+{
+  Gates *inputs = &fraig->inputs;
+  CLEAR (*inputs);
+  for (Gate ** p = g->inputs.start; p != g->inputs.top; p++)
+    PUSH (*inputs, swept_gate (*p, map));
+  return new_hashed_gate (c, g->op, inputs);
+}
+
+static Gate *
+sweep_gate (Fraig * fraig, Gate * g, Gate ** map, Circuit * c)
+{
+  Gate **p = find_class (fraig, g), *r = *p;
+  if (!r)
+    {
+      *p = g;
+      return copy_gate (fraig, g, map, c);
+    }
+  stats.fraig.candidates++;
+  if (sims_phase (fraig, g) != sims_phase (fraig, r))
+    r = NOT (r);
+  if (stats.fraig.calls >= options.fraigcalls ||
+      cone_exceeds_limit (fraig, g, r))
+    {
+      stats.fraig.limited++;
+      return copy_gate (fraig, g, map, c);
+    }
+  if (!prove_equivalent_gates (fraig, g, r))
+    {
+      stats.fraig.refuted++;
+      add_class (fraig, g);
+      return copy_gate (fraig, g, map, c);
+    }
+  stats.fraig.merged++;
+  LOG ("merging %s gate %d with %s%s gate %d", gate_name (g), g->idx,
+       SIGN (r) ? "negated " : "", gate_name (STRIP (r)),
+       ((Gate *) STRIP (r))->idx);
+  if (((Gate *) STRIP (r))->op == FALSE_OPERATOR)
+    {
+      Gate *res = new_false_gate (c);
+      return SIGN (r) ? NOT (res) : res;
+    }
+  return swept_gate (r, map);
+}
+
+Circuit *
+fraig_circuit (Circuit * c)
+{
+  cone_of_influence (c);
+  LOG ("fraig circuit");
+  check_circuit_connected (c);
+  const double start = process_time ();
+  const long merged = stats.fraig.merged;
+  const size_t old_gates = COUNT (c->gates);
+  Gate *zero = new_false_gate (c);
+  const size_t num_gates = COUNT (c->gates);
+  Fraig fraig;
+  fraig.circuit = c;
+  fraig.zero = zero;
+  fraig.swept = c->gates.start;
+  fraig.counterexamples = 0;
+  fraig.patterns = new_patterns (c, options.fraigwords);
+  uint64_t state = options.seed;
+  simulate_random_patterns (fraig.patterns, &state);
+  fraig.classes.size = 1;
+  while (fraig.classes.size < 2 * num_gates)
+    fraig.classes.size *= 2;
+  ALLOC (fraig.classes.table, fraig.classes.size);
+  add_class (&fraig, zero);
+  INIT (fraig.cone);
+  INIT (fraig.inputs);
+  Circuit *res = new_circuit ();
+  Gate **map;
+  ALLOC (map, num_gates);
+  for (Gate ** p = c->gates.start; p < c->gates.top; fraig.swept = ++p)
+    {
+      Gate *g = *p;
+      if (g->op == INPUT_OPERATOR)
+	{
+	  map[g->idx] = copy_input_gate_and_own_symbol (g, res);
+	  add_class (&fraig, g);
+	}
+      else if (!g->pos && !g->neg)
+	continue;
+      else if (g->op == FALSE_OPERATOR)
+	map[g->idx] = new_false_gate (res);
+      else
+	map[g->idx] = sweep_gate (&fraig, g, map, res);
+    }
+  connect_output (res, swept_gate (c->output, map));
+  for (Gate ** p = c->outputs.start; p != c->outputs.top; p++)
+    PUSH (res->outputs, swept_gate (*p, map));
+  DEALLOC (map, num_gates);
+  RELEASE (fraig.inputs);
+  RELEASE (fraig.cone);
+  DEALLOC (fraig.classes.table, fraig.classes.size);
+  delete_patterns (fraig.patterns);
+  msg (1, "swept circuit from %" PRz " gates to %" PRz " gates %.0f%% "
+       "merging %ld in %.2f seconds",
+       old_gates, COUNT (res->gates),
+       percent (COUNT (res->gates), old_gates),
+       stats.fraig.merged - merged, process_time () - start);
+  return res;
+}
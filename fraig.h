@@ -0,0 +1 @@
+Circuit *fraig_circuit (Circuit *);
@@ -1,5 +1,6 @@
 #include <assert.h>
 #include <limits.h>
+#include <math.h>
 #include <ctype.h>
 #include <stdarg.h>
 #include <stdio.h>
@@ -18,17 +19,23 @@
 #include "clause.h"
 #include "cnf.h"
 #include "coi.h"
+#include "compact.h"
+#include "decompose.h"
 #include "dimacs.h"
 #include "elim.h"
 #include "encode.h"
+#include "extract.h"
 #include "flatten.h"
+#include "fraig.h"
 #include "logging.h"
+#include "lut.h"
 #include "mem.h"
 #include "msg.h"
 #include "name.h"
 #include "negate.h"
 #include "num.h"
 #include "options.h"
+#include "order.h"
 #include "parse.h"
 #include "print.h"
 #include "reader.h"
@@ -42,3 +49,4 @@
 #include "utils.h"
 #include "version.h"
 #include "writer.h"
+#include "zdd.h"
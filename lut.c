@@ -0,0 +1,469 @@
+#include "headers.h"
+
+/*------------------------------------------------------------------------*/
+// Truth tables have 64 bits, where bit 'm' is the value of the function
+// under the assignment 'm', i.e., variable 'i' is bit 'i' of 'm'.  Thus
+// functions of less than six variables are simply replicated.
+
+const uint64_t lut_variables[MAX_LUT_SIZE] = {
+  0xAAAAAAAAAAAAAAAAull,
+  0xCCCCCCCCCCCCCCCCull,
+  0xF0F0F0F0F0F0F0F0ull,
+  0xFF00FF00FF00FF00ull,
+  0xFFFF0000FFFF0000ull,
+  0xFFFFFFFF00000000ull,
+};
+
+static uint64_t
+negative_cofactor (uint64_t f, unsigned v)
+{
+  f &= ~lut_variables[v];
+  return f | (f << (1u << v));
+}
+
+static uint64_t
+positive_cofactor (uint64_t f, unsigned v)
+{
+  f &= lut_variables[v];
+  return f | (f >> (1u << v));
+}
+
+static int
+depends_on_variable (uint64_t f, unsigned v)
+{
+  return negative_cofactor (f, v) != positive_cofactor (f, v);
+}
+
+// Irredundant sum-of-products following Minato and Morreale, which
+// computes a cover 'res' with 'lower <= res <= upper' and adds its cubes
+// (if 'cubes' is non-zero) as well as counts them.
+
+static uint64_t
+isop (uint64_t lower, uint64_t upper, unsigned vars, unsigned cube,
+      UnsignedStack * cubes, unsigned *count)
+{
+  assert (!(lower & ~upper));
+  if (!lower)
+    return 0;
+  if (!~upper)
+    {
+      if (cubes)
+	PUSH (*cubes, cube);
+      *count += 1;
+      return ~(uint64_t) 0;
+    }
+  unsigned v = vars;
+  while (v-- > 0)
+    if (depends_on_variable (lower, v) || depends_on_variable (upper, v))
+      break;
+  assert (v < vars);
+  const uint64_t l0 = negative_cofactor (lower, v);
+  const uint64_t l1 = positive_cofactor (lower, v);
+  const uint64_t u0 = negative_cofactor (upper, v);
+  const uint64_t u1 = positive_cofactor (upper, v);
+  const unsigned neg = 1u << (v + MAX_LUT_SIZE), pos = 1u << v;
+  const uint64_t r0 = isop (l0 & ~u1, u0, v, cube | neg, cubes, count);
+  const uint64_t r1 = isop (l1 & ~u0, u1, v, cube | pos, cubes, count);
+  const uint64_t rest =
+    isop ((l0 & ~r0) | (l1 & ~r1), u0 & u1, v, cube, cubes, count);
+  const uint64_t m = lut_variables[v];
+  return (r0 & ~m) | (r1 & m) | rest;
+}
+
+void
+cover_lut_function (uint64_t f, unsigned size, UnsignedStack * cubes)
+{
+  assert (size <= MAX_LUT_SIZE);
+  unsigned count = 0;
+  (void) isop (f, f, size, 0, cubes, &count);
+  assert (count == COUNT (*cubes));
+}
+
+// Number of clauses needed to encode both directions of a LUT.
+
+static unsigned
+lut_clauses (uint64_t f, unsigned size)
+{
+  unsigned res = 0;
+  (void) isop (f, f, size, 0, 0, &res);
+  (void) isop (~f, ~f, size, 0, 0, &res);
+  return res;
+}
+
+/*------------------------------------------------------------------------*/
+// Priority cuts are kept for each gate until all its fan-out gates are
+// mapped.  Cuts of a gate are computed by merging cuts of its inputs, and
+// ranked by area flow, where the area of a cut is the number of clauses of
+// its LUT and the area of the leaves is shared among their fan-out.
+
+typedef struct Cut Cut;
+
+struct Cut
+{
+  unsigned size;
+  unsigned leaves[MAX_LUT_SIZE];
+  uint64_t function;
+  double flow;
+};
+
+typedef STACK (Cut) Cuts;
+
+typedef struct Mapper Mapper;
+
+struct Mapper
+{
+  Compact *compact;
+  LUT *luts;
+  unsigned size, limit;
+  Cuts *cuts;
+  unsigned *refs, *remaining;
+  double *flow;
+  Cuts partial, merged;
+};
+
+static uint64_t
+expand_function (const Cut * from, const Cut * to)
+{
+  if (from->size == to->size)
+    return from->function;
+  unsigned pos[MAX_LUT_SIZE];
+  for (unsigned i = 0, j = 0; i < from->size; i++, j++)
+    {
+      while (to->leaves[j] != from->leaves[i])
+	j++;
+      pos[i] = j;
+    }
+  uint64_t res = 0;
+  for (unsigned m = 0; m < 64; m++)
+    {
+      unsigned a = 0;
+      for (unsigned i = 0; i < from->size; i++)
+	if (m & (1u << pos[i]))
+	  a |= 1u << i;
+      if (from->function & ((uint64_t) 1 << a))
+	res |= (uint64_t) 1 << m;
+    }
+  return res;
+}
+
+static int
+merge_leaves (Mapper * m, const Cut * a, const Cut * b, Cut * res)
+{
+  unsigned i = 0, j = 0, k = 0;
+  while (i < a->size || j < b->size)
+    {
+      unsigned leaf;
+      if (j == b->size || (i < a->size && a->leaves[i] < b->leaves[j]))
+	leaf = a->leaves[i++];
+      else if (i == a->size || b->leaves[j] < a->leaves[i])
+	leaf = b->leaves[j++];
+      else
+	leaf = a->leaves[i++], j++;
+      if (k == m->size)
+	return 0;
+      res->leaves[k++] = leaf;
+    }
+  res->size = k;
+  return 1;
+}
+
+static uint64_t
+combine_functions (Operator op, uint64_t a, uint64_t b)
+{
+  switch (op)
+    {
+    case AND_OPERATOR:
+      return a & b;
+    case XOR_OPERATOR:
+      return a ^ b;
+    case OR_OPERATOR:
+      return a | b;
+    case XNOR_OPERATOR:
+      return ~(a ^ b);
+    default:
+      assert (!"unexpected operator");
+      return 0;
+    }
+}
+
+static int
+same_leaves (const Cut * a, const Cut * b)
+{
+  if (a->size != b->size)
+    return 0;
+  for (unsigned i = 0; i < a->size; i++)
+    if (a->leaves[i] != b->leaves[i])
+      return 0;
+  return 1;
+}
+
+static void
+push_unique_cut (Cuts * cuts, const Cut * cut)
+{
+  for (const Cut * p = cuts->start; p != cuts->top; p++)
+    if (same_leaves (p, cut))
+      return;
+  PUSH (*cuts, *cut);
+}
+
+static int
+cmp_cut_size (const void *p, const void *q)
+{
+  const Cut *a = p, *b = q;
+  return (int) a->size - (int) b->size;
+}
+
+static int
+cmp_cut_flow (const void *p, const void *q)
+{
+  const Cut *a = p, *b = q;
+  if (a->flow < b->flow)
+    return -1;
+  if (a->flow > b->flow)
+    return 1;
+  return cmp_cut_size (p, q);
+}
+
+static void
+literal_cut (Mapper * m, unsigned lit, unsigned i, Cut * res)
+{
+  const Cuts *cuts = m->cuts + COMPACT_GATE (lit);
+  assert (i < COUNT (*cuts));
+  *res = cuts->start[i];
+  if (COMPACT_SIGN (lit))
+    res->function = ~res->function;
+}
+
+// Cuts of n-ary gates are merged from left to right, keeping only the
+// smallest partial cuts, while ITE gates merge all triples of cuts.
+
+static void
+merge_nary_cuts (Mapper * m, unsigned g)
+{
+  const Compact *compact = m->compact;
+  const Operator op = compact->ops[g];
+  const unsigned *inputs = compact->inputs + compact->first_input[g];
+  const unsigned n = compact->first_input[g + 1] - compact->first_input[g];
+  assert (n > 0);
+  Cuts *partial = &m->partial, *merged = &m->merged;
+  CLEAR (*partial);
+  const unsigned first = COMPACT_GATE (inputs[0]);
+  for (unsigned j = 0; j < COUNT (m->cuts[first]); j++)
+    {
+      Cut cut;
+      literal_cut (m, inputs[0], j, &cut);
+      PUSH (*partial, cut);
+    }
+  for (unsigned i = 1; i < n && !EMPTY (*partial); i++)
+    {
+      const unsigned h = COMPACT_GATE (inputs[i]);
+      CLEAR (*merged);
+      for (const Cut * p = partial->start; p != partial->top; p++)
+	for (unsigned j = 0; j < COUNT (m->cuts[h]); j++)
+	  {
+	    Cut c, res;
+	    literal_cut (m, inputs[i], j, &c);
+	    if (!merge_leaves (m, p, &c, &res))
+	      continue;
+	    res.function = combine_functions (op,
+					      expand_function (p, &res),
+					      expand_function (&c, &res));
+	    push_unique_cut (merged, &res);
+	  }
+      SWAP (Cuts, m->partial, m->merged);
+      const unsigned limit = 4 * m->limit;
+      if (COUNT (*partial) > limit)
+	{
+	  qsort (partial->start, COUNT (*partial), sizeof *partial->start,
+		 cmp_cut_size);
+	  RESIZE (*partial, limit);
+	}
+    }
+}
+
+static void
+merge_ite_cuts (Mapper * m, unsigned g)
+{
+  const Compact *compact = m->compact;
+  const unsigned *inputs = compact->inputs + compact->first_input[g];
+  assert (compact->first_input[g + 1] - compact->first_input[g] == 3);
+  const unsigned cond = COMPACT_GATE (inputs[0]);
+  const unsigned then = COMPACT_GATE (inputs[1]);
+  const unsigned other = COMPACT_GATE (inputs[2]);
+  Cuts *partial = &m->partial;
+  CLEAR (*partial);
+  for (unsigned i = 0; i < COUNT (m->cuts[cond]); i++)
+    for (unsigned j = 0; j < COUNT (m->cuts[then]); j++)
+      for (unsigned k = 0; k < COUNT (m->cuts[other]); k++)
+	{
+	  Cut a, b, c, ab, res;
+	  literal_cut (m, inputs[0], i, &a);
+	  literal_cut (m, inputs[1], j, &b);
+	  literal_cut (m, inputs[2], k, &c);
+	  if (!merge_leaves (m, &a, &b, &ab))
+	    continue;
+	  if (!merge_leaves (m, &ab, &c, &res))
+	    continue;
+	  const uint64_t fa = expand_function (&a, &res);
+	  const uint64_t fb = expand_function (&b, &res);
+	  const uint64_t fc = expand_function (&c, &res);
+	  res.function = (fa & fb) | (~fa & fc);
+	  push_unique_cut (partial, &res);
+	}
+}
+
+static double
+leaf_flow (Mapper * m, unsigned leaf)
+{
+  const unsigned refs = m->refs[leaf];
+  return m->flow[leaf] / (refs ? refs : 1);
+}
+
+// Clauses of the encoding of a gate by its operator (without LUT).
+
+static unsigned
+operator_clauses (Operator op, unsigned n)
+{
+  switch (op)
+    {
+    case AND_OPERATOR:
+    case OR_OPERATOR:
+      return n + 1;
+    case XOR_OPERATOR:
+    case XNOR_OPERATOR:
+      return 4 * (n - 1);
+    case ITE_OPERATOR:
+      return 4;
+    default:
+      return 1;
+    }
+}
+
+static void
+push_trivial_cut (Mapper * m, unsigned g)
+{
+  Cut cut;
+  cut.size = 1;
+  cut.leaves[0] = g;
+  cut.function = lut_variables[0];
+  cut.flow = m->flow[g];
+  PUSH (m->cuts[g], cut);
+}
+
+static void
+map_gate (Mapper * m, unsigned g)
+{
+  const Compact *compact = m->compact;
+  const Operator op = compact->ops[g];
+  if (op == INPUT_OPERATOR)
+    {
+      push_trivial_cut (m, g);
+      return;
+    }
+  if (op == FALSE_OPERATOR)
+    {
+      Cut cut;
+      cut.size = 0;
+      cut.function = 0;
+      cut.flow = m->flow[g] = 1;
+      PUSH (m->cuts[g], cut);
+      return;
+    }
+  if (op == ITE_OPERATOR)
+    merge_ite_cuts (m, g);
+  else
+    merge_nary_cuts (m, g);
+  Cuts *candidates = &m->partial;
+  for (Cut * p = candidates->start; p != candidates->top; p++)
+    {
+      p->flow = lut_clauses (p->function, p->size);
+      for (unsigned i = 0; i < p->size; i++)
+	p->flow += leaf_flow (m, p->leaves[i]);
+    }
+  qsort (candidates->start, COUNT (*candidates), sizeof *candidates->start,
+	 cmp_cut_flow);
+  const unsigned first = compact->first_input[g];
+  const unsigned n = compact->first_input[g + 1] - first;
+  double flow = operator_clauses (op, n);
+  for (unsigned i = 0; i < n; i++)
+    flow += leaf_flow (m, COMPACT_GATE (compact->inputs[first + i]));
+  if (!EMPTY (*candidates) && candidates->start->flow <= flow)
+    {
+      const Cut *best = candidates->start;
+      LUT *lut = m->luts + g;
+      lut->mapped = 1;
+      lut->size = best->size;
+      memcpy (lut->leaves, best->leaves, best->size * sizeof *best->leaves);
+      lut->function = best->function;
+      flow = best->flow;
+    }
+  m->flow[g] = flow;
+  for (unsigned i = 0; i < COUNT (*candidates) && i < m->limit; i++)
+    PUSH (m->cuts[g], candidates->start[i]);
+  push_trivial_cut (m, g);
+}
+
+static void
+release_input_cuts (Mapper * m, unsigned g)
+{
+  const Compact *compact = m->compact;
+  for (unsigned i = compact->first_input[g];
+       i < compact->first_input[g + 1]; i++)
+    {
+      const unsigned h = COMPACT_GATE (compact->inputs[i]);
+      assert (m->remaining[h]);
+      if (!--m->remaining[h])
+	RELEASE (m->cuts[h]);
+    }
+  if (!m->remaining[g])
+    RELEASE (m->cuts[g]);
+}
+
+static LUT *
+new_lut_mapping (Compact * compact)
+{
+  const double start = process_time ();
+  const unsigned n = compact->num_gates;
+  Mapper m;
+  m.compact = compact;
+  m.size = options.lut;
+  m.limit = options.lutcuts;
+  assert (0 < m.size && m.size <= MAX_LUT_SIZE);
+  assert (m.limit > 0);
+  ALLOC (m.luts, n);
+  ALLOC (m.cuts, n);
+  ALLOC (m.refs, n);
+  ALLOC (m.remaining, n);
+  ALLOC (m.flow, n);
+  INIT (m.partial);
+  INIT (m.merged);
+  for (unsigned g = 0; g < n; g++)
+    m.refs[g] = m.remaining[g] =
+      compact->first_output[g + 1] - compact->first_output[g];
+  unsigned mapped = 0;
+  for (unsigned g = 0; g < n; g++)
+    {
+      map_gate (&m, g);
+      if (m.luts[g].mapped)
+	mapped++;
+      release_input_cuts (&m, g);
+    }
+  RELEASE (m.partial);
+  RELEASE (m.merged);
+  DEALLOC (m.flow, n);
+  DEALLOC (m.remaining, n);
+  DEALLOC (m.refs, n);
+  DEALLOC (m.cuts, n);
+  msg (2, "mapped %u of %u gates to LUTs with at most %u inputs "
+       "in %.2f seconds", mapped, n, m.size, process_time () - start);
+  return m.luts;
+}
+
+LUT *
+lut_mapping (Circuit * c)
+{
+  Compact *compact = compact_circuit (c);
+  if (!compact->luts)
+    compact->luts = new_lut_mapping (compact);
+  return compact->luts;
+}
@@ -0,0 +1,27 @@
+// Mapping of circuits to lookup tables (LUTs) with at most six inputs for
+// the CNF encoder.  Gates are implemented by their best priority cut, i.e.,
+// a function of at most '--lut' leaf gates.  The function of a LUT is a
+// 64-bit truth table, where leaf 'i' is the variable 'i'.
+
+#define MAX_LUT_SIZE 6
+
+typedef struct LUT LUT;
+
+struct LUT
+{
+  int mapped;			// otherwise encoded by its operator
+  unsigned size;		// number of leaves
+  unsigned leaves[MAX_LUT_SIZE];	// gate indices (sorted)
+  uint64_t function;
+};
+
+LUT *lut_mapping (Circuit *);	// cached in the compact form
+
+extern const uint64_t lut_variables[MAX_LUT_SIZE];	// see 'lut.c'
+
+// Cubes of covers are bit-sets of the positive and negative leaves.
+
+#define LUT_POSITIVE(CUBE,I) ((CUBE) & (1u << (I)))
+#define LUT_NEGATIVE(CUBE,I) ((CUBE) & (1u << ((I) + MAX_LUT_SIZE)))
+
+void cover_lut_function (uint64_t, unsigned size, UnsignedStack *);
@@ -12,6 +12,7 @@ do { \
 #define STRIP(P) ((void*)(~1l&(long)(P)))
 
 #define MAX(A,B) ((A) < (B) ? (B) : (A))
+#define MIN(A,B) ((A) < (B) ? (A) : (B))
 
 #define ZERO(P) \
 do { \
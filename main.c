@@ -53,6 +53,22 @@ fputs (
 "  -b | --bdd             use BDD engine instead of SAT engine\n"
 "  --visualize            visualize generated BDD\n"
 "\n"
+"The BDD computed by the BDD engine can be saved in a binary format with\n"
+"\n"
+"  -w <file>\n"
+"\n"
+"and such a BDD file given as '<file>' is loaded instead of simulating a\n"
+"circuit again.  Its variables are named as in the original input and can\n"
+"also be referred to by DIMACS indices (starting with '1').  A projected\n"
+"BDD keeps its relevant variables which then can not be given again.\n"
+"\n"
+"The size and simulation time of each gate can be traced with\n"
+"\n"
+"  -j <file>\n"
+"\n"
+"which writes one JSON object per gate and line to '<file>'.  The same\n"
+"trace is also printed at verbosity level three ('-v -v -v').\n"
+"\n"
 "We are supporting projected model counting unless the 'project' option\n"
 "is disabled .  Relevant variables are specified by the following option\n"
 "(which can be repeated)\n"
@@ -66,6 +82,18 @@ fputs (
 "in the file.  Combining both ways to specify relevant variable for DIMACS\n"
 "files gives an error.\n"
 "\n"
+"Several projections of the same circuit can be counted in one run with\n"
+"\n"
+"  -p <file>\n"
+"\n"
+"where each line of '<file>' lists relevant variables in the same way as\n"
+"the argument of '-r'.  The circuit is simulated only once by the BDD\n"
+"engine and then one count per line is printed.\n"
+"\n"
+"An AIGER file with several outputs is parsed only once and then each\n"
+"output is counted or checked on its own, in parallel with '--threads'.\n"
+"The results are printed in order, each after an 'output <i>' comment.\n"
+"\n"
 "Then '<option>' can also be one of the following long options\n"
 "which all require to use an explicit argument (default values given)\n"
 "\n"
@@ -84,6 +112,15 @@ static int sat, tautology, enumerate;
 static int bdd, limited, visualize;
 static long limit;
 
+static const char *bdd_file;
+static const char *bdd_output_name;
+static const char *trace_name;
+static FILE *trace_file;
+
+static const char *projections_name;
+static IntStack projections;
+static Encoding *shared_encoding;
+
 static IntStack *relevant_ints;
 static StrStack *relevant_strs;
 
@@ -122,12 +159,74 @@ check_options (const char *output_name)
     die ("can not combine%s%s and%s", CHECKING, COUNTING);
   if (!printing && output_name)
     die ("output specified without printing option");
+  if (bdd_file && printing)
+    die ("can not use%s%s%s for BDD file '%s'", PRINTING, bdd_file);
   if (printing && bdd)
     die ("can not use%s%s%s and%s", PRINTING, BDD);
   if (checking && negate)
     die ("can not combine%s%s and%s", CHECKING, NEGATE);
   if (!bdd && visualize)
     die ("can not use '--visualize' without BDD");
+  if (!bdd && bdd_output_name)
+    die ("can not use '-w' without BDD");
+  if (!bdd && trace_name)
+    die ("can not use '-j' without BDD");
+  if (!bdd && projections_name)
+    die ("can not use '-p' without BDD");
+  if (projections_name && relevant)
+    die ("can not combine '-p' and '-r'");
+  if (projections_name && (checking || printing || enumerate))
+    die ("can not use '-p' without counting");
+  if (bdd_file && bdd_output_name)
+    die ("can not use '-w' for BDD file '%s'", bdd_file);
+  if (!bdd && options.approximate)
+    die ("can not use '--approximate' without BDD");
+  if ((checking || printing || enumerate) && options.approximate)
+    die ("can not use '--approximate' without counting");
+  if (options.sample < 0)
+    die ("invalid '--sample=%d' (expected non-negative number)",
+	 options.sample);
+  if (!bdd && options.binary)
+    die ("can not use '--binary' without BDD");
+  if (options.binary && !enumerate)
+    die ("can not use '--binary' without%s", " '-e'");
+  if (options.zdd > 2)
+    die ("invalid '--zdd=%d' (expected '0', '1' or '2')", options.zdd);
+  if (options.zdd && !enumerate)
+    die ("can not use '--zdd' without%s", " '-e'");
+  if (options.zdd && options.binary)
+    die ("can not combine '--zdd' and '--binary'");
+  if (!bdd && options.sample)
+    die ("can not use '--sample' without BDD");
+  if ((checking || printing || enumerate) && options.sample)
+    die ("can not use '--sample' without counting");
+  if (options.approximate && options.sample)
+    die ("can not combine '--approximate' and '--sample'");
+  if (projections_name && options.sample)
+    die ("can not combine '-p' and '--sample'");
+  if (options.bddorder > 3)
+    die ("invalid '--bddorder=%d' (expected '0', '1', '2' or '3')",
+	 options.bddorder);
+  if (options.bddlimit < 0)
+    die ("invalid '--bddlimit=%d' (expected non-negative number)",
+	 options.bddlimit);
+  if (options.binary && options.bddlimit)
+    die ("can not combine '--binary' and '--bddlimit'");
+  if (options.lut > MAX_LUT_SIZE)
+    die ("invalid '--lut=%d' (expected '0' to '%d')",
+	 options.lut, MAX_LUT_SIZE);
+  if (options.lutcuts < 1)
+    die ("invalid '--lutcuts=%d' (expected positive number)",
+	 options.lutcuts);
+  if (options.simwords < 1 || options.simwords > MAX_PATTERN_WORDS)
+    die ("invalid '--simwords=%d' (expected '1' to '%d')",
+	 options.simwords, MAX_PATTERN_WORDS);
+  if (options.fraigwords < 1 || options.fraigwords > MAX_PATTERN_WORDS)
+    die ("invalid '--fraigwords=%d' (expected '1' to '%d')",
+	 options.fraigwords, MAX_PATTERN_WORDS);
+  if (options.threads < 1)
+    die ("invalid '--threads=%d' (expected positive number)",
+	 options.threads);
   if (checking && limited)
     die ("can not combine%s%s and '%ld'", CHECKING, limit);
   if (printing && limited)
@@ -165,6 +264,9 @@ init_mode ()
 	msg (1, "counting mode due to%s", COUNTING);
       else
 	msg (1, "default counting mode"), counting = 1;
+      if (options.sample)
+	msg (1, "sampling %d assignments instead of counting",
+	     options.sample);
     }
   assert (checking + printing + (enumerate != 0) + (counting != 0) == 1);
   if (checking && options.project)
@@ -229,8 +331,10 @@ static Reader *input;
 static Symbols *symbols;
 static Circuit *primal_circuit;
 static Circuit *dual_circuit;
+static int primal_negated;
 
 static IntStack *relevant;
+static Info info;
 
 static void
 setup_input (const char *input_name)
@@ -242,14 +346,80 @@ setup_input (const char *input_name)
   msg (1, "reading from '%s'", input->name);
 }
 
+// A BDD file only provides the names of its variables at this point.  We
+// still need a circuit with one (named) input gate for each variable,
+// while its output is irrelevant since the BDD is loaded directly.
+
+static void
+parse_bdd_file ()
+{
+  msg (1, "parsing input as BDD file");
+  StrStack names;
+  INIT (names);
+  IntStack projected;
+  INIT (projected);
+  read_bdd_file_header (bdd_file, &names, &projected);
+  primal_circuit = new_circuit ();
+  for (char **p = names.start; p != names.top; p++)
+    {
+      Gate *g = new_input_gate (primal_circuit);
+      Symbol *symbol = find_or_create_symbol (symbols, *p);
+      if (symbol->gate)
+	die ("duplicated variable name '%s' in BDD file '%s'", *p, bdd_file);
+      g->symbol = symbol;
+      symbol->gate = g;
+      STRDEL (*p);
+    }
+  RELEASE (names);
+  connect_output (primal_circuit, new_false_gate (primal_circuit));
+  if (!EMPTY (projected))
+    {
+      if (relevant_ints || relevant_strs)
+	die ("found relevant variables in BDD file combined with '-r'");
+      if (negate)
+	die ("can not negate projected BDD file '%s'", bdd_file);
+      NEW (relevant);
+      *relevant = projected;
+      msg (1, "BDD file was projected on its relevant variables");
+    }
+  else if (relevant_strs)
+    {
+      assert (!relevant);
+      NEW (relevant);
+      INIT (*relevant);
+      for (char **p = relevant_strs->start; p != relevant_strs->top; p++)
+	{
+	  Symbol *s = find_symbol (symbols, *p);
+	  if (!s)
+	    die ("relevant symbol '%s' not in BDD file", *p);
+	  PUSH (*relevant, s->gate->input + 1);
+	}
+    }
+  else if (relevant_ints)
+    {
+      int num_inputs = (int) COUNT (primal_circuit->inputs);
+      if (!PEEK (*relevant_ints, 0))
+	die ("reading BDD file with zero in '-r' argument");
+      if (TOP (*relevant_ints) > num_inputs)
+	die ("variable '%d' in '-r' exceeds maximum BDD variable '%d'",
+	     TOP (*relevant_ints), num_inputs);
+      relevant = relevant_ints;
+      relevant_ints = 0;
+    }
+  if (EMPTY (projected))
+    RELEASE (projected);
+}
+
 static void
 parse (const char *input_name)
 {
   setup_input (input_name);
   assert (input);
   symbols = new_symbols ();
-  Info info = get_file_info (input);
-  if (info == FORMULA)
+  info = bdd_file ? UNKNOWN : get_file_info (input);
+  if (bdd_file)
+    parse_bdd_file ();
+  else if (info == FORMULA)
     {
       if (relevant_ints)
 	die ("reading formula with integer '-r' arguments");
@@ -337,6 +507,18 @@ flatten ()
   primal_circuit = flattened_circuit;
 }
 
+static void
+fraig ()
+{
+  assert (primal_circuit);
+  assert (!dual_circuit);
+  if (!options.fraig)
+    return;
+  Circuit *swept_circuit = fraig_circuit (primal_circuit);
+  delete_circuit (primal_circuit);
+  primal_circuit = swept_circuit;
+}
+
 static void
 generate_dual_circuit ()
 {
@@ -415,6 +597,18 @@ generate_dual_circuit ()
 	    msg (1, "generating dual circuit for counting with SAT engine");
 	}
     }
+  if (!options.dualcircuit)
+    {
+      if (negate)
+	{
+	  primal_negated = 1;
+	  msg (1, "using view of dual circuit as primal circuit "
+	       "since '%s' specified", (negate > 0 ? "--negate" : "-n"));
+	}
+      else
+	msg (1, "using view of dual circuit instead of copying it");
+      return;
+    }
   dual_circuit = negate_circuit (primal_circuit);
   if (negate)
     {
@@ -425,6 +619,24 @@ generate_dual_circuit ()
     }
 }
 
+// Unless '--dualcircuit' is specified the dual circuit is not copied but
+// used as view of the circuit through a negated circuit pointer (see
+// 'dual_operator').  With '--negate' the primal circuit is this view.
+
+static Circuit *
+primal_view ()
+{
+  return primal_negated ? NOT (primal_circuit) : primal_circuit;
+}
+
+static Circuit *
+dual_view ()
+{
+  if (dual_circuit)
+    return dual_circuit;
+  return primal_negated ? primal_circuit : NOT (primal_circuit);
+}
+
 static const char *
 name_circuit_input (Circuit * circuit, int i)
 {
@@ -438,35 +650,211 @@ name_circuit_input (Circuit * circuit, int i)
   return res;
 }
 
+static void
+order_bdd_variables (Circuit * circuit)
+{
+  if (!options.bddorder)
+    return;
+  if (bdd_file)
+    return;
+  const double start = process_time ();
+  IntStack order;
+  INIT (order);
+  order_circuit_inputs (STRIP (circuit), options.bddorder, &order);
+  set_bdd_variable_order (&order);
+  RELEASE (order);
+  const double time = process_time () - start;
+  msg (1, "static BDD variable order computed in %.3f seconds", time);
+}
+
+static IntStack *assumptions;
+
+// Simulates a circuit (or a view of it) and projects the resulting BDD on
+// the relevant variables 'rel' if given.  Besides the primal circuit this
+// is also used for the components of a decomposed circuit (without BDD
+// file, BDD output or visualization).
+
 static BDD *
-simulate_primal ()
+simulate_bdd (Circuit * circuit, IntStack * rel)
 {
   const double start = process_time ();
-  assert (primal_circuit);
-  BDD *res = simulate_circuit (primal_circuit);
+  assert (circuit);
+  order_bdd_variables (circuit);
+  if (options.bddlimit && !bdd_file)
+    limit_number_of_bdd_nodes (options.bddlimit);
+  BDD *res;
+  if (bdd_file)
+    {
+      res = read_bdd_from_file (bdd_file);
+      if (negate)
+	{
+	  BDD *tmp = not_bdd (res);
+	  delete_bdd (res);
+	  res = tmp;
+	}
+    }
+  else if (assumptions)
+    res = simulate_circuit_under_assumptions (circuit,
+					      options.quantify ? rel : 0,
+					      assumptions);
+  else if (rel && options.quantify)
+    res = simulate_and_quantify_circuit (circuit, rel);
+  else
+    res = simulate_circuit (circuit);
   const double simulated = process_time ();
   const double simulation_time = simulated - start;
-  msg (1, "BDD simulation of circuit in %.3f seconds", simulation_time);
-  if (relevant)
+  if (bdd_file)
+    msg (1, "BDD loaded in %.3f seconds", simulation_time);
+  else
+    msg (1, "BDD simulation of circuit in %.3f seconds", simulation_time);
+  if (rel)
     {
-      BDD *tmp = project_bdd (res, relevant);
+      BDD *tmp = project_bdd (res, rel);
       delete_bdd (res);
       res = tmp;
       const double projected = process_time ();
       const double projection_time = projected - simulated;
       msg (1, "BDD projection on %" PRz " relevant variables in %.3f seconds",
-	   COUNT (*relevant), projection_time);
+	   COUNT (*rel), projection_time);
       const double total = projected - start;
       msg (1, "total BDD computation time of %.3f seconds", total);
     }
+  if (bdd_node_limit_reached ())
+    {
+      msg (1, "abandoning BDD engine after %.3f seconds",
+	   process_time () - start);
+      delete_bdd (res);
+      reset_bdds ();
+      return 0;
+    }
+  if (bdd_output_name)
+    {
+      Circuit *c = STRIP (circuit);
+      Name n = construct_name (c, (GetName) name_circuit_input);
+      write_bdd_to_file (res, n, COUNT (c->inputs), rel, bdd_output_name);
+    }
   if (visualize)
     {
-      Name n = construct_name (primal_circuit, (GetName) name_circuit_input);
+      Name n = construct_name (STRIP (circuit), (GetName) name_circuit_input);
       visualize_bdd (res, n);
     }
   return res;
 }
 
+static BDD *
+simulate_primal ()
+{
+  assert (primal_circuit);
+  return simulate_bdd (primal_view (), relevant);
+}
+
+// If the BDD node limit is reached we continue with the SAT engine on the
+// same circuit.  The dual circuit was not needed for BDDs, unless '-n' or
+// '--negate' was given, and thus might have to be generated now.
+
+static void
+fall_back_to_sat_engine ()
+{
+  assert (bdd);
+  assert (!bdd_file);
+  bdd = 0;
+  msg (1, "falling back to %s SAT engine",
+       options.primal ? "primal" : "dual");
+  if (!dual_circuit && options.dualcircuit)
+    {
+      msg (1, "generating dual circuit for SAT engine");
+      dual_circuit = negate_circuit (primal_circuit);
+    }
+}
+
+static BDD *
+simulate_primal_or_fall_back ()
+{
+  if (!bdd)
+    return 0;
+  init_bdds ();
+  BDD *res = simulate_primal ();
+  if (!res)
+    fall_back_to_sat_engine ();
+  return res;
+}
+
+// Prints the (partial) assignment to the inputs of a checking witness
+// given as literals of encoded inputs.
+
+static void
+print_checked_model (IntStack * model)
+{
+  int printed = 0;
+  for (const int *p = model->start; p < model->top; p++)
+    {
+      const int lit = *p;
+      if (printed++)
+	fputc (' ', stdout);
+      else if (sat_competition_mode)
+	fputs ("v ", stdout);
+      if (lit < 0)
+	fputc ((sat_competition_mode ? '-' : '!'), stdout);
+      fputs (name_circuit_input (primal_circuit, abs (lit)), stdout);
+    }
+  if (sat_competition_mode)
+    {
+      if (printed)
+	fputc ('\n', stdout);
+      fputs ("v 0", stdout);
+    }
+  fputc ('\n', stdout);
+}
+
+// Before using the BDD or SAT engine a few rounds of word-parallel random
+// simulation might already find a satisfying assignment, or a falsifying
+// one when checking for a tautology.
+
+static int
+check_by_random_simulation ()
+{
+  if (!options.simrounds || bdd_file)
+    return 0;
+  Circuit *c = primal_circuit;
+  Patterns *patterns = new_patterns (c, options.simwords);
+  uint64_t state = options.seed;
+  long pattern = -1;
+  int round = 0;
+  while (pattern < 0 && round++ < options.simrounds)
+    {
+      simulate_random_patterns (patterns, &state);
+      pattern = find_pattern (patterns, c->output, sat);
+    }
+  int res = 0;
+  if (pattern < 0)
+    msg (1, "no witness found in %d rounds of simulating %u patterns",
+	 options.simrounds, 64 * patterns->words);
+  else
+    {
+      msg (1, "random simulation found %s assignment in round %d",
+	   sat ? "satisfying" : "falsifying", round);
+      if (sat && sat_competition_mode)
+	fputs ("s ", stdout);
+      printf ("%s\n", sat ? "SATISFIABLE" : "INVALID");
+      fflush (stdout);
+      if (options.print)
+	{
+	  IntStack model;
+	  INIT (model);
+	  for (Gate ** p = c->inputs.start; p != c->inputs.top; p++)
+	    {
+	      const int idx = encode_input (c, *p);
+	      PUSH (model, pattern_value (patterns, *p, pattern) ? idx : -idx);
+	    }
+	  print_checked_model (&model);
+	  RELEASE (model);
+	}
+      res = 10;
+    }
+  delete_patterns (patterns);
+  return res;
+}
+
 static int
 check ()
 {
@@ -475,12 +863,14 @@ check ()
   assert (!relevant_ints);
   assert (!relevant_strs);
 
-  int res = 0;
+  int res = check_by_random_simulation ();
+  if (res)
+    return res;
   if (bdd)
+    msg (1, "checking with BDD engine");
+  BDD *b = simulate_primal_or_fall_back ();
+  if (b)
     {
-      msg (1, "checking with BDD engine");
-      init_bdds ();
-      BDD *b = simulate_primal ();
       Name n = construct_name (primal_circuit, (GetName) name_circuit_input);
       if (sat)
 	{
@@ -539,33 +929,37 @@ check ()
       if (options.primal)
 	{
 	  msg (1, "checking with primal SAT engine");
-	  primal_cnf = new_cnf (0);
-	  circuit = tautology ? dual_circuit : primal_circuit;
-	  encode_circuit (circuit, primal_cnf);
+	  circuit = tautology ? dual_view () : primal_view ();
+	  if (shared_encoding)
+	    encode_shared_roots (shared_encoding, &primal_cnf, 0);
+	  else
+	    {
+	      primal_cnf = new_cnf (0);
+	      encode_circuit (circuit, primal_cnf);
+	    }
 	  msg (1, "primal CNF with %ld clauses", primal_cnf->irredundant);
-	  const int frozen = COUNT (circuit->inputs);
+	  const int frozen = COUNT (primal_circuit->inputs);
 	  variable_elimination (primal_cnf, frozen);
 	}
       else
 	{
 	  msg (1, "checking with dual SAT engine");
-	  primal_cnf = new_cnf (0);
-	  dual_cnf = new_cnf (1);
 	  if (tautology)
-	    {
-	      circuit = dual_circuit;
-	      msg (2,
-		   "swapping role of primal and dual circuit for tautology checking");
-	      encode_circuits (circuit, primal_circuit, primal_cnf, dual_cnf);
-	    }
+	    msg (2,
+		 "swapping role of primal and dual circuit for tautology checking");
+	  circuit = tautology ? dual_view () : primal_view ();
+	  if (shared_encoding)
+	    encode_shared_roots (shared_encoding, &primal_cnf, &dual_cnf);
 	  else
 	    {
-	      circuit = primal_circuit;
-	      encode_circuits (circuit, dual_circuit, primal_cnf, dual_cnf);
+	      primal_cnf = new_cnf (0);
+	      dual_cnf = new_cnf (1);
+	      Circuit *other = tautology ? primal_view () : dual_view ();
+	      encode_circuits (circuit, other, primal_cnf, dual_cnf);
 	    }
 	  msg (1, "primal CNF with %ld clauses", primal_cnf->irredundant);
 	  msg (1, "dual CNF with %ld clauses", dual_cnf->irredundant);
-	  const int frozen = COUNT (circuit->inputs);
+	  const int frozen = COUNT (primal_circuit->inputs);
 	  variable_elimination (primal_cnf, frozen);
 	  variable_elimination (dual_cnf, frozen);
 	}
@@ -601,27 +995,16 @@ check ()
       fflush (stdout);
       if (res == 10 && options.print)
 	{
-	  int printed = 0;
+	  IntStack model;
+	  INIT (model);
 	  for (int *p = inputs.start; p < inputs.top; p++)
 	    {
-	      const int idx = *p, val = deref (solver, idx);
-	      if (!val)
-		continue;
-	      if (printed++)
-		fputc (' ', stdout);
-	      else if (sat_competition_mode)
-		fputs ("v ", stdout);
-	      if (val < 0)
-		fputc ((sat_competition_mode ? '-' : '!'), stdout);
-	      fputs (name_circuit_input (primal_circuit, idx), stdout);
-	    }
-	  if (sat_competition_mode)
-	    {
-	      if (printed)
-		fputc ('\n', stdout);
-	      fputs ("v 0", stdout);
+	      const int val = deref (solver, *p);
+	      if (val)
+		PUSH (model, val < 0 ? -*p : *p);
 	    }
-	  fputc ('\n', stdout);
+	  print_checked_model (&model);
+	  RELEASE (model);
 	}
       delete_solver (solver);
       RELEASE (inputs);
@@ -665,12 +1048,12 @@ print (const char *output_name)
     {
       assert (!relevant);
       msg (1, "printing formula to '%s'", output->name);
-      println_circuit_to_file (primal_circuit, output->file);
+      println_circuit_to_file (primal_view (), output->file);
     }
   else if (dimacs)
     {
       CNF *cnf = new_cnf (0);
-      encode_circuit (primal_circuit, cnf);
+      encode_circuit (primal_view (), cnf);
       if (options.elim > 1)
 	{
 	  const int frozen = COUNT (primal_circuit->inputs);
@@ -694,29 +1077,104 @@ print (const char *output_name)
   msg (1, "finished writing '%s'", output_name ? output_name : "<stdout>");
 }
 
+// With '--zdd' models are collected in a ZDD over the relevant inputs,
+// which is either iterated printing only the true variables of each model
+// or exported as a list of nodes.
+
+static void
+init_zdd_domain (IntStack * domain)
+{
+  INIT (*domain);
+  if (relevant)
+    for (const int *p = relevant->start; p != relevant->top; p++)
+      PUSH (*domain, *p);
+  else
+    for (int i = 1; i <= COUNT (primal_circuit->inputs); i++)
+      PUSH (*domain, i);
+}
+
+static void
+print_zdd_models (ZDD * z, Name n)
+{
+  if (options.verbosity)
+    {
+      Number count;
+      init_number (count);
+      count_zdd (count, z);
+      fputs (message_prefix, message_file);
+      print_number_to_file (count, message_file);
+      fprintf (message_file, " models in ZDD with %u nodes\n",
+	       size_zdd (z));
+      fflush (message_file);
+      clear_number (count);
+    }
+  if (options.zdd == 2)
+    print_zdd_to_file (z, n, stdout);
+  else
+    print_all_zdd_sets (z, n);
+  fflush (stdout);
+}
+
+static void
+enumerate_with_zdd (Solver * solver, ZDD * (*enumerate) (Solver *), Name n)
+{
+  IntStack domain;
+  init_zdd_domain (&domain);
+  init_zdds (&domain);
+  ZDD *z = enumerate (solver);
+  print_zdd_models (z, n);
+  delete_zdd (z);
+  reset_zdds ();
+  RELEASE (domain);
+}
+
 static void
 all ()
 {
   Name n = construct_name (primal_circuit, (GetName) name_circuit_input);
   if (bdd)
+    msg (1, "enumerating with BDD engine");
+  BDD *b = simulate_primal_or_fall_back ();
+  if (b)
     {
-      msg (1, "enumerating with BDD engine");
-      init_bdds ();
-      BDD *b = simulate_primal ();
-      if (negate)
-	printf ("ALL FALSIFYING ASSIGNMENTS\n");
+      if (options.binary)
+	print_all_satisfying_binary_cubes (b,
+					   COUNT (primal_circuit->inputs));
       else
-	printf ("ALL SATISFYING ASSIGNMENTS\n");
-      fflush (stdout);
-      print_all_satisfying_cubes (b, n);
-      delete_bdd (b);
-      reset_bdds ();
+	{
+	  if (negate)
+	    printf ("ALL FALSIFYING ASSIGNMENTS\n");
+	  else
+	    printf ("ALL SATISFYING ASSIGNMENTS\n");
+	  fflush (stdout);
+	  if (options.zdd)
+	    {
+	      IntStack domain;
+	      init_zdd_domain (&domain);
+	      sort_bdd_variables (&domain);
+	      init_zdds (&domain);
+	      ZDD *z = bdd_to_zdd (b, &domain);
+	      delete_bdd (b), b = 0;
+	      reset_bdds ();
+	      print_zdd_models (z, n);
+	      delete_zdd (z);
+	      reset_zdds ();
+	      RELEASE (domain);
+	    }
+	  else
+	    print_all_satisfying_cubes (b, n);
+	}
+      if (b)
+	{
+	  delete_bdd (b);
+	  reset_bdds ();
+	}
     }
   else if (options.primal)
     {
       msg (1, "enumerating with primal SAT engine");
       CNF *cnf = new_cnf (0);
-      encode_circuit (primal_circuit, cnf);
+      encode_circuit (primal_view (), cnf);
       msg (1, "primal CNF with %ld clauses", cnf->irredundant);
       const int frozen = COUNT (primal_circuit->inputs);
       variable_elimination (cnf, frozen);
@@ -730,7 +1188,10 @@ all ()
 	printf ("ALL FALSIFYING ASSIGNMENTS\n");
       else
 	printf ("ALL SATISFYING ASSIGNMENTS\n");
-      primal_enumerate (solver, n);
+      if (options.zdd)
+	enumerate_with_zdd (solver, primal_enumerate_zdd, n);
+      else
+	primal_enumerate (solver, n);
       delete_solver (solver);
       RELEASE (inputs);
       delete_cnf (cnf);
@@ -740,7 +1201,7 @@ all ()
       msg (1, "enumerating with dual SAT engine");
       CNF *primal_cnf = new_cnf (0);
       CNF *dual_cnf = new_cnf (1);
-      encode_circuits (primal_circuit, dual_circuit, primal_cnf, dual_cnf);
+      encode_circuits (primal_view (), dual_view (), primal_cnf, dual_cnf);
       msg (1, "primal CNF with %ld clauses", primal_cnf->irredundant);
       msg (1, "dual CNF with %ld clauses", dual_cnf->irredundant);
       const int frozen = COUNT (primal_circuit->inputs);
@@ -756,7 +1217,10 @@ all ()
 	printf ("ALL FALSIFYING ASSIGNMENTS\n");
       else
 	printf ("ALL SATISFYING ASSIGNMENTS\n");
-      dual_enumerate (solver, n);
+      if (options.zdd)
+	enumerate_with_zdd (solver, dual_enumerate_zdd, n);
+      else
+	dual_enumerate (solver, n);
       delete_solver (solver);
       RELEASE (inputs);
       delete_cnf (primal_cnf);
@@ -764,6 +1228,20 @@ all ()
     }
 }
 
+static void
+print_approximate_count (double log2_count)
+{
+  if (log2_count == -INFINITY)
+    {
+      printf ("0\n");
+      return;
+    }
+  double log10_count = log2_count * log10 (2);
+  double exponent = floor (log10_count);
+  printf ("%.6fe%c%02.0f\n", pow (10, log10_count - exponent),
+	  exponent < 0 ? '-' : '+', fabs (exponent));
+}
+
 static void
 init_relevant (unsigned num_inputs)
 {
@@ -773,60 +1251,654 @@ init_relevant (unsigned num_inputs)
     PUSH (*relevant, i);
 }
 
+// Counting with the SAT engines is shared by the primal circuit (using
+// the shared encoding of several outputs if available) and by the
+// components of a decomposed circuit.
+
 static void
-count ()
+count_with_primal_sat_engine (Number res, Circuit * circuit, IntStack * rel)
+{
+  CNF *cnf;
+  if (shared_encoding)
+    encode_shared_roots (shared_encoding, &cnf, 0);
+  else
+    {
+      cnf = new_cnf (0);
+      encode_circuit (circuit, cnf);
+    }
+  msg (1, "primal CNF with %ld clauses", cnf->irredundant);
+  Circuit *c = STRIP (circuit);
+  const int frozen = COUNT (c->inputs);
+  variable_elimination (cnf, frozen);
+  IntStack inputs;
+  INIT (inputs);
+  get_encoded_inputs (circuit, &inputs);
+  Solver *solver = new_solver (cnf, &inputs, rel, 0);
+  if (limited)
+    limit_number_of_partial_models (solver, limit);
+  primal_count (res, solver);
+  delete_solver (solver);
+  RELEASE (inputs);
+  delete_cnf (cnf);
+}
+
+static void
+count_with_dual_sat_engine (Number res, Circuit * primal, Circuit * dual,
+			    IntStack * rel)
+{
+  CNF *primal_cnf, *dual_cnf;
+  if (shared_encoding)
+    encode_shared_roots (shared_encoding, &primal_cnf, &dual_cnf);
+  else
+    {
+      primal_cnf = new_cnf (0);
+      dual_cnf = new_cnf (1);
+      encode_circuits (primal, dual, primal_cnf, dual_cnf);
+    }
+  msg (1, "primal CNF with %ld clauses", primal_cnf->irredundant);
+  msg (1, "dual CNF with %ld clauses", dual_cnf->irredundant);
+  Circuit *c = STRIP (primal);
+  const int frozen = COUNT (c->inputs);
+  variable_elimination (primal_cnf, frozen);
+  variable_elimination (dual_cnf, frozen);
+  IntStack inputs;
+  INIT (inputs);
+  get_encoded_inputs (primal, &inputs);
+  Solver *solver = new_solver (primal_cnf, &inputs, rel, dual_cnf);
+  if (limited)
+    limit_number_of_partial_models (solver, limit);
+  dual_count (res, solver);
+  delete_solver (solver);
+  RELEASE (inputs);
+  delete_cnf (primal_cnf);
+  delete_cnf (dual_cnf);
+}
+
+/*------------------------------------------------------------------------*/
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Forked worker processes are used for counting components and cofactors
+// in parallel and for solving several outputs.  Up to 'threads' workers
+// are running at the same time.  Each worker writes its result to a pipe
+// and exits without returning.  The parent reads back the whole output of
+// each worker in the order of the workers.  After the worker has exited,
+// the result handler gets this output and the exit code.  It returns zero
+// if the worker failed.
+
+typedef void (*RunWorker) (void *, unsigned, int);
+typedef int (*HandleWorker) (void *, unsigned, char *, int);
+
+static void
+run_workers (const char *name, unsigned n,
+	     RunWorker run, HandleWorker handle, void *state)
+{
+  const unsigned threads = options.threads;
+  pid_t *pids;
+  ALLOC (pids, n);
+  int *fds;
+  ALLOC (fds, n);
+  CharStack buffer;
+  INIT (buffer);
+  for (unsigned first = 0; first < n; first += threads)
+    {
+      const unsigned last = MIN (first + threads, n);
+      fflush (stdout);
+      fflush (stderr);
+      for (unsigned i = first; i < last; i++)
+	{
+	  int pipefd[2];
+	  if (pipe (pipefd))
+	    die ("failed to open pipe for %s worker %u", name, i);
+	  pid_t pid = fork ();
+	  if (pid < 0)
+	    die ("failed to fork %s worker %u", name, i);
+	  if (!pid)
+	    {
+	      close (pipefd[0]);
+	      for (unsigned j = first; j < i; j++)
+		close (fds[j]);
+	      run (state, i, pipefd[1]);
+	      _exit (1);
+	    }
+	  close (pipefd[1]);
+	  pids[i] = pid;
+	  fds[i] = pipefd[0];
+	}
+      for (unsigned i = first; i < last; i++)
+	{
+	  FILE *file = fdopen (fds[i], "r");
+	  if (!file)
+	    die ("failed to read from %s worker %u", name, i);
+	  CLEAR (buffer);
+	  for (int ch; (ch = getc (file)) != EOF;)
+	    PUSH (buffer, ch);
+	  PUSH (buffer, 0);
+	  fclose (file);
+	  int status;
+	  if (waitpid (pids[i], &status, 0) != pids[i] || !WIFEXITED (status))
+	    die ("%s worker %u failed", name, i);
+	  const int exit_code = WEXITSTATUS (status);
+	  if (!handle (state, i, buffer.start, exit_code))
+	    die ("%s worker %u failed with exit code %d", name, i, exit_code);
+	}
+    }
+  RELEASE (buffer);
+  DEALLOC (fds, n);
+  DEALLOC (pids, n);
+}
+
+// Counting workers send back their count as one line.
+
+static void
+write_worker_count (Number count, int fd)
+{
+  FILE *file = fdopen (fd, "w");
+  if (!file)
+    _exit (1);
+  println_number_to_file (count, file);
+  fclose (file);
+  _exit (0);
+}
+
+static void
+parse_worker_count (Number res, const char *name, unsigned i, char *output)
+{
+  char *end = strchr (output, '\n');
+  if (end)
+    *end = 0;
+  if (!parse_number (res, output))
+    die ("%s worker %u returned invalid count '%s'", name, i, output);
+}
+
+/*------------------------------------------------------------------------*/
+
+// With '--decompose' and if the output is a conjunction, which can be
+// decomposed into components with disjoint input supports, then each
+// component is counted on its own with the BDD or SAT engine and the
+// counts are multiplied.  With more than one thread the components are
+// counted in parallel by forked workers, again sending back their counts
+// through pipes.  Relevant inputs which do not occur in any component
+// contribute a factor of two each.
+
+static void
+count_component (Number res, Component * d, IntStack * counted)
 {
+  Circuit *c = d->circuit;
+  IntStack *rel = COUNT (*counted) < COUNT (c->inputs) ? counted : 0;
   if (bdd)
     {
-      msg (1, "counting with BDD engine");
       init_bdds ();
-      BDD *b = simulate_primal ();
-      if (negate)
-	printf ("NUMBER FALSIFYING ASSIGNMENTS\n");
-      else
-	printf ("NUMBER SATISFYING ASSIGNMENTS\n");
-      fflush (stdout);
-      unsigned num_inputs = COUNT (primal_circuit->inputs);
-      if (num_inputs)
+      BDD *b = simulate_bdd (c, rel);
+      if (b)
 	{
-	  double start = process_time ();
-	  Number n;
-	  init_number (n);
-	  if (!relevant)
-	    init_relevant (num_inputs);
-	  count_bdd (n, b, relevant);
-	  double time = process_time ();
-	  double delta = time - start;
-	  msg (1,
-	       "BDD solution counting of primal circuit in %.3f seconds",
-	       delta);
-	  if (options.print)
-	    println_number (n), fflush (stdout);
-	  clear_number (n);
+	  count_bdd (res, b, counted);
+	  delete_bdd (b);
+	  reset_bdds ();
+	  return;
 	}
-      else
-	printf ("%d\n", is_true_bdd (b));
-      fflush (stdout);
-      delete_bdd (b);
-      reset_bdds ();
+      msg (1, "counting component with SAT engine since BDD limit reached");
     }
-  else if (options.primal)
+  if (options.primal)
+    count_with_primal_sat_engine (res, c, rel);
+  else
     {
-      msg (1, "counting with primal SAT engine");
-      CNF *cnf = new_cnf (0);
-      encode_circuit (primal_circuit, cnf);
-      msg (1, "primal CNF with %ld clauses", cnf->irredundant);
-      const int frozen = COUNT (primal_circuit->inputs);
-      variable_elimination (cnf, frozen);
-      IntStack inputs;
-      INIT (inputs);
-      get_encoded_inputs (primal_circuit, &inputs);
-      Solver *solver = new_solver (cnf, &inputs, relevant, 0);
-      if (limited)
-	limit_number_of_partial_models (solver, limit);
+      Circuit *dual = options.dualcircuit ? negate_circuit (c) : NOT (c);
+      count_with_dual_sat_engine (res, c, dual, rel);
+      if (!SIGN (dual))
+	delete_circuit (dual);
+    }
+}
+
+typedef struct ComponentCounts ComponentCounts;
+
+struct ComponentCounts
+{
+  Components *components;
+  IntStack *counted;
+  Number product;
+};
+
+static void
+component_count_worker (void *state, unsigned i, int fd)
+{
+  ComponentCounts *counts = state;
+  Number n;
+  init_number (n);
+  count_component (n, PEEK (*counts->components, i), counts->counted + i);
+  write_worker_count (n, fd);
+}
+
+static int
+multiply_component_count (void *state, unsigned i, char *output,
+			  int exit_code)
+{
+  if (exit_code)
+    return 0;
+  ComponentCounts *counts = state;
+  Number tmp;
+  init_number (tmp);
+  parse_worker_count (tmp, "component", i, output);
+  multiply_number (counts->product, tmp);
+  clear_number (tmp);
+  return 1;
+}
+
+static void
+parallel_count_components (Number res, Components * components,
+			   IntStack * counted)
+{
+  ComponentCounts counts;
+  counts.components = components;
+  counts.counted = counted;
+  init_number_from_unsigned (counts.product, 1);
+  run_workers ("component", COUNT (*components),
+	       component_count_worker, multiply_component_count, &counts);
+  multiply_number (res, counts.product);
+  clear_number (counts.product);
+}
+
+static int
+count_decomposed (Number res)
+{
+  Components components;
+  INIT (components);
+  const int n = decompose_circuit (primal_view (), &components);
+  if (!n)
+    return 0;
+  const double start = process_time ();
+  const int num_inputs = COUNT (primal_circuit->inputs);
+  char *free_input;
+  ALLOC (free_input, num_inputs + 1);
+  if (relevant)
+    for (const int *p = relevant->start; p != relevant->top; p++)
+      free_input[*p] = 1;
+  else
+    for (int i = 1; i <= num_inputs; i++)
+      free_input[i] = 1;
+  IntStack *counted;
+  ALLOC (counted, n);
+  for (int k = 0; k < n; k++)
+    {
+      Component *d = PEEK (components, k);
+      for (size_t i = 0; i < COUNT (d->inputs); i++)
+	{
+	  const int input = PEEK (d->inputs, i);
+	  if (free_input[input])
+	    PUSH (counted[k], i + 1);
+	  free_input[input] = 0;
+	}
+    }
+  long free_inputs = 0;
+  for (int i = 1; i <= num_inputs; i++)
+    free_inputs += free_input[i];
+  msg (1, "decomposed output into %d components "
+       "with disjoint support and %ld free inputs", n, free_inputs);
+  multiply_number_by_power_of_two (res, free_inputs);
+  if (options.threads > 1)
+    parallel_count_components (res, &components, counted);
+  else
+    for (int k = 0; k < n && !is_zero_number (res); k++)
+      {
+	Number tmp;
+	init_number (tmp);
+	count_component (tmp, PEEK (components, k), counted + k);
+	multiply_number (res, tmp);
+	clear_number (tmp);
+      }
+  msg (1, "counted %d components in %.3f seconds",
+       n, process_time () - start);
+  for (int k = 0; k < n; k++)
+    {
+      RELEASE (counted[k]);
+      delete_component (PEEK (components, k));
+    }
+  DEALLOC (counted, n);
+  RELEASE (components);
+  DEALLOC (free_input, num_inputs + 1);
+  return 1;
+}
+
+static int
+decomposable ()
+{
+  return options.decompose && !options.approximate && !limited &&
+    !shared_encoding && !bdd_file && !bdd_output_name && !trace_name &&
+    !visualize;
+}
+
+static int
+count_components ()
+{
+  Number res;
+  init_number_from_unsigned (res, 1);
+  const int decomposed = count_decomposed (res);
+  if (decomposed)
+    {
+      if (negate)
+	printf ("NUMBER FALSIFYING ASSIGNMENTS\n");
+      else
+	printf ("NUMBER SATISFYING ASSIGNMENTS\n");
+      if (options.print)
+	println_number (res);
+      fflush (stdout);
+    }
+  clear_number (res);
+  return decomposed;
+}
+
+/*------------------------------------------------------------------------*/
+
+// Parallel BDD counting simulates independent subcircuits concurrently.
+// With '--decompose' and an output, which decomposes into groups of
+// conjuncts with disjoint support (see 'count_decomposed' above), each
+// group is simulated and counted by its own forked worker and the counts
+// are multiplied.  Otherwise it splits on the top-most relevant inputs in
+// the BDD variable order and counts each cofactor in a separate forked
+// worker process, which has its own copy of the (global) BDD manager.
+// Workers send back their count as decimal number through a pipe.
+
+static void
+select_split_inputs (IntStack * split, unsigned k)
+{
+  const int num_inputs = COUNT (primal_circuit->inputs);
+  char *candidate;
+  ALLOC (candidate, num_inputs + 1);
+  if (relevant)
+    for (const int *p = relevant->start; p != relevant->top; p++)
+      candidate[*p] = 1;
+  else
+    for (int i = 1; i <= num_inputs; i++)
+      candidate[i] = 1;
+  IntStack order;
+  INIT (order);
+  if (options.bddorder)
+    order_circuit_inputs (primal_circuit, options.bddorder, &order);
+  else
+    for (int i = num_inputs; i > 0; i--)
+      PUSH (order, i);
+  for (const int *p = order.start; COUNT (*split) < k && p != order.top; p++)
+    if (candidate[*p])
+      PUSH (*split, *p);
+  RELEASE (order);
+  DEALLOC (candidate, num_inputs + 1);
+}
+
+// BDD workers exit with this code if they reach the BDD node limit.
+
+#define BDD_LIMIT_EXIT_CODE 2
+
+typedef struct Cofactors Cofactors;
+
+struct Cofactors
+{
+  IntStack *split;
+  Number sum;
+  int exhausted;
+};
+
+static void
+bdd_count_worker (void *state, unsigned cube, int fd)
+{
+  IntStack *split = ((Cofactors *) state)->split;
+  NEW (assumptions);
+  INIT (*assumptions);
+  for (unsigned i = 0; i < COUNT (*split); i++)
+    {
+      int var = PEEK (*split, i);
+      PUSH (*assumptions, (cube & (1u << i)) ? var : -var);
+    }
+  const int num_inputs = COUNT (primal_circuit->inputs);
+  char *counted;
+  ALLOC (counted, num_inputs + 1);
+  if (relevant)
+    for (const int *p = relevant->start; p != relevant->top; p++)
+      counted[*p] = 1;
+  else
+    for (int i = 1; i <= num_inputs; i++)
+      counted[i] = 1;
+  for (const int *p = split->start; p != split->top; p++)
+    counted[*p] = 0;
+  IntStack domain;
+  INIT (domain);
+  for (int i = 1; i <= num_inputs; i++)
+    if (counted[i])
+      PUSH (domain, i);
+  init_bdds ();
+  BDD *b = simulate_primal ();
+  if (!b)
+    _exit (BDD_LIMIT_EXIT_CODE);
+  Number n;
+  init_number (n);
+  count_bdd (n, b, &domain);
+  write_worker_count (n, fd);
+}
+
+static int
+add_cofactor_count (void *state, unsigned i, char *output, int exit_code)
+{
+  Cofactors *cofactors = state;
+  if (exit_code == BDD_LIMIT_EXIT_CODE)
+    {
+      msg (1, "BDD worker %u reached BDD node limit", i);
+      cofactors->exhausted = 1;
+      return 1;
+    }
+  if (exit_code)
+    return 0;
+  if (cofactors->exhausted)
+    return 1;
+  Number tmp;
+  init_number (tmp);
+  parse_worker_count (tmp, "BDD", i, output);
+  add_number (cofactors->sum, tmp);
+  clear_number (tmp);
+  return 1;
+}
+
+static int
+parallel_count_bdd (Number res)
+{
+  if (decomposable ())
+    {
+      Number product;
+      init_number_from_unsigned (product, 1);
+      const int decomposed = count_decomposed (product);
+      if (decomposed)
+	add_number (res, product);
+      clear_number (product);
+      if (decomposed)
+	return 1;
+    }
+  unsigned k = 0;
+  while (k < 16 && (2u << k) <= (unsigned) options.threads)
+    k++;
+  IntStack split;
+  INIT (split);
+  select_split_inputs (&split, k);
+  k = COUNT (split);
+  const unsigned workers = 1u << k;
+  msg (1, "counting %u cofactors in parallel splitting on %u inputs",
+       workers, k);
+  Cofactors cofactors;
+  cofactors.split = &split;
+  init_number (cofactors.sum);
+  cofactors.exhausted = 0;
+  run_workers ("BDD", workers,
+	       bdd_count_worker, add_cofactor_count, &cofactors);
+  const int exhausted = cofactors.exhausted;
+  if (!exhausted)
+    add_number (res, cofactors.sum);
+  clear_number (cofactors.sum);
+  RELEASE (split);
+  return !exhausted;
+}
+
+static void
+sample ()
+{
+  assert (bdd);
+  assert (options.sample > 0);
+  msg (1, "sampling with BDD engine");
+  init_bdds ();
+  BDD *b = simulate_primal ();
+  if (!b)
+    die ("can not sample since BDD node limit reached");
+  if (negate)
+    printf ("SAMPLED FALSIFYING ASSIGNMENTS\n");
+  else
+    printf ("SAMPLED SATISFYING ASSIGNMENTS\n");
+  fflush (stdout);
+  if (!relevant)
+    init_relevant (COUNT (primal_circuit->inputs));
+  Name n = construct_name (primal_circuit, (GetName) name_circuit_input);
+  double start = process_time ();
+  sample_bdd (b, relevant, options.sample, options.seed, n);
+  fflush (stdout);
+  msg (1, "sampled %d assignments in %.3f seconds",
+       options.sample, process_time () - start);
+  delete_bdd (b);
+  reset_bdds ();
+}
+
+// The circuit is simulated once without projection and the resulting BDD
+// is kept alive while projecting and counting it for each set in turn.
+
+static void
+count_projections ()
+{
+  msg (1, "counting projections with BDD engine");
+  init_bdds ();
+  BDD *b = simulate_primal ();
+  if (!b)
+    die ("can not count projections since BDD node limit reached");
+  if (negate)
+    printf ("NUMBER FALSIFYING ASSIGNMENTS\n");
+  else
+    printf ("NUMBER SATISFYING ASSIGNMENTS\n");
+  fflush (stdout);
+  double start = process_time ();
+  IntStack set;
+  INIT (set);
+  long counted = 0;
+  for (const int *p = projections.start; p != projections.top; p++)
+    {
+      if (*p)
+	{
+	  PUSH (set, *p);
+	  continue;
+	}
+      BDD *projected = project_bdd (b, &set);
+      if (options.approximate)
+	{
+	  double log2_count = approximate_count_bdd (projected, &set);
+	  if (options.print)
+	    print_approximate_count (log2_count);
+	}
+      else
+	{
+	  Number n;
+	  init_number (n);
+	  count_bdd (n, projected, &set);
+	  if (options.print)
+	    println_number (n);
+	  clear_number (n);
+	}
+      fflush (stdout);
+      delete_bdd (projected);
+      CLEAR (set);
+      counted++;
+    }
+  RELEASE (set);
+  msg (1, "counted %ld projections in %.3f seconds",
+       counted, process_time () - start);
+  delete_bdd (b);
+  reset_bdds ();
+}
+
+static void
+count ()
+{
+  if (bdd && options.threads > 1 && !options.approximate &&
+      !bdd_file && !bdd_output_name && !trace_name &&
+      !EMPTY (primal_circuit->inputs))
+    {
+      msg (1, "counting with %d parallel BDD workers", options.threads);
+      Number n;
+      init_number (n);
+      int counted = parallel_count_bdd (n);
+      if (counted)
+	{
+	  if (negate)
+	    printf ("NUMBER FALSIFYING ASSIGNMENTS\n");
+	  else
+	    printf ("NUMBER SATISFYING ASSIGNMENTS\n");
+	  if (options.print)
+	    println_number (n);
+	  fflush (stdout);
+	}
+      clear_number (n);
+      if (counted)
+	return;
+      fall_back_to_sat_engine ();
+    }
+  if (decomposable () && count_components ())
+    return;
+  if (bdd)
+    msg (1, "counting with BDD engine");
+  BDD *b = simulate_primal_or_fall_back ();
+  if (b)
+    {
+      if (negate)
+	printf ("NUMBER FALSIFYING ASSIGNMENTS\n");
+      else
+	printf ("NUMBER SATISFYING ASSIGNMENTS\n");
+      fflush (stdout);
+      unsigned num_inputs = COUNT (primal_circuit->inputs);
+      if (num_inputs)
+	{
+	  double start = process_time ();
+	  if (!relevant)
+	    init_relevant (num_inputs);
+	  if (options.approximate)
+	    {
+	      double log2_count = approximate_count_bdd (b, relevant);
+	      double time = process_time ();
+	      double delta = time - start;
+	      msg (1,
+		   "approximate BDD solution counting of primal circuit "
+		   "in %.3f seconds", delta);
+	      if (options.print)
+		print_approximate_count (log2_count), fflush (stdout);
+	    }
+	  else
+	    {
+	      Number n;
+	      init_number (n);
+	      count_bdd (n, b, relevant);
+	      double time = process_time ();
+	      double delta = time - start;
+	      msg (1,
+		   "BDD solution counting of primal circuit in %.3f seconds",
+		   delta);
+	      if (options.print)
+		println_number (n), fflush (stdout);
+	      clear_number (n);
+	    }
+	}
+      else
+	printf ("%d\n", is_true_bdd (b));
+      fflush (stdout);
+      delete_bdd (b);
+      reset_bdds ();
+    }
+  else if (options.primal)
+    {
+      msg (1, "counting with primal SAT engine");
       Number n;
       init_number (n);
-      primal_count (n, solver);
+      count_with_primal_sat_engine (n, primal_view (), relevant);
       if (negate)
 	printf ("NUMBER FALSIFYING ASSIGNMENTS\n");
       else
@@ -835,30 +1907,13 @@ count ()
       if (options.print)
 	println_number (n), fflush (stdout);
       clear_number (n);
-      delete_solver (solver);
-      RELEASE (inputs);
-      delete_cnf (cnf);
     }
   else
     {
       msg (1, "counting with dual SAT engine");
-      CNF *primal_cnf = new_cnf (0);
-      CNF *dual_cnf = new_cnf (1);
-      encode_circuits (primal_circuit, dual_circuit, primal_cnf, dual_cnf);
-      msg (1, "primal CNF with %ld clauses", primal_cnf->irredundant);
-      msg (1, "dual CNF with %ld clauses", dual_cnf->irredundant);
-      const int frozen = COUNT (primal_circuit->inputs);
-      variable_elimination (primal_cnf, frozen);
-      variable_elimination (dual_cnf, frozen);
-      IntStack inputs;
-      INIT (inputs);
-      get_encoded_inputs (primal_circuit, &inputs);
-      Solver *solver = new_solver (primal_cnf, &inputs, relevant, dual_cnf);
-      if (limited)
-	limit_number_of_partial_models (solver, limit);
       Number n;
       init_number (n);
-      dual_count (n, solver);
+      count_with_dual_sat_engine (n, primal_view (), dual_view (), relevant);
       if (negate)
 	printf ("NUMBER FALSIFYING ASSIGNMENTS\n");
       else
@@ -867,17 +1922,16 @@ count ()
       if (options.print)
 	println_number (n), fflush (stdout);
       clear_number (n);
-      delete_solver (solver);
-      RELEASE (inputs);
-      delete_cnf (primal_cnf);
-      delete_cnf (dual_cnf);
     }
 }
 
 static void
 init ()
 {
-  generate_dual_circuit ();
+  if (bdd_file)
+    msg (1, "no dual circuit needed for BDD file");
+  else
+    generate_dual_circuit ();
 }
 
 static void
@@ -889,6 +1943,12 @@ reset ()
     delete_circuit (dual_circuit);
   if (symbols)
     delete_symbols (symbols);
+  if (trace_file)
+    {
+      if (fclose (trace_file))
+	die ("failed to close trace file '%s'", trace_name);
+      msg (1, "closed trace file '%s'", trace_name);
+    }
   if (relevant)
     {
       RELEASE (*relevant);
@@ -899,6 +1959,7 @@ reset ()
       RELEASE (*relevant_ints);
       DELETE (relevant_ints);
     }
+  RELEASE (projections);
   if (relevant_strs)
     {
       while (!EMPTY (*relevant_strs))
@@ -911,6 +1972,136 @@ reset ()
     }
 }
 
+static int
+solve_circuit (const char *output_name)
+{
+  int res = 0;
+  if (checking)
+    res = check ();
+  else if (printing)
+    print (output_name);
+  else if (enumerate)
+    all ();
+  else if (options.sample)
+    sample ();
+  else if (projections_name)
+    count_projections ();
+  else
+    count ();
+  return res;
+}
+
+static int
+solve (const char *output_name)
+{
+  flatten ();
+  fraig ();
+  init ();
+  return solve_circuit (output_name);
+}
+
+/*------------------------------------------------------------------------*/
+
+// An AIGER file with several outputs is parsed, structurally hashed,
+// flattened and swept only once.  If the SAT engines are used, the gates
+// in the cones of all outputs are also encoded only once (see
+// 'encode_shared_gates').  Then each output is solved by a forked worker,
+// which selects its output in the shared circuit, adds its root clauses to
+// the shared CNFs and continues as for a single output.  Learned clauses
+// are not shared.  Up to 'threads' workers run in parallel.  Their
+// standard output is captured through pipes and printed in the order of
+// the outputs after an 'output <i>' comment line.  The exit code is the
+// common exit code of all outputs or zero otherwise.
+
+static int
+share_encoding ()
+{
+  if (bdd || bdd_file || options.dualcircuit)
+    return 0;
+  if (checking)
+    return 1;
+  return counting && !options.sample && !projections_name;
+}
+
+typedef struct Outputs Outputs;
+
+struct Outputs
+{
+  const char *output_name;
+  int res;
+};
+
+static void
+output_worker (void *state, unsigned i, int fd)
+{
+  if (dup2 (fd, 1) < 0)
+    _exit (1);
+  close (fd);
+  primal_circuit->output = PEEK (primal_circuit->outputs, i);
+  CLEAR (primal_circuit->outputs);
+  msg (1, "solving output %u", i);
+  if (!shared_encoding)
+    init ();
+  const int res = solve_circuit (((Outputs *) state)->output_name);
+  fflush (stdout);
+  fflush (stderr);
+  _exit (res);
+}
+
+static int
+print_output_of_worker (void *state, unsigned i, char *output, int exit_code)
+{
+  printf ("%soutput %u\n", message_prefix, i);
+  fputs (output, stdout);
+  fflush (stdout);
+  if (exit_code && exit_code != 10 && exit_code != 20)
+    return 0;
+  Outputs *outputs = state;
+  if (outputs->res < 0)
+    outputs->res = exit_code;
+  else if (outputs->res != exit_code)
+    outputs->res = 0;
+  return 1;
+}
+
+static int
+solve_outputs (const char *output_name)
+{
+  const unsigned n = COUNT (primal_circuit->outputs);
+  if (output_name)
+    die ("can not print %u AIGER outputs to one file '%s'", n, output_name);
+  if (bdd_output_name)
+    die ("can not write BDDs of %u AIGER outputs to '%s'",
+	 n, bdd_output_name);
+  if (trace_name)
+    die ("can not trace %u AIGER outputs to '%s'", n, trace_name);
+  flatten ();
+  fraig ();
+  if (share_encoding ())
+    {
+      init ();
+      Circuit *first = tautology ? dual_view () : primal_view ();
+      Circuit *second = 0;
+      if (!options.primal)
+	second = tautology ? primal_view () : dual_view ();
+      shared_encoding = encode_shared_gates (first, second);
+    }
+  msg (1, "solving %u outputs with up to %u parallel workers",
+       n, options.threads);
+  Outputs outputs;
+  outputs.output_name = output_name;
+  outputs.res = -1;
+  run_workers ("output", n, output_worker, print_output_of_worker, &outputs);
+  if (shared_encoding)
+    {
+      delete_encoding (shared_encoding);
+      shared_encoding = 0;
+    }
+  return outputs.res;
+}
+
+/*------------------------------------------------------------------------*/
+
 static void
 setup_messages (const char *output_name)
 {
@@ -1103,6 +2294,104 @@ parse_relevant_variables (const char *arg)
 
 /*------------------------------------------------------------------------*/
 
+// Each line of the projections file is parsed into a set of relevant
+// input indices (starting at one) terminated by zero.  Variables are
+// resolved as for '-r' but after parsing the input.
+
+static void
+parse_projection (char *line, int lineno)
+{
+  const int num_inputs = COUNT (primal_circuit->inputs);
+  const size_t start = COUNT (projections);
+  for (char *p = line, *end; *p; p = end + 1)
+    {
+      for (end = p; *end && *end != ','; end++)
+	;
+      if (p == end)
+	die ("empty variable in line %d of '%s'", lineno, projections_name);
+      const int last = !*end;
+      *end = 0;
+      int idx;
+      if (isdigit (*p))
+	{
+	  if (info == FORMULA)
+	    die ("integer '%s' in line %d of '%s' for formula",
+		 p, lineno, projections_name);
+	  if (!is_non_negative_number_string (p))
+	    die ("invalid integer '%s' in line %d of '%s'",
+		 p, lineno, projections_name);
+	  long n = parse_non_negative_number (p);
+	  if (n > INT_MAX - 1)
+	    die ("integer '%s' in line %d of '%s' too large",
+		 p, lineno, projections_name);
+	  idx = n + (info == AIGER);
+	  if (!idx || idx > num_inputs)
+	    die ("invalid variable '%s' in line %d of '%s'",
+		 p, lineno, projections_name);
+	}
+      else
+	{
+	  if (info == DIMACS || info == AIGER)
+	    die ("symbol '%s' in line %d of '%s' for %s file",
+		 p, lineno, projections_name,
+		 info == DIMACS ? "DIMACS" : "AIGER");
+	  Symbol *s = find_symbol (symbols, p);
+	  if (!s || !s->gate || s->gate->op != INPUT_OPERATOR)
+	    die ("unknown variable '%s' in line %d of '%s'",
+		 p, lineno, projections_name);
+	  idx = s->gate->input + 1;
+	}
+      PUSH (projections, idx);
+      if (last)
+	break;
+    }
+  int *begin = projections.start + start, *q = begin;
+  qsort (begin, projections.top - begin, sizeof *begin, cmp_ints);
+  for (int *r = begin; r != projections.top; r++)
+    if (q == begin || q[-1] != *r)
+      *q++ = *r;
+  projections.top = q;
+  PUSH (projections, 0);
+}
+
+static void
+parse_projections ()
+{
+  if (!projections_name)
+    return;
+  if (relevant)
+    die ("can not combine '-p' with relevant variables in input");
+  FILE *file = fopen (projections_name, "r");
+  if (!file)
+    die ("can not read projections file '%s'", projections_name);
+  CharStack line;
+  INIT (line);
+  int lineno = 0, sets = 0, ch;
+  do
+    {
+      ch = getc (file);
+      if (ch != '\n' && ch != EOF)
+	{
+	  if (!isspace (ch))
+	    PUSH (line, ch);
+	  continue;
+	}
+      lineno++;
+      if (EMPTY (line))
+	continue;
+      PUSH (line, 0);
+      parse_projection (line.start, lineno);
+      CLEAR (line);
+      sets++;
+    }
+  while (ch != EOF);
+  RELEASE (line);
+  fclose (file);
+  msg (1, "parsed %d projections from '%s'", sets, projections_name);
+}
+
+/*------------------------------------------------------------------------*/
+
 int
 main (int argc, char **argv)
 {
@@ -1169,6 +2458,32 @@ main (int argc, char **argv)
 	  if (!parse_option (argv[i]))
 	    die ("invalid long option '%s'", argv[i]);
 	}
+      else if (!strcmp (argv[i], "-w"))
+	{
+	  if (++i == argc)
+	    die ("BDD file argument to '-w' missing'");
+	  if (bdd_output_name)
+	    die ("multiple BDD files '%s' and '%s'", bdd_output_name,
+		 argv[i]);
+	  bdd_output_name = argv[i];
+	}
+      else if (!strcmp (argv[i], "-j"))
+	{
+	  if (++i == argc)
+	    die ("trace file argument to '-j' missing'");
+	  if (trace_name)
+	    die ("multiple trace files '%s' and '%s'", trace_name, argv[i]);
+	  trace_name = argv[i];
+	}
+      else if (!strcmp (argv[i], "-p"))
+	{
+	  if (++i == argc)
+	    die ("projections file argument to '-p' missing'");
+	  if (projections_name)
+	    die ("multiple projections files '%s' and '%s'",
+		 projections_name, argv[i]);
+	  projections_name = argv[i];
+	}
       else if (!strcmp (argv[i], "-o"))
 	{
 	  if (++i == argc)
@@ -1195,6 +2510,12 @@ main (int argc, char **argv)
   if (options.logging)
     options.verbosity = INT_MAX;
 #endif
+  if (input_name && is_bdd_file (input_name))
+    {
+      bdd_file = input_name;
+      if (!bdd)
+	bdd = 1;
+    }
   check_options (output_name);
   setup_messages (output_name);
   msg (1, "Dualiza #SAT Solver");
@@ -1204,19 +2525,21 @@ main (int argc, char **argv)
   init_mode ();
   set_signal_handlers ();
   print_options ();
+  if (trace_name)
+    {
+      if (!(trace_file = fopen (trace_name, "w")))
+	die ("can not write trace file '%s'", trace_name);
+      msg (1, "tracing simulation of gates to '%s'", trace_name);
+      trace_simulation (trace_file);
+    }
   parse (input_name);
-  flatten ();
+  parse_projections ();
   delete_reader (input);
-  init ();
-  int res = 0;
-  if (checking)
-    res = check ();
-  else if (printing)
-    print (output_name);
-  else if (enumerate)
-    all ();
+  int res;
+  if (primal_circuit && COUNT (primal_circuit->outputs) > 1)
+    res = solve_outputs (output_name);
   else
-    count ();
+    res = solve (output_name);
   reset ();
   reset_signal_handlers ();
   print_rules ();
@@ -1,72 +1,52 @@
 #include "headers.h"
 
 static Gate *
-copy_input_gate_and_share_symbol (Gate * g, Circuit * c)
+negated_gate (Gate * g, Gate ** map)
 {
-  Gate *res = new_input_gate (c);
-  Symbol *s = g->symbol;
-  if (s)
-    {
-      res->symbol = s;
-      assert (s->name);
-      LOG ("sharing input %d gate %d symbol '%s'",
-	   res->input, res->idx, s->name);
-    }
+  const int sign = SIGN (g);
+  if (sign)
+    g = NOT (g);
+  Gate *res = map[g->idx];
+  assert (res);
+  if (sign)
+    res = NOT (res);
   return res;
 }
 
-static Gate *
+// Gates are negated in topological order, thus their inputs are already
+// negated and no recursion is needed.
+
+static void
 negate_gate (Gate * g, Gate ** map, Circuit * c)
 {
-  const int sign = SIGN (g);
-  if (sign)
-    g = NOT (g);
-  Gate *res = map[g->idx];
-  if (!res)
+  assert (!SIGN (g));
+  assert (!map[g->idx]);
+  Gate *res;
+  if (g->op == FALSE_OPERATOR)
+    res = NOT (new_false_gate (c));
+  else if (g->op == INPUT_OPERATOR)
+    res = NOT (copy_input_gate_and_share_symbol (g, c));
+  else
     {
-      if (g->op == FALSE_OPERATOR)
-	res = NOT (new_false_gate (c));
-      else if (g->op == INPUT_OPERATOR)
-	res = NOT (copy_input_gate_and_share_symbol (g, c));
-      else
+      const Operator op = dual_operator (g->op);
+      Gates inputs;
+      INIT (inputs);
+      if (op == ITE_OPERATOR)
 	{
-	  if (g->op == ITE_OPERATOR)
-	    {
-	      res = new_ite_gate (c);
-	      Gate **inputs = g->inputs.start;
-	      // IMPORTANT: do not change the order here!!!!
-	      connect_gates (negate_gate (inputs[0], map, c), res);
-	      connect_gates (negate_gate (inputs[2], map, c), res);
-	      connect_gates (negate_gate (inputs[1], map, c), res);
-	    }
-	  else
-	    {
-	      switch (g->op)
-		{
-		default:
-		  assert (g->op == AND_OPERATOR);	// fall through
-		case AND_OPERATOR:
-		  res = new_or_gate (c);
-		  break;
-		case XOR_OPERATOR:
-		  res = new_xnor_gate (c);
-		  break;
-		case OR_OPERATOR:
-		  res = new_and_gate (c);
-		  break;
-		case XNOR_OPERATOR:
-		  res = new_xor_gate (c);
-		  break;
-		}
-	      for (Gate ** p = g->inputs.start; p != g->inputs.top; p++)
-		connect_gates (negate_gate (*p, map, c), res);
-	    }
+	  Gate **p = g->inputs.start;
+	  // The dual of 'ITE (c, t, e)' is 'ITE (!c, !e, !t)', since the
+	  // condition is negated too, and thus the branches are swapped.
+	  PUSH (inputs, negated_gate (p[0], map));
+	  PUSH (inputs, negated_gate (p[2], map));
+	  PUSH (inputs, negated_gate (p[1], map));
 	}
-      map[g->idx] = res;
+      else
+	for (Gate ** p = g->inputs.start; p != g->inputs.top; p++)
+	  PUSH (inputs, negated_gate (*p, map));
+      res = new_hashed_gate (c, op, &inputs);
+      RELEASE (inputs);
     }
-  if (sign)
-    res = NOT (res);
-  return res;
+  map[g->idx] = res;
 }
 
 Circuit *
@@ -79,8 +59,8 @@ negate_circuit (Circuit * c)
   Gate **map;
   ALLOC (map, num_gates);
   for (Gate ** p = c->gates.start; p < c->gates.top; p++)
-    (void) negate_gate (*p, map, res);
-  Gate *o = negate_gate (c->output, map, res);
+    negate_gate (*p, map, res);
+  Gate *o = negated_gate (c->output, map);
   connect_output (res, o);
   DEALLOC (map, num_gates);
   return res;
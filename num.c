@@ -80,6 +80,12 @@ sub_number (Number res, const Number other)
   mpz_sub (res, res, other);
 }
 
+void
+multiply_number (Number res, const Number other)
+{
+  mpz_mul (res, res, other);
+}
+
 void
 print_number_to_file (Number n, FILE * file)
 {
@@ -339,6 +345,42 @@ sub_number (Number res, const Number other)
   normalize_number (res);
 }
 
+// School book multiplication, which suffices for the few products of
+// component counts.
+
+void
+multiply_number (Number res, const Number other)
+{
+  const unsigned m = COUNT (res[0]), n = COUNT (other[0]);
+  if (!m)
+    return;
+  if (!n)
+    {
+      CLEAR (res[0]);
+      return;
+    }
+  unsigned *product;
+  ALLOC (product, m + n);
+  const unsigned *a = res[0].start, *b = other[0].start;
+  for (unsigned i = 0; i < m; i++)
+    {
+      uint64_t carry = 0;
+      for (unsigned j = 0; j < n; j++)
+	{
+	  carry += (uint64_t) a[i] * b[j] + product[i + j];
+	  product[i + j] = (unsigned) carry;
+	  carry >>= 32;
+	}
+      product[i + n] = (unsigned) carry;
+    }
+  CLEAR (res[0]);
+  RESERVE (res[0], m + n);
+  memcpy (res[0].start, product, (m + n) * sizeof *product);
+  res[0].top = res[0].start + m + n;
+  DEALLOC (product, m + n);
+  normalize_number (res);
+}
+
 void
 print_number_to_file (Number n, FILE * file)
 {
@@ -351,7 +393,7 @@ print_number_to_file (Number n, FILE * file)
   INIT (stack);
   print_number_to_stack (n, &stack);
   while (!EMPTY (stack))
-    fputc (POP (stack), stdout);
+    fputc (POP (stack), file);
   RELEASE (stack);
 }
 
@@ -365,6 +407,29 @@ inc_number (Number n)
   add_power_of_two_to_number (n, 0);
 }
 
+// Parses a non-negative decimal number as printed by 'print_number_to_file'
+// and returns zero if the string is not such a number.
+
+int
+parse_number (Number res, const char *str)
+{
+  Number tmp;
+  init_number (tmp);
+  copy_number (res, tmp);
+  const char *p = str;
+  for (int ch; (ch = *p) && isdigit (ch); p++)
+    {
+      copy_number (tmp, res);
+      multiply_number_by_power_of_two (res, 2);
+      add_number (res, tmp);
+      multiply_number_by_power_of_two (res, 1);
+      for (int digit = ch - '0'; digit; digit--)
+	inc_number (res);
+    }
+  clear_number (tmp);
+  return p != str && !*p;
+}
+
 void
 println_number_to_file (Number n, FILE * file)
 {
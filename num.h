@@ -25,9 +25,12 @@ void sub_power_of_two_from_number (Number, Exponent);
 
 void add_number (Number, const Number);
 void sub_number (Number, const Number);
+void multiply_number (Number, const Number);
 
 void print_number_to_file (Number, FILE *);
 void println_number_to_file (Number, FILE *);
 void println_number (Number);
 
+int parse_number (Number, const char *);
+
 #endif
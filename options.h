@@ -6,9 +6,14 @@
 #define OPTIONS_ALL \
  \
 OPTION (annotate,     0, "annotate generated") \
+OPTION (approximate,  0, "approximate BDD count in floating point") \
+OPTION (bddlimit,     0, "BDD node limit before falling back to SAT") \
+OPTION (bddorder,     0, "static BDD order (1=DFS,2=FORCE,3=interleave)") \
+OPTION (binary,       0, "enumerate BDD cubes in dense binary format") \
 OPTION (block,        1, "use blocking clauses") \
 OPTION (bump,         1, "bump variables (1=resolved, 2=reason)") \
 OPTION (blocklimit,   2, "blocking clause size limit") \
+OPTION (decompose,    0, "count disjoint-support conjuncts separately") \
 DBGOPT (check,        0, "enable expensive assertion checking") \
 OPTION (elim,         1, "enabled bounded variable elimination") \
 OPTION (elimclslim, 100, "clause size limit for variable elimination") \
@@ -16,10 +21,22 @@ OPTION (elimocclim,  10, "occurrence limit for variable elimination") \
 OPTION (discount,     1, "discount models instead of backtracking") \
 OPTION (discountmax,  0, "maximum number of discounted models") \
 OPTION (dual,         1, "enable dual SAT engine (opposite of '--primal')") \
+OPTION (dualcircuit,  0, "negate circuit instead of encoding it negated") \
 OPTION (flatten,      1, "flatten circuit before encoding") \
+OPTION (fraig,        0, "SAT sweep circuit after flattening") \
+OPTION (fraigcalls, 1e3, "SAT call limit for sweeping") \
+OPTION (fraigcone,  1e3, "miter cone size limit for sweeping") \
+OPTION (fraigwords,   4, "random simulation words for sweeping (1-8)") \
+OPTION (gates,        0, "extract gate definitions from DIMACS") \
+OPTION (hybrid,       0, "count small residual CNFs with BDDs") \
+OPTION (hybridcls,  100, "residual clause limit for hybrid counting") \
+OPTION (hybridnodes,1e5, "BDD node limit for hybrid counting") \
+OPTION (hybridvars,  20, "unassigned relevant variable limit for hybrid") \
 OPTION (keepglue,     3, "keep all clause of this glue") \
 OPTION (keepsize,     3, "keep all clause of this size") \
 OPTION (learn,        1, "learn clauses") \
+OPTION (lut,          0, "encode LUTs with at most this many inputs (max 6)") \
+OPTION (lutcuts,      8, "priority cuts per gate for LUT mapping") \
 OPTION (phaseinit,    1, "initial default phase") \
 OPTION (primal,       0, "primal SAT engine only (opposite of '--dual')") \
 OPTION (print,        1, "print model or number of all assignments") \
@@ -28,14 +45,23 @@ OPTION (reduceinc,  300, "reduce interval increment") \
 OPTION (reduceinit, 2e3, "initial reduce interval") \
 OPTION (polarity,     1, "use polarity based CNF encoding (2=force)") \
 OPTION (project,      1, "project on relevant variables") \
+OPTION (quantify,     1, "early quantification in BDD simulation") \
 OPTION (relevant,     0, "always split on relevant variables first") \
 OPTION (restart,      1, "enable search restarts") \
 OPTION (restartint,   2, "base restart interval") \
 OPTION (reuse,        1, "reuse trail during restart") \
+OPTION (sample,       0, "sample uniformly this many BDD assignments") \
+OPTION (schedule,     1, "schedule large BDD conjunctions by support") \
+OPTION (seed,         0, "random seed for sampling and simulation") \
+OPTION (simrounds,    0, "random simulation rounds before checking") \
+OPTION (simwords,     8, "words of 64 patterns per simulation round (1-8)") \
 OPTION (subsume,      1, "clause subsumption") \
 OPTION (sublearned,   1, "eager subsume learned clause subsumption") \
 OPTION (sublearnlim,  4, "limit on number of non-subsumed clauses")  \
+OPTION (threads,      1, "number of parallel workers") \
 OPTION (verbosity,    0, "verbose level") \
+OPTION (xor,          0, "encode XOR gates as native XOR constraints") \
+OPTION (zdd,          0, "enumerate models through ZDD (1=sets, 2=export)") \
 
 // *INDENT-ON*
 
@@ -0,0 +1,465 @@
+#include "headers.h"
+
+// Static BDD variable ordering heuristics computed from the circuit
+// structure before simulation.  All of them produce a list of external
+// BDD variables (input index plus one) ordered from the root to the
+// leaves.  Inputs which are not reached from the output are appended
+// at the end in input order.
+
+/*------------------------------------------------------------------------*/
+
+static int *
+compute_gate_depths (Circuit * c)
+{
+  const int n = COUNT (c->gates);
+  int *depth;
+  ALLOC (depth, n);
+  for (Gate ** p = c->gates.start; p != c->gates.top; p++)
+    {
+      Gate *g = *p;
+      int max_input_depth = -1;
+      for (Gate ** q = g->inputs.start; q != g->inputs.top; q++)
+	{
+	  Gate *h = STRIP (*q);
+	  assert (h->idx < g->idx);
+	  if (depth[h->idx] > max_input_depth)
+	    max_input_depth = depth[h->idx];
+	}
+      depth[g->idx] = max_input_depth + 1;
+    }
+  return depth;
+}
+
+static int *sorting_depth;
+
+static int
+cmp_deeper_gate_first (const void *p, const void *q)
+{
+  Gate *g = STRIP (*(Gate **) p), *h = STRIP (*(Gate **) q);
+  int i = sorting_depth[g->idx], j = sorting_depth[h->idx];
+  if (i != j)
+    return j - i;
+  return g->idx - h->idx;
+}
+
+// Both depth-first traversals below use an explicit stack of visits of
+// gate indices.  When a gate is visited its inputs are pushed on the
+// 'gates' stack sorted with the deeper inputs first.  Only the segment of
+// the top-most visit is at the end of that stack, thus the 'next' input of
+// a visit is found relative to the top of 'gates'.
+
+static void
+push_sorted_visit (Visits * visits, Gates * gates, Gate * g, int *depth)
+{
+  assert (!SIGN (g));
+  push_visit (visits, g->idx);
+  const size_t n = COUNT (g->inputs);
+  const size_t start = COUNT (*gates);
+  for (Gate ** p = g->inputs.start; p != g->inputs.top; p++)
+    PUSH (*gates, *p);
+  sorting_depth = depth;
+  qsort (gates->start + start, n, sizeof (Gate *), cmp_deeper_gate_first);
+}
+
+static Gate *
+next_sorted_input (Circuit * c, Visits * visits, Gates * gates)
+{
+  Visit *visit = visits->top - 1;
+  Gate *g = PEEK (c->gates, visit->lit);
+  assert (g->idx == (int) visit->lit);
+  const size_t n = COUNT (g->inputs);
+  if (visit->next < n)
+    {
+      const size_t i = COUNT (*gates) - n + visit->next++;
+      return STRIP (PEEK (*gates, i));
+    }
+  visits->top--;
+  assert (COUNT (*gates) >= n);
+  RESIZE (*gates, COUNT (*gates) - n);
+  return 0;
+}
+
+static void
+dfs_order_input (Gate * g, IntStack * order)
+{
+  assert (g->op == INPUT_OPERATOR);
+  LOG ("DFS order position %" PRz " input %d", COUNT (*order), g->input);
+  PUSH (*order, g->input + 1);
+}
+
+static void
+dfs_order_gate (Circuit * c, Gate * g, int *depth, char *visited,
+		Visits * visits, Gates * gates, IntStack * order)
+{
+  g = STRIP (g);
+  if (visited[g->idx])
+    return;
+  visited[g->idx] = 1;
+  if (g->op == INPUT_OPERATOR)
+    {
+      dfs_order_input (g, order);
+      return;
+    }
+  assert (EMPTY (*visits));
+  push_sorted_visit (visits, gates, g, depth);
+  while (!EMPTY (*visits))
+    {
+      Gate *h = next_sorted_input (c, visits, gates);
+      if (!h || visited[h->idx])
+	continue;
+      visited[h->idx] = 1;
+      if (h->op == INPUT_OPERATOR)
+	dfs_order_input (h, order);
+      else
+	push_sorted_visit (visits, gates, h, depth);
+    }
+  assert (EMPTY (*gates));
+}
+
+static void
+append_unordered_inputs (Circuit * c, IntStack * order)
+{
+  const int n = COUNT (c->inputs);
+  char *ordered;
+  ALLOC (ordered, n + 1);
+  for (const int *p = order->start; p != order->top; p++)
+    {
+      assert (0 < *p), assert (*p <= n);
+      assert (!ordered[*p]);
+      ordered[*p] = 1;
+    }
+  for (int idx = 1; idx <= n; idx++)
+    if (!ordered[idx])
+      {
+	LOG ("appending unreached input %d", idx - 1);
+	PUSH (*order, idx);
+      }
+  DEALLOC (ordered, n + 1);
+  assert (COUNT (*order) == n);
+}
+
+// Fanin depth-first search from the output visiting deeper inputs first
+// (the classic heuristic of Fujita, Fujisawa and Kawato).
+
+static void
+dfs_order (Circuit * c, IntStack * order)
+{
+  const int n = COUNT (c->gates);
+  int *depth = compute_gate_depths (c);
+  char *visited;
+  ALLOC (visited, n);
+  Visits visits;
+  Gates gates;
+  INIT (visits);
+  INIT (gates);
+  dfs_order_gate (c, c->output, depth, visited, &visits, &gates, order);
+  RELEASE (gates);
+  RELEASE (visits);
+  DEALLOC (visited, n);
+  DEALLOC (depth, n);
+  append_unordered_inputs (c, order);
+}
+
+/*------------------------------------------------------------------------*/
+
+// FORCE placement (Aloul, Markov and Sakallah) of all gates on a line.
+// Every non-input gate together with its inputs forms a hyper-edge.
+// In each round a gate is moved to the average center of gravity of
+// the hyper-edges it is contained in.  The initial placement is the DFS
+// order and rounds are stopped as soon as the total span does not
+// decrease anymore.
+
+typedef struct Placed Placed;
+
+struct Placed
+{
+  double pos;
+  Gate *gate;
+};
+
+#define MAX_FORCE_ROUNDS 32
+
+static int
+cmp_placed (const void *p, const void *q)
+{
+  const Placed *a = p, *b = q;
+  if (a->pos < b->pos)
+    return -1;
+  if (a->pos > b->pos)
+    return 1;
+  return a->gate->idx - b->gate->idx;
+}
+
+static double
+total_span (Circuit * c, int *position)
+{
+  double res = 0;
+  for (Gate ** p = c->gates.start; p != c->gates.top; p++)
+    {
+      Gate *g = *p;
+      if (EMPTY (g->inputs))
+	continue;
+      int min = position[g->idx], max = min;
+      for (Gate ** q = g->inputs.start; q != g->inputs.top; q++)
+	{
+	  const int pos = position[((Gate *) STRIP (*q))->idx];
+	  if (pos < min)
+	    min = pos;
+	  if (pos > max)
+	    max = pos;
+	}
+      res += max - min;
+    }
+  return res;
+}
+
+static void
+dfs_place_gate (Circuit * c, Gate * g, int *depth, int *position, int *pos,
+		Visits * visits, Gates * gates)
+{
+  g = STRIP (g);
+  if (position[g->idx] >= 0)
+    return;
+  assert (EMPTY (*visits));
+  push_sorted_visit (visits, gates, g, depth);
+  while (!EMPTY (*visits))
+    {
+      const unsigned idx = visits->top[-1].lit;
+      Gate *h = next_sorted_input (c, visits, gates);
+      if (!h)
+	position[idx] = (*pos)++;
+      else if (position[h->idx] < 0)
+	push_sorted_visit (visits, gates, h, depth);
+    }
+  assert (EMPTY (*gates));
+}
+
+static void
+initial_force_placement (Circuit * c, int *position)
+{
+  const int n = COUNT (c->gates);
+  int *depth = compute_gate_depths (c);
+  Visits visits;
+  Gates gates;
+  INIT (visits);
+  INIT (gates);
+  for (int i = 0; i < n; i++)
+    position[i] = -1;
+  int pos = 0;
+  dfs_place_gate (c, c->output, depth, position, &pos, &visits, &gates);
+  for (Gate ** p = c->gates.start; p != c->gates.top; p++)
+    dfs_place_gate (c, *p, depth, position, &pos, &visits, &gates);
+  assert (pos == n);
+  RELEASE (gates);
+  RELEASE (visits);
+  DEALLOC (depth, n);
+}
+
+static void
+force_order (Circuit * c, IntStack * order)
+{
+  const int n = COUNT (c->gates);
+  int *position;
+  ALLOC (position, n);
+  initial_force_placement (c, position);
+  double *sum;
+  int *edges;
+  Placed *placed;
+  ALLOC (sum, n);
+  ALLOC (edges, n);
+  ALLOC (placed, n);
+  double span = total_span (c, position);
+  msg (2, "initial FORCE span %.0f", span);
+  for (int round = 1; round <= MAX_FORCE_ROUNDS; round++)
+    {
+      for (int i = 0; i < n; i++)
+	sum[i] = edges[i] = 0;
+      for (Gate ** p = c->gates.start; p != c->gates.top; p++)
+	{
+	  Gate *g = *p;
+	  if (EMPTY (g->inputs))
+	    continue;
+	  double cog = position[g->idx];
+	  for (Gate ** q = g->inputs.start; q != g->inputs.top; q++)
+	    cog += position[((Gate *) STRIP (*q))->idx];
+	  cog /= COUNT (g->inputs) + 1;
+	  sum[g->idx] += cog, edges[g->idx]++;
+	  for (Gate ** q = g->inputs.start; q != g->inputs.top; q++)
+	    {
+	      Gate *h = STRIP (*q);
+	      sum[h->idx] += cog, edges[h->idx]++;
+	    }
+	}
+      for (Gate ** p = c->gates.start; p != c->gates.top; p++)
+	{
+	  Gate *g = *p;
+	  Placed *q = placed + g->idx;
+	  q->gate = g;
+	  if (edges[g->idx])
+	    q->pos = sum[g->idx] / edges[g->idx];
+	  else
+	    q->pos = position[g->idx];
+	}
+      qsort (placed, n, sizeof *placed, cmp_placed);
+      int *new_position;
+      ALLOC (new_position, n);
+      for (int i = 0; i < n; i++)
+	new_position[placed[i].gate->idx] = i;
+      double new_span = total_span (c, new_position);
+      msg (2, "FORCE round %d span %.0f", round, new_span);
+      if (new_span >= span)
+	{
+	  DEALLOC (new_position, n);
+	  break;
+	}
+      DEALLOC (position, n);
+      position = new_position;
+      span = new_span;
+    }
+  DEALLOC (placed, n);
+  DEALLOC (edges, n);
+  DEALLOC (sum, n);
+  Gate **inputs;
+  const int m = COUNT (c->inputs);
+  ALLOC (inputs, n);
+  for (Gate ** p = c->inputs.start; p != c->inputs.top; p++)
+    inputs[position[(*p)->idx]] = *p;
+  for (int i = 0; i < n; i++)
+    if (inputs[i])
+      PUSH (*order, inputs[i]->input + 1);
+  assert (COUNT (*order) == m), (void) m;
+  DEALLOC (inputs, n);
+  DEALLOC (position, n);
+}
+
+/*------------------------------------------------------------------------*/
+
+// Interleave input words.  Inputs with symbols sharing the same stem
+// and differing only in a numeric suffix (like 'a0', 'a1', ... and 'b0',
+// 'b1', ...) form a word.  Words are ordered by their first input in DFS
+// order and then their bits are interleaved ('a0', 'b0', 'a1', 'b1',
+// ...).  Inputs without symbol or suffix form single bit words.
+
+typedef struct Bit Bit;
+
+struct Bit
+{
+  const char *name;
+  int len, suffix, dfs, word, rank, input;
+};
+
+static int
+stem_length (const char *name)
+{
+  int len = strlen (name);
+  while (len > 0 && isdigit (name[len - 1]))
+    len--;
+  return len;
+}
+
+static int
+cmp_stems (const Bit * a, const Bit * b)
+{
+  if (!a->len || !b->len)
+    return a->len - b->len;
+  const int len = a->len < b->len ? a->len : b->len;
+  int res = strncmp (a->name, b->name, len);
+  if (res)
+    return res;
+  return a->len - b->len;
+}
+
+static int
+cmp_word_bits (const void *p, const void *q)
+{
+  const Bit *a = p, *b = q;
+  int res = cmp_stems (a, b);
+  if (res)
+    return res;
+  if (!a->len)
+    return a->dfs - b->dfs;
+  if (a->suffix != b->suffix)
+    return a->suffix < b->suffix ? -1 : 1;
+  return a->dfs - b->dfs;
+}
+
+static int
+cmp_interleaved_bits (const void *p, const void *q)
+{
+  const Bit *a = p, *b = q;
+  if (a->rank != b->rank)
+    return a->rank - b->rank;
+  return a->word - b->word;
+}
+
+static void
+interleave_order (Circuit * c, IntStack * order)
+{
+  IntStack dfs;
+  INIT (dfs);
+  dfs_order (c, &dfs);
+  const int n = COUNT (c->inputs);
+  Bit *bits;
+  ALLOC (bits, n);
+  for (int i = 0; i < n; i++)
+    {
+      Bit *b = bits + i;
+      b->input = PEEK (dfs, i) - 1;
+      b->dfs = i;
+      Gate *g = PEEK (c->inputs, b->input);
+      if (!g->symbol)
+	continue;
+      const char *name = g->symbol->name;
+      const int len = stem_length (name);
+      if (!len || !name[len])
+	continue;
+      b->name = name;
+      b->len = len;
+      b->suffix = atoi (name + len);
+    }
+  RELEASE (dfs);
+  qsort (bits, n, sizeof *bits, cmp_word_bits);
+  int words = 0;
+  for (int i = 0, j; i < n; i = j)
+    {
+      int first = bits[i].dfs;
+      for (j = i + 1; j < n && bits[i].len && !cmp_stems (bits + i, bits + j);
+	   j++)
+	if (bits[j].dfs < first)
+	  first = bits[j].dfs;
+      for (int k = i; k < j; k++)
+	bits[k].word = first, bits[k].rank = k - i;
+      words++;
+    }
+  msg (2, "found %d input words", words);
+  qsort (bits, n, sizeof *bits, cmp_interleaved_bits);
+  for (int i = 0; i < n; i++)
+    PUSH (*order, bits[i].input + 1);
+  DEALLOC (bits, n);
+}
+
+/*------------------------------------------------------------------------*/
+
+void
+order_circuit_inputs (Circuit * c, int heuristic, IntStack * order)
+{
+  check_circuit_connected (c);
+  assert (EMPTY (*order));
+  switch (heuristic)
+    {
+    case 1:
+      msg (1, "static BDD variable order by fanin DFS");
+      dfs_order (c, order);
+      break;
+    case 2:
+      msg (1, "static BDD variable order by FORCE placement");
+      force_order (c, order);
+      break;
+    default:
+      assert (heuristic == 3);
+      msg (1, "static BDD variable order by interleaving input words");
+      interleave_order (c, order);
+      break;
+    }
+  assert (COUNT (*order) == COUNT (c->inputs));
+}
@@ -0,0 +1 @@
+void order_circuit_inputs (Circuit *, int heuristic, IntStack * order);
@@ -7,6 +7,7 @@ struct Parser
   Reader *reader;
   Symbols *symbols;
   Circuit *circuit;
+  Gates operands;
 };
 
 static Gate *parse_expr (Parser *);
@@ -89,10 +90,34 @@ parse_basic (Parser * parser)
   return res;
 }
 
+// Operands of n-ary operators are collected on the shared 'operands' stack
+// starting at 'base' and then turned into a structurally hashed gate.
+
+static Gate *
+new_parsed_gate (Parser * parser, Operator op, size_t base)
+{
+  Gates inputs;
+  inputs.start = parser->operands.start + base;
+  inputs.top = inputs.end = parser->operands.top;
+  Gate *res = new_hashed_gate (parser->circuit, op, &inputs);
+  RESIZE (parser->operands, base);
+  return res;
+}
+
+static Gate *
+new_parsed_binary_gate (Parser * parser, Operator op, Gate * a, Gate * b)
+{
+  const size_t base = COUNT (parser->operands);
+  PUSH (parser->operands, a);
+  PUSH (parser->operands, b);
+  return new_parsed_gate (parser, op, base);
+}
+
 static Gate *
 parse_and (Parser * parser)
 {
-  Gate *res = parse_basic (parser), *and = 0;
+  Gate *res = parse_basic (parser);
+  const size_t base = COUNT (parser->operands);
   for (;;)
     {
       Coo ch = next_non_white_space_char (parser->reader);
@@ -100,63 +125,62 @@ parse_and (Parser * parser)
 	{
 	  prev_char (parser->reader, ch);
 	  if (!is_start_of_basic_expression_character (ch.code))
-	    return res;
+	    break;
 	}
+      if (COUNT (parser->operands) == base)
+	PUSH (parser->operands, res);
       Gate *tmp = parse_basic (parser);
-      if (!and)
-	{
-	  and = new_and_gate (parser->circuit);
-	  connect_gates (res, and);
-	  res = and;
-	}
-      connect_gates (tmp, and);
+      PUSH (parser->operands, tmp);
     }
+  if (COUNT (parser->operands) == base)
+    return res;
+  return new_parsed_gate (parser, AND_OPERATOR, base);
 }
 
 static Gate *
 parse_xor (Parser * parser)
 {
-  Gate *res = parse_and (parser), *xor = 0;
+  Gate *res = parse_and (parser);
+  const size_t base = COUNT (parser->operands);
   for (;;)
     {
       Coo ch = next_non_white_space_char (parser->reader);
       if (ch.code != '^')
 	{
 	  prev_char (parser->reader, ch);
-	  return res;
+	  break;
 	}
+      if (COUNT (parser->operands) == base)
+	PUSH (parser->operands, res);
       Gate *tmp = parse_and (parser);
-      if (!xor)
-	{
-	  xor = new_xor_gate (parser->circuit);
-	  connect_gates (res, xor);
-	  res = xor;
-	}
-      connect_gates (tmp, xor);
+      PUSH (parser->operands, tmp);
     }
+  if (COUNT (parser->operands) == base)
+    return res;
+  return new_parsed_gate (parser, XOR_OPERATOR, base);
 }
 
 static Gate *
 parse_or (Parser * parser)
 {
-  Gate *res = parse_xor (parser), *or = 0;
+  Gate *res = parse_xor (parser);
+  const size_t base = COUNT (parser->operands);
   for (;;)
     {
       Coo ch = next_non_white_space_char (parser->reader);
       if (ch.code != '|')
 	{
 	  prev_char (parser->reader, ch);
-	  return res;
+	  break;
 	}
+      if (COUNT (parser->operands) == base)
+	PUSH (parser->operands, res);
       Gate *tmp = parse_xor (parser);
-      if (!or)
-	{
-	  or = new_or_gate (parser->circuit);
-	  connect_gates (res, or);
-	  res = or;
-	}
-      connect_gates (tmp, or);
+      PUSH (parser->operands, tmp);
     }
+  if (COUNT (parser->operands) == base)
+    return res;
+  return new_parsed_gate (parser, OR_OPERATOR, base);
 }
 
 static Gate *
@@ -174,34 +198,34 @@ parse_ite (Parser * parser)
   if (ch.code != ':')
     parse_error_at (parser->reader, ch, "expected ':'");
   Gate *neg = parse_or (parser);
-  Gate *ite = new_ite_gate (parser->circuit);
-  connect_gates (cond, ite);
-  connect_gates (pos, ite);
-  connect_gates (neg, ite);
-  return ite;
+  const size_t base = COUNT (parser->operands);
+  PUSH (parser->operands, cond);
+  PUSH (parser->operands, pos);
+  PUSH (parser->operands, neg);
+  return new_parsed_gate (parser, ITE_OPERATOR, base);
 }
 
 static Gate *
 parse_equal (Parser * parser)
 {
-  Gate *res = parse_ite (parser), *xnor = 0;
+  Gate *res = parse_ite (parser);
+  const size_t base = COUNT (parser->operands);
   for (;;)
     {
       Coo ch = next_non_white_space_char (parser->reader);
       if (ch.code != '=')
 	{
 	  prev_char (parser->reader, ch);
-	  return res;
+	  break;
 	}
+      if (COUNT (parser->operands) == base)
+	PUSH (parser->operands, res);
       Gate *tmp = parse_ite (parser);
-      if (!xnor)
-	{
-	  xnor = new_xnor_gate (parser->circuit);
-	  connect_gates (res, xnor);
-	  res = xnor;
-	}
-      connect_gates (tmp, xnor);
+      PUSH (parser->operands, tmp);
     }
+  if (COUNT (parser->operands) == base)
+    return res;
+  return new_parsed_gate (parser, XNOR_OPERATOR, base);
 }
 
 static Gate *
@@ -212,26 +236,17 @@ parse_implies_or_iff (Parser * parser)
   if (ch.code == IMPLIES)
     {
       Gate *c = parse_equal (parser);
-      Gate *or = new_or_gate (parser->circuit);
-      connect_gates (NOT (a), or);
-      connect_gates (c, or);
-      return or;
+      return new_parsed_binary_gate (parser, OR_OPERATOR, NOT (a), c);
     }
   else if (ch.code == IFF)
     {
       Gate *c = parse_equal (parser);
-      Gate *xnor = new_xnor_gate (parser->circuit);
-      connect_gates (a, xnor);
-      connect_gates (c, xnor);
-      return xnor;
+      return new_parsed_binary_gate (parser, XNOR_OPERATOR, a, c);
     }
   else if (ch.code == SEILMPI)
     {
       Gate *c = parse_equal (parser);
-      Gate *or = new_or_gate (parser->circuit);
-      connect_gates (a, or);
-      connect_gates (NOT (c), or);
-      return or;
+      return new_parsed_binary_gate (parser, OR_OPERATOR, a, NOT (c));
     }
   else
     {
@@ -253,10 +268,12 @@ parse_formula (Reader * reader, Symbols * symbols)
   parser.reader = reader;
   parser.symbols = symbols;
   parser.circuit = new_circuit ();
+  INIT (parser.operands);
   Gate *output = parse_expr (&parser);
   Coo ch = next_non_white_space_char (reader);
   if (ch.code != EOF)
     parse_error_at (reader, ch, "expected end-of-file after expression");
+  RELEASE (parser.operands);
   connect_output (parser.circuit, output);
   return parser.circuit;
 }
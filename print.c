@@ -1,18 +1,42 @@
 #include "headers.h"
 
+// Printing uses an explicit stack of gates instead of recursion, since
+// circuits can be deeper than the C stack (the printed expression is a
+// tree and thus only deep circuits with small width are printable).
+
+typedef struct Printing Printing;
+
+struct Printing
+{
+  Gate *gate;
+  Operator op;
+  int parenthesis;
+  long next;
+};
+
+typedef STACK (Printing) Printings;
+
+// If 'dual' is set the gate is printed as its dual (see 'dual_operator'),
+// where negated inputs and constants just flip the sign.  Gates with
+// inputs are pushed on the stack to print their inputs afterwards.
+
 static void
-print_gate_to_file (Gate * g, Operator outer, FILE * file)
+print_gate_prefix (Gate * g, Operator outer, int dual, FILE * file,
+		   Printings * printings)
 {
-  const int sign = SIGN (g);
+  int sign = SIGN (g);
   if (sign)
     g = NOT (g);
-  if (g->op == FALSE_OPERATOR)
+  const Operator op = dual ? dual_operator (g->op) : g->op;
+  if (dual && (op == FALSE_OPERATOR || op == INPUT_OPERATOR))
+    sign = !sign;
+  if (op == FALSE_OPERATOR)
     fprintf (file, "%c", sign ? '1' : '0');
   else
     {
       if (sign)
 	fprintf (file, "!");
-      if (g->op == INPUT_OPERATOR)
+      if (op == INPUT_OPERATOR)
 	{
 	  if (g->symbol)
 	    fprintf (file, "%s", g->symbol->name);
@@ -24,58 +48,85 @@ print_gate_to_file (Gate * g, Operator outer, FILE * file)
 	  int parenthesis;
 	  if (sign)
 	    parenthesis = 1;
-	  else if (g->op < ITE_OPERATOR)
-	    parenthesis = (g->op > outer);
+	  else if (op < ITE_OPERATOR)
+	    parenthesis = (op > outer);
 	  else
-	    parenthesis = (g->op >= outer);
+	    parenthesis = (op >= outer);
 	  if (parenthesis)
 	    fprintf (file, "(");
-	  if (g->op == ITE_OPERATOR)
-	    {
-	      Gate **inputs = g->inputs.start;
-	      assert (COUNT (g->inputs) == 3);
-	      print_gate_to_file (inputs[0], ITE_OPERATOR, file);
-	      fprintf (file, " ? ");
-	      print_gate_to_file (inputs[1], ITE_OPERATOR, file);
-	      fprintf (file, " : ");
-	      print_gate_to_file (inputs[2], ITE_OPERATOR, file);
-	    }
-	  else
-	    {
-	      char op = '=';
-	      if (g->op == AND_OPERATOR)
-		op = '&';
-	      else if (g->op == OR_OPERATOR)
-		op = '|';
-	      else if (g->op == XOR_OPERATOR)
-		op = '^';
-	      else
-		assert (g->op == XNOR_OPERATOR);
-	      for (Gate ** p = g->inputs.start; p < g->inputs.top; p++)
-		{
-		  if (p != g->inputs.start)
-		    fprintf (file, " %c ", op);
-		  print_gate_to_file (*p, g->op, file);
-		}
-	    }
-	  if (parenthesis)
+	  assert (op != ITE_OPERATOR || COUNT (g->inputs) == 3);
+	  Printing printing;
+	  printing.gate = g;
+	  printing.op = op;
+	  printing.parenthesis = parenthesis;
+	  printing.next = 0;
+	  PUSH (*printings, printing);
+	}
+    }
+}
+
+static void
+print_gate_to_file (Gate * g, Operator outer, int dual, FILE * file)
+{
+  Printings printings;
+  INIT (printings);
+  print_gate_prefix (g, outer, dual, file, &printings);
+  while (!EMPTY (printings))
+    {
+      Printing *printing = printings.top - 1;
+      Gate *h = printing->gate;
+      const Operator op = printing->op;
+      const long i = printing->next++;
+      if (i == (long) COUNT (h->inputs))
+	{
+	  if (printing->parenthesis)
 	    fprintf (file, ")");
+	  printings.top--;
+	  continue;
 	}
+      long j = i;
+      if (op == ITE_OPERATOR)
+	{
+	  if (i == 1)
+	    fprintf (file, " ? ");
+	  else if (i == 2)
+	    fprintf (file, " : ");
+	  if (dual && i)
+	    j = 3 - i;
+	}
+      else if (i)
+	{
+	  char ch = '=';
+	  if (op == AND_OPERATOR)
+	    ch = '&';
+	  else if (op == OR_OPERATOR)
+	    ch = '|';
+	  else if (op == XOR_OPERATOR)
+	    ch = '^';
+	  else
+	    assert (op == XNOR_OPERATOR);
+	  fprintf (file, " %c ", ch);
+	}
+      print_gate_prefix (PEEK (h->inputs, j), op, dual, file, &printings);
     }
+  RELEASE (printings);
 }
 
 void
 println_gate (Gate * g)
 {
-  print_gate_to_file (g, -1, stdout);
+  print_gate_to_file (g, -1, 0, stdout);
   fputc ('\n', stdout);
 }
 
+// A negated circuit pointer is printed as the dual circuit.
+
 void
-print_circuit_to_file (Circuit * c, FILE * file)
+print_circuit_to_file (Circuit * circuit, FILE * file)
 {
+  Circuit *c = STRIP (circuit);
   check_circuit_connected (c);
-  print_gate_to_file (c->output, -1, file);
+  print_gate_to_file (c->output, -1, SIGN (circuit), file);
 }
 
 void
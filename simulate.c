@@ -1,95 +1,436 @@
 #include "headers.h"
 
+typedef struct Simulator Simulator;
+
+struct Simulator
+{
+  Circuit *circuit;
+  Compact *compact;
+  BDD **cache;			// indexed by compact literals
+  IntStack *quantify;		// per gate inputs to quantify (or zero)
+  signed char *fixed;		// per input assumed value (or zero)
+  int negated;			// simulate the dual circuit
+  Visits visits;
+};
+
+// Optionally each simulated gate is traced with the size of its BDD and
+// the time spent on it (after its inputs have been simulated).  The
+// trace is printed at verbosity level three and written as one JSON
+// object per line to the trace file.
+
+static FILE *simulation_trace;
+
+void
+trace_simulation (FILE * file)
+{
+  simulation_trace = file;
+}
+
+static int
+traced_gate (Simulator * s, unsigned lit)
+{
+  if (COMPACT_SIGN (lit))
+    return 0;
+  const Operator op = s->compact->ops[COMPACT_GATE (lit)];
+  if (op == INPUT_OPERATOR || op == FALSE_OPERATOR)
+    return 0;
+  return simulation_trace || options.verbosity >= 3;
+}
+
 static long
-simulation_cache_index (Gate * g)
-{
-  int sign = SIGN (g);
-  if (sign)
-    g = NOT (g);
-  long res = 2 * g->idx;
-  if (sign)
-    res++;
-  return res;
+simulated_gate_size (Simulator * s, unsigned g)
+{
+  return s->compact->first_input[g + 1] - s->compact->first_input[g];
+}
+
+static const unsigned *
+simulated_gate_inputs (Simulator * s, unsigned g)
+{
+  return s->compact->inputs + s->compact->first_input[g];
+}
+
+static void
+trace_gate (Simulator * s, unsigned lit, BDD * b, double start)
+{
+  const double self = process_time () - start;
+  const unsigned nodes = size_bdd (b), live = live_bdd_nodes ();
+  Gate *g = PEEK (s->circuit->gates, COMPACT_GATE (lit));
+  const long inputs = simulated_gate_size (s, g->idx);
+  msg (3, "simulated %s gate %d with %ld inputs "
+       "to %u BDD nodes (%u live) in %.3f seconds",
+       gate_name (g), g->idx, inputs, nodes, live, self);
+  if (!simulation_trace)
+    return;
+  fprintf (simulation_trace,
+	   "{\"gate\": %d, \"op\": \"%s\", \"inputs\": %ld, "
+	   "\"nodes\": %u, \"live\": %u, \"seconds\": %.6f}\n",
+	   g->idx, gate_name (g), inputs, nodes, live, self);
 }
 
 static BDD *
-cached_simulate (BDD ** cache, Gate * g)
+cached_simulate (BDD ** cache, unsigned lit)
 {
-  BDD *res = cache[simulation_cache_index (g)];
+  BDD *res = cache[lit];
   if (res)
     res = copy_bdd (res);
   return res;
 }
 
 static void
-cache_simulate (BDD ** cache, Gate * g, BDD * b)
+cache_simulate (BDD ** cache, unsigned lit, BDD * b)
 {
-  cache[simulation_cache_index (g)] = copy_bdd (b);
+  cache[lit] = copy_bdd (b);
 }
 
-static BDD *simulate_circuit_recursive (Gate *, BDD **, Circuit *);
+static IntStack *
+quantified_at_gate (Simulator * s, unsigned g)
+{
+  if (!s->quantify)
+    return 0;
+  IntStack *res = s->quantify + g;
+  return EMPTY (*res) ? 0 : res;
+}
+
+// The BDDs of the inputs of a gate are in the cache when it is simulated.
+
+static BDD *
+simulated_literal (Simulator * s, unsigned lit)
+{
+  BDD *res = cached_simulate (s->cache, lit);
+  assert (res);
+  return res;
+}
 
 static BDD *
-simulate_gates (Gate ** gates, long n,
-		BDD ** cache, Circuit * c,
+simulate_gates (Simulator * s, const unsigned *gates, long n,
 		BDD * (*op) (BDD *, BDD *), const char *name)
 {
   assert (n > 0);
   if (n == 1)
-    return simulate_circuit_recursive (gates[0], cache, c);
+    return simulated_literal (s, gates[0]);
   LOG ("simulating %s over %ld gates", name, n);
   unsigned m = n / 2;
-  BDD *l = simulate_gates (gates, m, cache, c, op, name);
-  BDD *r = simulate_gates (gates + m, n - m, cache, c, op, name);
+  BDD *l = simulate_gates (s, gates, m, op, name);
+  BDD *r = simulate_gates (s, gates + m, n - m, op, name);
   BDD *res = op (l, r);
   delete_bdd (l);
   delete_bdd (r);
   return res;
 }
 
+// Same as 'simulate_gates' for AND but quantifies the given variables
+// while computing the top-most conjunction.
+
+static BDD *
+simulate_and_exists_gates (Simulator * s, const unsigned *gates, long n,
+			   IntStack * vars)
+{
+  assert (n > 1);
+  LOG ("simulating AND over %ld gates quantifying %" PRz " variables",
+       n, COUNT (*vars));
+  unsigned m = n / 2;
+  BDD *l = simulate_gates (s, gates, m, and_bdd, "AND");
+  BDD *r = simulate_gates (s, gates + m, n - m, and_bdd, "AND");
+  BDD *res = and_exists_bdd (l, r, vars);
+  delete_bdd (l);
+  delete_bdd (r);
+  return res;
+}
+
+/*------------------------------------------------------------------------*/
+
+// Conjunction scheduling for AND gates with many inputs, e.g., the single
+// top-level AND over all clauses of a DIMACS file.  Instead of a balanced
+// split by position, the conjuncts are combined by bucket elimination.
+// Variables are ordered by their number of occurrences.  Each conjunct
+// is put into the bucket of its first variable in this order.  Buckets
+// are conjoined in order and if the bucket variable was scheduled to be
+// quantified at this gate it is quantified away immediately, since at
+// this point all conjuncts depending on it are in its bucket.  The result
+// is then moved to the bucket of its next variable.
+
+typedef STACK (BDD *) BDDs;
+
 static BDD *
-simulate_circuit_recursive (Gate * g, BDD ** cache, Circuit * c)
+conjoin_bdds (BDD ** bdds, long n)
+{
+  assert (n > 0);
+  if (n == 1)
+    return bdds[0];
+  long m = n / 2;
+  BDD *l = conjoin_bdds (bdds, m);
+  BDD *r = conjoin_bdds (bdds + m, n - m);
+  BDD *res = and_bdd (l, r);
+  delete_bdd (l);
+  delete_bdd (r);
+  return res;
+}
+
+static int *sorting_occurrences;
+
+static int
+cmp_occurrences (const void *p, const void *q)
 {
-  BDD *res = cached_simulate (cache, g);
+  int a = *(int *) p, b = *(int *) q;
+  int res = sorting_occurrences[a] - sorting_occurrences[b];
   if (res)
     return res;
-  if (SIGN (g))
+  return a - b;
+}
+
+typedef struct Scheduler Scheduler;
+
+struct Scheduler
+{
+  long num_vars;
+  int *occs, *pos;
+  char *quantify;
+  IntStack order, support;
+  BDDs *buckets, rest;
+};
+
+static void
+schedule_bdd (Scheduler * t, BDD * b, long current)
+{
+  CLEAR (t->support);
+  support_bdd (b, &t->support);
+  long next = COUNT (t->order);
+  for (const int *p = t->support.start; p != t->support.top; p++)
+    {
+      long pos = t->pos[*p];
+      if (pos > current && pos < next)
+	next = pos;
+    }
+  if (next < (long) COUNT (t->order))
+    PUSH (t->buckets[next], b);
+  else
+    PUSH (t->rest, b);
+}
+
+static void
+release_scheduler (Scheduler * t)
+{
+  for (long i = 0; i < (long) COUNT (t->order); i++)
+    {
+      for (BDD ** p = t->buckets[i].start; p != t->buckets[i].top; p++)
+	delete_bdd (*p);
+      RELEASE (t->buckets[i]);
+    }
+  for (BDD ** p = t->rest.start; p != t->rest.top; p++)
+    delete_bdd (*p);
+  RELEASE (t->rest);
+  DEALLOC (t->buckets, COUNT (t->order));
+  RELEASE (t->order);
+  RELEASE (t->support);
+  DEALLOC (t->quantify, t->num_vars);
+  DEALLOC (t->pos, t->num_vars);
+  DEALLOC (t->occs, t->num_vars);
+}
+
+// In the view of the dual circuit an AND gate is simulated as OR, which
+// is scheduled in the same way as the conjunction of the negated inputs
+// and then negated again, if no variables are quantified at the gate.
+
+static BDD *
+simulate_scheduled_and_gate (Simulator * s, unsigned g, IntStack * vars,
+			     int dual)
+{
+  assert (!dual || !vars);
+  const long n = simulated_gate_size (s, g);
+  const unsigned *inputs = simulated_gate_inputs (s, g);
+  LOG ("scheduling %s over %ld gates", dual ? "OR" : "AND", n);
+  Scheduler t;
+  t.num_vars = COUNT (s->circuit->inputs) + 1;
+  ALLOC (t.occs, t.num_vars);
+  ALLOC (t.pos, t.num_vars);
+  ALLOC (t.quantify, t.num_vars);
+  INIT (t.order);
+  INIT (t.support);
+  INIT (t.rest);
+  t.buckets = 0;
+  BDDs factors;
+  INIT (factors);
+  BDD *res = 0;
+  for (long i = 0; !res && i < n; i++)
+    {
+      BDD *b = simulated_literal (s, inputs[i]);
+      if (dual)
+	{
+	  BDD *tmp = not_bdd (b);
+	  delete_bdd (b);
+	  b = tmp;
+	}
+      if (is_false_bdd (b))
+	res = b;
+      else if (is_true_bdd (b))
+	delete_bdd (b);
+      else
+	{
+	  PUSH (factors, b);
+	  CLEAR (t.support);
+	  support_bdd (b, &t.support);
+	  for (const int *q = t.support.start; q != t.support.top; q++)
+	    if (!t.occs[*q]++)
+	      PUSH (t.order, *q);
+	}
+    }
+  const long m = COUNT (t.order);
+  ALLOC (t.buckets, m);
+  if (res)
+    {
+      for (BDD ** p = factors.start; p != factors.top; p++)
+	delete_bdd (*p);
+      RELEASE (factors);
+      release_scheduler (&t);
+      goto DONE;
+    }
+  sorting_occurrences = t.occs;
+  qsort (t.order.start, m, sizeof *t.order.start, cmp_occurrences);
+  sorting_occurrences = 0;
+  for (long i = 0; i < m; i++)
+    t.pos[PEEK (t.order, i)] = i;
+  if (vars)
+    for (const int *p = vars->start; p != vars->top; p++)
+      t.quantify[*p] = 1;
+  for (BDD ** p = factors.start; p != factors.top; p++)
+    schedule_bdd (&t, *p, -1);
+  RELEASE (factors);
+  IntStack quantified;
+  INIT (quantified);
+  for (long i = 0; !res && i < m; i++)
+    {
+      BDDs *bucket = t.buckets + i;
+      const long k = COUNT (*bucket);
+      if (!k)
+	continue;
+      const int var = PEEK (t.order, i);
+      BDD *b;
+      if (t.quantify[var])
+	{
+	  CLEAR (quantified);
+	  PUSH (quantified, var);
+	  if (k == 1)
+	    {
+	      BDD *tmp = PEEK (*bucket, 0);
+	      b = exists_bdd (tmp, &quantified);
+	      delete_bdd (tmp);
+	    }
+	  else
+	    {
+	      BDD *l = conjoin_bdds (bucket->start, k / 2);
+	      BDD *r = conjoin_bdds (bucket->start + k / 2, k - k / 2);
+	      b = and_exists_bdd (l, r, &quantified);
+	      delete_bdd (l);
+	      delete_bdd (r);
+	    }
+	}
+      else
+	b = conjoin_bdds (bucket->start, k);
+      CLEAR (*bucket);
+      if (is_false_bdd (b))
+	res = b;
+      else if (is_true_bdd (b))
+	delete_bdd (b);
+      else
+	schedule_bdd (&t, b, i);
+    }
+  RELEASE (quantified);
+  if (!res)
+    {
+      if (EMPTY (t.rest))
+	res = true_bdd ();
+      else
+	res = conjoin_bdds (t.rest.start, COUNT (t.rest));
+      CLEAR (t.rest);
+    }
+  release_scheduler (&t);
+DONE:
+  if (dual)
+    {
+      BDD *tmp = not_bdd (res);
+      delete_bdd (res);
+      res = tmp;
+    }
+  return res;
+}
+
+/*------------------------------------------------------------------------*/
+
+static void
+simulate_gate (Simulator * s, unsigned lit)
+{
+  assert (!s->cache[lit]);
+  BDD *res = 0;
+  const int traced = traced_gate (s, lit);
+  const double start = traced ? process_time () : 0;
+  if (COMPACT_SIGN (lit))
     {
       LOG ("simulating NOT");
-      BDD *tmp = simulate_circuit_recursive (NOT (g), cache, c);
+      BDD *tmp = simulated_literal (s, lit ^ 1);
       res = not_bdd (tmp);
       delete_bdd (tmp);
     }
   else
     {
-      long n = COUNT (g->inputs);
-      Gate **inputs = g->inputs.start;
-      switch (g->op)
+      const unsigned g = COMPACT_GATE (lit);
+      const long n = simulated_gate_size (s, g);
+      const unsigned *inputs = simulated_gate_inputs (s, g);
+      const Operator op = s->compact->ops[g];
+      IntStack *vars = quantified_at_gate (s, g);
+      const int negated = s->negated;
+      switch (negated ? dual_operator (op) : op)
 	{
 	case FALSE_OPERATOR:
 	  LOG ("simulating FALSE");
-	  res = false_bdd ();
+	  res = negated ? true_bdd () : false_bdd ();
 	  break;
 	case INPUT_OPERATOR:
-	  LOG ("simulating INPUT %d", g->input);
-	  res = new_bdd (g->input + 1);
+	  {
+	    const unsigned input = s->compact->input[g];
+	    LOG ("simulating INPUT %u", input);
+	    if (s->fixed && s->fixed[input])
+	      res = (s->fixed[input] > 0) != negated ?
+		true_bdd () : false_bdd ();
+	    else if (negated)
+	      {
+		BDD *tmp = new_bdd (input + 1);
+		res = not_bdd (tmp);
+		delete_bdd (tmp);
+	      }
+	    else
+	      res = new_bdd (input + 1);
+	  }
 	  break;
 	case AND_OPERATOR:
-	  res = simulate_gates (inputs, n, cache, c, and_bdd, "AND");
+	  if (options.schedule && n > 2)
+	    {
+	      res = simulate_scheduled_and_gate (s, g, vars, 0);
+	      vars = 0;
+	    }
+	  else if (vars)
+	    {
+	      res = simulate_and_exists_gates (s, inputs, n, vars);
+	      vars = 0;
+	    }
+	  else
+	    res = simulate_gates (s, inputs, n, and_bdd, "AND");
 	  break;
 	case XOR_OPERATOR:
-	  res = simulate_gates (inputs, n, cache, c, xor_bdd, "XOR");
+	  res = simulate_gates (s, inputs, n, xor_bdd, "XOR");
 	  break;
 	case OR_OPERATOR:
-	  res = simulate_gates (inputs, n, cache, c, or_bdd, "OR");
+	  if (options.schedule && n > 2 && negated && !vars)
+	    res = simulate_scheduled_and_gate (s, g, 0, 1);
+	  else
+	    res = simulate_gates (s, inputs, n, or_bdd, "OR");
 	  break;
 	case ITE_OPERATOR:
 	  LOG ("simulating ITE");
 	  assert (n == 3);
 	  {
-	    BDD *cond = simulate_circuit_recursive (inputs[0], cache, c);
-	    BDD *then = simulate_circuit_recursive (inputs[1], cache, c);
-	    BDD *other = simulate_circuit_recursive (inputs[2], cache, c);
+	    BDD *cond = simulated_literal (s, inputs[0]);
+	    BDD *then = simulated_literal (s, inputs[1 + negated]);
+	    BDD *other = simulated_literal (s, inputs[2 - negated]);
 	    res = ite_bdd (cond, then, other);
 	    delete_bdd (cond);
 	    delete_bdd (then);
@@ -97,28 +438,491 @@ simulate_circuit_recursive (Gate * g, BDD ** cache, Circuit * c)
 	  }
 	  break;
 	case XNOR_OPERATOR:
-	  res = simulate_gates (inputs, n, cache, c, xnor_bdd, "XNOR");
+	  res = simulate_gates (s, inputs, n, xnor_bdd, "XNOR");
 	  break;
 	}
+      if (vars)
+	{
+	  LOG ("quantifying %" PRz " variables at %s gate %u",
+	       COUNT (*vars), gate_name (PEEK (s->circuit->gates, g)), g);
+	  BDD *tmp = exists_bdd (res, vars);
+	  delete_bdd (res);
+	  res = tmp;
+	}
+    }
+  if (traced)
+    trace_gate (s, lit, res, start);
+  cache_simulate (s->cache, lit, res);
+  delete_bdd (res);
+}
+
+static int
+scheduled_and_gate (Simulator * s, unsigned g)
+{
+  const Operator op = s->compact->ops[g];
+  return options.schedule && simulated_gate_size (s, g) > 2 &&
+    (s->negated ? dual_operator (op) : op) == AND_OPERATOR;
+}
+
+// Gates are simulated in post-order of a depth-first traversal with an
+// explicit stack of visits, i.e., after the BDDs of all their inputs are
+// cached.  Scheduled conjunctions stop at the first input simulated to
+// false (see 'simulate_scheduled_and_gate'), thus its remaining inputs
+// are not visited either.  After reaching the BDD node limit the result
+// is irrelevant and simulation just stops.
+
+static BDD *
+simulate_literal (Simulator * s, unsigned root)
+{
+  Visits *visits = &s->visits;
+  assert (EMPTY (*visits));
+  push_visit (visits, root);
+  while (!EMPTY (*visits))
+    {
+      if (bdd_node_limit_reached ())
+	{
+	  CLEAR (*visits);
+	  return false_bdd ();
+	}
+      Visit *visit = visits->top - 1;
+      const unsigned lit = visit->lit;
+      if (s->cache[lit])
+	{
+	  visits->top--;
+	  continue;
+	}
+      if (COMPACT_SIGN (lit))
+	{
+	  if (!visit->next++)
+	    {
+	      push_visit (visits, lit ^ 1);
+	      continue;
+	    }
+	}
+      else
+	{
+	  const unsigned g = COMPACT_GATE (lit);
+	  const unsigned *inputs = simulated_gate_inputs (s, g);
+	  const unsigned n = simulated_gate_size (s, g);
+	  if (visit->next < n &&
+	      (!visit->next || !scheduled_and_gate (s, g) ||
+	       !is_false_bdd (s->cache[inputs[visit->next - 1]])))
+	    {
+	      const unsigned input = inputs[visit->next++];
+	      if (!s->cache[input])
+		push_visit (visits, input);
+	      continue;
+	    }
+	}
+      visits->top--;
+      simulate_gate (s, lit);
+    }
+  return simulated_literal (s, root);
+}
+
+/*------------------------------------------------------------------------*/
+
+// Early quantification of irrelevant inputs.  If every path from an input
+// to the output passes through a gate 'd' (an immediate dominator in the
+// fan-out graph) and the output only depends positively on 'd', then the
+// input can be quantified as soon as the BDD of 'd' is computed.  This
+// keeps intermediate BDDs small during projected counting.  Inputs for
+// which no such gate is found are projected away at the end as before.
+
+static int
+intersect_dominators (int *idom, int a, int b)
+{
+  while (a != b)
+    {
+      while (a < b)
+	a = idom[a];
+      while (b < a)
+	b = idom[b];
+    }
+  return a;
+}
+
+static int *
+compute_dominators (Circuit * c, Compact * compact)
+{
+  const long n = compact->num_gates;
+  const unsigned char *polarity = compact->polarity;
+  int *res;
+  ALLOC (res, n);
+  const long root = COMPACT_GATE (compact_output (c));
+  for (long i = n - 1; i >= 0; i--)
+    {
+      res[i] = -1;
+      if (!polarity[i])
+	continue;
+      if (i == root)
+	{
+	  res[i] = i;
+	  continue;
+	}
+      int d = -1;
+      for (unsigned j = compact->first_output[i];
+	   j < compact->first_output[i + 1]; j++)
+	{
+	  const int o = compact->outputs[j];
+	  if (!polarity[o])
+	    continue;
+	  assert (o > i);
+	  assert (res[o] >= 0);
+	  if (d < 0)
+	    d = o;
+	  else
+	    d = intersect_dominators (res, d, o);
+	}
+      assert (d > i);
+      res[i] = d;
     }
-  cache_simulate (cache, g, res);
   return res;
 }
 
-BDD *
-simulate_circuit (Circuit * c)
+static long
+schedule_quantification (Simulator * s, IntStack * relevant)
+{
+  Circuit *c = s->circuit;
+  cone_of_influence (c);
+  const unsigned char *polarity = s->compact->polarity;
+  const long n = s->compact->num_gates;
+  ALLOC (s->quantify, n);
+  int *idom = compute_dominators (c, s->compact);
+  const long num_inputs = COUNT (c->inputs);
+  char *keep;
+  ALLOC (keep, num_inputs);
+  for (const int *p = relevant->start; p != relevant->top; p++)
+    {
+      assert (0 < *p && *p <= num_inputs);
+      keep[*p - 1] = 1;
+    }
+  long res = 0;
+  for (long i = 0; i < num_inputs; i++)
+    {
+      Gate *g = PEEK (c->inputs, i);
+      assert (g->input == i);
+      if (keep[i] || !polarity[g->idx])
+	continue;
+      int d = idom[g->idx];
+      for (;;)
+	{
+	  if (polarity[d] == 1)
+	    break;
+	  if (idom[d] == d)
+	    {
+	      d = -1;
+	      break;
+	    }
+	  d = idom[d];
+	}
+      if (d < 0)
+	continue;
+      LOG ("quantifying input %ld at gate %d", i, d);
+      PUSH (s->quantify[d], i + 1);
+      res++;
+    }
+  DEALLOC (keep, num_inputs);
+  DEALLOC (idom, n);
+  return res;
+}
+
+static void
+release_quantification (Simulator * s)
+{
+  if (!s->quantify)
+    return;
+  const long n = s->compact->num_gates;
+  for (long i = 0; i < n; i++)
+    RELEASE (s->quantify[i]);
+  DEALLOC (s->quantify, n);
+}
+
+/*------------------------------------------------------------------------*/
+
+// A negated circuit pointer is simulated as the dual circuit, where the
+// quantification schedule carries over, since the dual output depends on
+// the dual of a gate with the same polarity.
+
+static BDD *
+simulate (Circuit * circuit, IntStack * relevant, IntStack * assumptions)
 {
+  Circuit *c = STRIP (circuit);
   check_circuit_connected (c);
-  long count = 2 * COUNT (c->gates);
-  BDD **cache;
-  ALLOC (cache, count);
-  BDD *res = simulate_circuit_recursive (c->output, cache, c);
+  Simulator s;
+  s.circuit = c;
+  s.compact = compact_circuit (c);
+  s.quantify = 0;
+  s.fixed = 0;
+  s.negated = SIGN (circuit);
+  INIT (s.visits);
+  if (relevant)
+    {
+      long scheduled = schedule_quantification (&s, relevant);
+      msg (1, "scheduled early quantification of %ld inputs", scheduled);
+    }
+  const long num_inputs = COUNT (c->inputs);
+  if (assumptions)
+    {
+      ALLOC (s.fixed, num_inputs);
+      for (const int *p = assumptions->start; p != assumptions->top; p++)
+	{
+	  int lit = *p, idx = abs (lit) - 1;
+	  assert (0 <= idx && idx < num_inputs);
+	  LOG ("assuming input %d to be %s", idx, lit < 0 ? "false" : "true");
+	  s.fixed[idx] = lit < 0 ? -1 : 1;
+	}
+    }
+  long count = 2l * s.compact->num_gates;
+  ALLOC (s.cache, count);
+  BDD *res = simulate_literal (&s, compact_output (c));
   for (long i = 0; i < count; i++)
     {
-      BDD *b = cache[i];
+      BDD *b = s.cache[i];
       if (b)
 	delete_bdd (b);
     }
-  DEALLOC (cache, count);
+  DEALLOC (s.cache, count);
+  RELEASE (s.visits);
+  if (s.fixed)
+    DEALLOC (s.fixed, num_inputs);
+  release_quantification (&s);
+  return res;
+}
+
+BDD *
+simulate_circuit (Circuit * c)
+{
+  return simulate (c, 0, 0);
+}
+
+BDD *
+simulate_and_quantify_circuit (Circuit * c, IntStack * relevant)
+{
+  return simulate (c, relevant, 0);
+}
+
+// Simulates the cofactor of the circuit where the inputs of the given
+// (external) literals are fixed.  Quantification of irrelevant inputs is
+// only scheduled if 'relevant' is non-zero.
+
+BDD *
+simulate_circuit_under_assumptions (Circuit * c,
+				    IntStack * relevant,
+				    IntStack * assumptions)
+{
+  return simulate (c, relevant, assumptions);
+}
+
+/*------------------------------------------------------------------------*/
+
+// Word-parallel simulation of all gates on random input patterns.  Each
+// word holds 64 patterns and up to 'MAX_PATTERN_WORDS' words (thus 512
+// patterns) are simulated per round.  The gates are evaluated in
+// topological order on the compact form of the circuit, and the inner
+// loops over the words of a gate are simple enough to be vectorized.
+
+Patterns *
+new_patterns (Circuit * c, unsigned words)
+{
+  check_circuit_connected (c);
+  Patterns *res;
+  NEW (res);
+  res->circuit = c;
+  assert (0 < words), assert (words <= MAX_PATTERN_WORDS);
+  res->words = words;
+  res->gates = COUNT (c->gates);
+  ALLOC (res->values, res->gates * res->words);
+  LOG ("new %u words of patterns for %ld gates", res->words, res->gates);
   return res;
 }
+
+void
+delete_patterns (Patterns * p)
+{
+  DEALLOC (p->values, p->gates * p->words);
+  DELETE (p);
+}
+
+uint64_t *
+gate_patterns (Patterns * p, Gate * g)
+{
+  assert (!SIGN (g));
+  assert (g->idx < p->gates);
+  return p->values + (size_t) g->idx * p->words;
+}
+
+static const uint64_t *
+literal_patterns (Patterns * p, unsigned lit, uint64_t * mask)
+{
+  *mask = COMPACT_SIGN (lit) ? ~(uint64_t) 0 : 0;
+  return p->values + (size_t) COMPACT_GATE (lit) * p->words;
+}
+
+static uint64_t
+pattern_mask (Gate * g)
+{
+  return SIGN (g) ? ~(uint64_t) 0 : 0;
+}
+
+static void
+simulate_and_patterns (Patterns * p, const unsigned *inputs,
+		       unsigned n, uint64_t * res)
+{
+  const unsigned words = p->words;
+  for (unsigned i = 0; i < words; i++)
+    res[i] = ~(uint64_t) 0;
+  for (unsigned j = 0; j < n; j++)
+    {
+      uint64_t m;
+      const uint64_t *v = literal_patterns (p, inputs[j], &m);
+      for (unsigned i = 0; i < words; i++)
+	res[i] &= v[i] ^ m;
+    }
+}
+
+static void
+simulate_or_patterns (Patterns * p, const unsigned *inputs,
+		      unsigned n, uint64_t * res)
+{
+  const unsigned words = p->words;
+  for (unsigned i = 0; i < words; i++)
+    res[i] = 0;
+  for (unsigned j = 0; j < n; j++)
+    {
+      uint64_t m;
+      const uint64_t *v = literal_patterns (p, inputs[j], &m);
+      for (unsigned i = 0; i < words; i++)
+	res[i] |= v[i] ^ m;
+    }
+}
+
+// An n-ary XNOR gate is the XOR of its inputs negated if 'n' is even.
+
+static void
+simulate_xor_patterns (Patterns * p, Operator op, const unsigned *inputs,
+		       unsigned n, uint64_t * res)
+{
+  const unsigned words = p->words;
+  const uint64_t negate = (op == XNOR_OPERATOR && !(n & 1)) ?
+    ~(uint64_t) 0 : 0;
+  for (unsigned i = 0; i < words; i++)
+    res[i] = negate;
+  for (unsigned j = 0; j < n; j++)
+    {
+      uint64_t m;
+      const uint64_t *v = literal_patterns (p, inputs[j], &m);
+      for (unsigned i = 0; i < words; i++)
+	res[i] ^= v[i] ^ m;
+    }
+}
+
+static void
+simulate_ite_patterns (Patterns * p, const unsigned *inputs,
+		       unsigned n, uint64_t * res)
+{
+  assert (n == 3), (void) n;
+  uint64_t mc, mt, me;
+  const uint64_t *c = literal_patterns (p, inputs[0], &mc);
+  const uint64_t *t = literal_patterns (p, inputs[1], &mt);
+  const uint64_t *e = literal_patterns (p, inputs[2], &me);
+  for (unsigned i = 0; i < p->words; i++)
+    {
+      const uint64_t cond = c[i] ^ mc;
+      res[i] = (cond & (t[i] ^ mt)) | (~cond & (e[i] ^ me));
+    }
+}
+
+// Simulates all gates on the current patterns of the input gates.
+
+void
+simulate_patterns (Patterns * p)
+{
+  Compact *compact = compact_circuit (p->circuit);
+  assert (compact->num_gates == p->gates);
+  for (unsigned g = 0; g < compact->num_gates; g++)
+    {
+      const unsigned *inputs = compact->inputs + compact->first_input[g];
+      const unsigned n = compact->first_input[g + 1] - compact->first_input[g];
+      uint64_t *res = p->values + (size_t) g * p->words;
+      const Operator op = compact->ops[g];
+      switch (op)
+	{
+	case FALSE_OPERATOR:
+	  for (unsigned i = 0; i < p->words; i++)
+	    res[i] = 0;
+	  break;
+	case INPUT_OPERATOR:
+	  break;
+	case AND_OPERATOR:
+	  simulate_and_patterns (p, inputs, n, res);
+	  break;
+	case OR_OPERATOR:
+	  simulate_or_patterns (p, inputs, n, res);
+	  break;
+	case XOR_OPERATOR:
+	case XNOR_OPERATOR:
+	  simulate_xor_patterns (p, op, inputs, n, res);
+	  break;
+	case ITE_OPERATOR:
+	  simulate_ite_patterns (p, inputs, n, res);
+	  break;
+	}
+    }
+}
+
+void
+simulate_random_patterns (Patterns * p, uint64_t * state)
+{
+  for (Gate ** q = p->circuit->gates.start; q != p->circuit->gates.top; q++)
+    {
+      if ((*q)->op != INPUT_OPERATOR)
+	continue;
+      uint64_t *res = gate_patterns (p, *q);
+      for (unsigned i = 0; i < p->words; i++)
+	res[i] = splitmix64 (state);
+    }
+  simulate_patterns (p);
+}
+
+// Returns the first pattern under which the (possibly negated) gate has
+// the given value or a negative number if there is none.
+
+long
+find_pattern (Patterns * p, Gate * g, int value)
+{
+  const uint64_t *v = gate_patterns (p, STRIP (g));
+  const uint64_t m = pattern_mask (g) ^ (value ? 0 : ~(uint64_t) 0);
+  for (unsigned i = 0; i < p->words; i++)
+    {
+      const uint64_t word = v[i] ^ m;
+      if (!word)
+	continue;
+      unsigned bit = 0;
+      while (!(word & ((uint64_t) 1 << bit)))
+	bit++;
+      return 64l * i + bit;
+    }
+  return -1;
+}
+
+void
+set_input_pattern_value (Patterns * p, Gate * g, long pattern, int value)
+{
+  assert (g->op == INPUT_OPERATOR);
+  assert (0 <= pattern && pattern < 64l * p->words);
+  uint64_t *word = gate_patterns (p, g) + pattern / 64;
+  const uint64_t bit = (uint64_t) 1 << (pattern % 64);
+  if (value)
+    *word |= bit;
+  else
+    *word &= ~bit;
+}
+
+int
+pattern_value (Patterns * p, Gate * g, long pattern)
+{
+  assert (0 <= pattern && pattern < 64l * p->words);
+  const uint64_t word = gate_patterns (p, STRIP (g))[pattern / 64];
+  return ((word >> (pattern % 64)) & 1) ^ SIGN (g);
+}
@@ -1 +1,30 @@
 BDD *simulate_circuit (Circuit *);
+BDD *simulate_and_quantify_circuit (Circuit *, IntStack * relevant);
+BDD *simulate_circuit_under_assumptions (Circuit *,
+					 IntStack * relevant,
+					 IntStack * assumptions);
+
+void trace_simulation (FILE *);
+
+typedef struct Patterns Patterns;
+
+#define MAX_PATTERN_WORDS 8
+
+struct Patterns
+{
+  Circuit *circuit;
+  unsigned words;		// 64 patterns per word
+  long gates;
+  uint64_t *values;		// 'words' per gate indexed by 'idx'
+};
+
+Patterns *new_patterns (Circuit *, unsigned words);
+void delete_patterns (Patterns *);
+
+void simulate_random_patterns (Patterns *, uint64_t * state);
+void simulate_patterns (Patterns *);
+
+uint64_t *gate_patterns (Patterns *, Gate *);
+long find_pattern (Patterns *, Gate *, int value);
+int pattern_value (Patterns *, Gate *, long pattern);
+void set_input_pattern_value (Patterns *, Gate *, long pattern, int value);
@@ -1,5 +1,14 @@
 #include "headers.h"
 
+// Messages of a solver are only printed up to its own verbosity level,
+// which might be lower than the global one, e.g., while sweeping.
+
+#define SMSG(LEVEL,...) \
+do { \
+  if (solver->verbosity >= (LEVEL)) \
+    msg ((LEVEL), __VA_ARGS__); \
+} while (0)
+
 /*------------------------------------------------------------------------*/
 
 #ifdef NLOG
@@ -51,12 +60,15 @@ typedef enum Type Type;
 typedef struct Queue Queue;
 typedef struct Frame Frame;
 typedef struct Limit Limit;
+typedef struct Gauss Gauss;
+typedef struct Column Column;
 typedef enum Decision Decision;
 
 // *INDENT-OFF*
 
 typedef STACK (Var *) VarStack;
 typedef STACK (Frame) FrameStack;
+typedef STACK (Gauss *) GaussStack;
 
 // *INDENT-ON*
 
@@ -137,6 +149,43 @@ struct Limit
   } count;
 };
 
+// Native XOR constraints (see '--xor') are propagated by Gauss-Jordan
+// elimination.  Each connected component of XOR constraints of one CNF is
+// a matrix over GF(2) with one bit-packed row per constraint and one
+// column per variable.  A row states that the sum of its columns is its
+// parity.  The matrix is kept in reduced row echelon form, i.e., the pivot
+// column of a row does not occur in any other row.  If the pivot of a row
+// gets assigned, the row is eliminated from all other rows on one of its
+// unassigned columns, which becomes the new pivot.  Thus the residual
+// matrix on the unassigned columns stays in echelon form and all implied
+// units and conflicts show up in single rows.  Row operations preserve the
+// solutions and nothing has to be undone during backtracking.
+//
+// The assignment of columns is copied to bit-sets while assigning (see
+// 'update_columns'), and only rows with changed columns or changed by
+// elimination are visited during propagation.  Reason and conflict clauses
+// are generated from rows on the fly and added as redundant garbage
+// clauses, which are collected as soon as they are not reasons anymore.
+
+struct Gauss
+{
+  char dual;
+  char touched;			// on stack of touched matrices
+  int rows, size, columns, words;
+  uint64_t *matrix;		// 'words' per row
+  uint64_t *assigned, *values;	// assignment of columns
+  uint64_t *changed;		// columns changed since last visit
+  unsigned char *parity, *scheduled;
+  int *pivot, *variable;
+  IntStack schedule;		// rows to visit
+};
+
+struct Column
+{
+  Gauss *gauss;
+  int column;
+};
+
 #define num_report_header_lines 3
 
 struct Solver
@@ -149,7 +198,9 @@ struct Solver
   char model_printing_enabled;
   char split_on_relevant_first;
   char require_to_split_on_relevant_first_after_first_model;
+  const char *split_reason;	// reported when solving starts
 
+  int verbosity;		// messages and reports up to this level
   int max_var, max_lit;
   int max_shared_var, max_primal_or_shared_var;
   int level, phase;
@@ -198,7 +249,32 @@ struct Solver
   } occs;
 
   Number count;
+  long counted;			// models of this solver (not all components)
   Name name;
+  ZDD *models;			// collected partial models
+
+  struct
+  {
+    int level;			// no hybrid counting at or above this level
+    Number count;		// models counted with BDDs
+  } hybrid;
+
+  struct
+  {
+    struct
+    {
+      GaussStack primal, dual;
+    } matrices, touched;
+    struct
+    {
+      Column *primal, *dual;	// column of variable in matrix
+    } columns;
+    struct
+    {
+      char primal, dual;	// found inconsistent XOR constraints
+    } inconsistent;
+    long generated, limit;	// garbage clauses until collection
+  } gauss;
 
   struct
   {
@@ -405,10 +481,13 @@ frame (Solver * solver, int lit)
   return solver->frames.start + v->level;
 }
 
+// The limits below are relative to the global statistics, since several
+// solvers might be used one after the other, e.g., for sweeping.
+
 static void
 init_reduce_limit (Solver * solver)
 {
-  solver->limit.reduce.learned = MAX (options.reduceinit, 0);
+  solver->limit.reduce.learned = stats.learned + MAX (options.reduceinit, 0);
   solver->limit.reduce.interval = MAX (options.reduceinit, 0);
   solver->limit.reduce.increment = MAX (options.reduceinc, 1);
   SOG ("initial reduce interval %ld", solver->limit.reduce.interval);
@@ -419,7 +498,8 @@ init_reduce_limit (Solver * solver)
 static void
 init_restart_limit (Solver * solver)
 {
-  solver->limit.restart.conflicts = MAX (options.restartint, 1);
+  solver->limit.restart.conflicts =
+    stats.conflicts.primal + MAX (options.restartint, 1);
   SOG ("initial restart conflict limit %ld", solver->limit.restart.conflicts);
 }
 
@@ -435,6 +515,7 @@ init_limits (Solver * solver)
 {
   init_reduce_limit (solver);
   init_restart_limit (solver);
+  solver->limit.subsumed = stats.subsumed;
   set_subsumed_learned_limit (solver);
   solver->limit.models.count = LONG_MAX;
   solver->limit.models.report = 1;
@@ -443,12 +524,18 @@ init_limits (Solver * solver)
   solver->limit.count.log2report = 0;
 }
 
+void
+set_solver_verbosity (Solver * solver, int verbosity)
+{
+  solver->verbosity = verbosity;
+}
+
 void
 limit_number_of_partial_models (Solver * solver, long limit)
 {
   assert (limit > 0);
   solver->limit.models.count = limit;
-  msg (1, "number of partial models limited to %ld", limit);
+  SMSG (1, "number of partial models limited to %ld", limit);
 }
 
 static void
@@ -456,7 +543,7 @@ enable_model_printing (Solver * solver, Name name)
 {
   solver->name = name;
   solver->model_printing_enabled = 1;
-  msg (1, "enabled printing of partial models");
+  SMSG (1, "enabled printing of partial models");
 }
 
 static void
@@ -482,6 +569,364 @@ fix_options ()
   check_options_fixed ();
 }
 
+/*------------------------------------------------------------------------*/
+
+static uint64_t *
+gauss_row (Gauss * g, int r)
+{
+  assert (0 <= r), assert (r < g->size);
+  return g->matrix + (size_t) r *g->words;
+}
+
+static uint64_t
+column_bit (int c)
+{
+  return (uint64_t) 1 << (c & 63);
+}
+
+static int
+column_word (int c)
+{
+  return c >> 6;
+}
+
+static int
+gauss_column_assigned (Gauss * g, int c)
+{
+  return (g->assigned[column_word (c)] & column_bit (c)) != 0;
+}
+
+static void
+schedule_gauss_row (Gauss * g, int r)
+{
+  if (g->scheduled[r])
+    return;
+  g->scheduled[r] = 1;
+  PUSH (g->schedule, r);
+}
+
+static void
+schedule_all_gauss_rows (Gauss * g)
+{
+  for (int r = 0; r < g->rows; r++)
+    schedule_gauss_row (g, r);
+}
+
+// Adds row 'r' to all other rows containing column 'c'.
+
+static void
+eliminate_gauss_column (Gauss * g, int r, int c)
+{
+  const uint64_t *row = gauss_row (g, r), bit = column_bit (c);
+  const int w = column_word (c);
+  assert (row[w] & bit);
+  for (int s = 0; s < g->rows; s++)
+    {
+      if (s == r)
+	continue;
+      uint64_t *other = gauss_row (g, s);
+      if (!(other[w] & bit))
+	continue;
+      for (int i = 0; i < g->words; i++)
+	other[i] ^= row[i];
+      g->parity[s] ^= g->parity[r];
+      schedule_gauss_row (g, s);
+    }
+  g->pivot[r] = c;
+  stats.gauss.eliminations++;
+}
+
+static int
+first_gauss_column (Gauss * g, int r)
+{
+  const uint64_t *row = gauss_row (g, r);
+  for (int w = 0; w < g->words; w++)
+    if (row[w])
+      return 64 * w + __builtin_ctzll (row[w]);
+  return -1;
+}
+
+// Initial Gauss-Jordan elimination, which removes empty rows.  Returns
+// zero if an empty row has parity one, i.e., the constraints are
+// inconsistent.
+
+static int
+echelon_gauss (Gauss * g)
+{
+  int rows = 0;
+  for (int r = 0; r < g->rows; r++)
+    {
+      const int c = first_gauss_column (g, r);
+      g->pivot[r] = c;
+      if (c < 0 && g->parity[r])
+	return 0;
+      if (c >= 0)
+	eliminate_gauss_column (g, r, c), rows++;
+    }
+  int s = 0;
+  for (int r = 0; r < g->rows; r++)
+    {
+      if (g->pivot[r] < 0)
+	continue;
+      if (s < r)
+	{
+	  memcpy (gauss_row (g, s), gauss_row (g, r),
+		  g->words * sizeof *g->matrix);
+	  g->parity[s] = g->parity[r];
+	  g->pivot[s] = g->pivot[r];
+	}
+      s++;
+    }
+  assert (s == rows);
+  g->rows = rows;
+  CLEAR (g->schedule);
+  memset (g->scheduled, 0, g->size);
+  schedule_all_gauss_rows (g);
+  return 1;
+}
+
+// The 'columns' map of the variables of the solver is used and reset.
+
+static Gauss *
+new_gauss (Solver * solver, Clauses * xors, int dual, int *columns)
+{
+  Gauss *g;
+  NEW (g);
+  g->dual = dual;
+  for (Clause ** p = xors->start; p != xors->top; p++)
+    for (int i = 0; i < (*p)->size; i++)
+      {
+	const int idx = abs ((*p)->literals[i]);
+	if (!columns[idx])
+	  columns[idx] = ++g->columns;
+      }
+  g->size = g->rows = COUNT (*xors);
+  g->words = (g->columns + 63) / 64;
+  ALLOC (g->matrix, (size_t) g->size * g->words);
+  ALLOC (g->assigned, g->words);
+  ALLOC (g->values, g->words);
+  ALLOC (g->changed, g->words);
+  ALLOC (g->parity, g->size);
+  ALLOC (g->scheduled, g->size);
+  ALLOC (g->pivot, g->size);
+  ALLOC (g->variable, g->columns);
+  Column *map = dual ? solver->gauss.columns.dual :
+    solver->gauss.columns.primal;
+  int r = 0;
+  for (Clause ** p = xors->start; p != xors->top; p++, r++)
+    {
+      uint64_t *row = gauss_row (g, r);
+      g->parity[r] = 1;
+      for (int i = 0; i < (*p)->size; i++)
+	{
+	  const int lit = (*p)->literals[i], idx = abs (lit);
+	  if (columns[idx])
+	    {
+	      const int c = columns[idx] - 1;
+	      g->variable[c] = idx;
+	      map[idx].gauss = g;
+	      map[idx].column = c;
+	      columns[idx] = 0;
+	    }
+	  const int c = map[idx].column;
+	  row[column_word (c)] ^= column_bit (c);
+	  if (lit < 0)
+	    g->parity[r] ^= 1;
+	}
+    }
+  for (int c = 0; c < g->columns; c++)
+    {
+      const int tmp = val (solver, g->variable[c]);
+      if (tmp)
+	g->assigned[column_word (c)] |= column_bit (c);
+      if (tmp > 0)
+	g->values[column_word (c)] |= column_bit (c);
+    }
+  return g;
+}
+
+static void
+delete_gauss (Gauss * g)
+{
+  DEALLOC (g->matrix, (size_t) g->size * g->words);
+  DEALLOC (g->assigned, g->words);
+  DEALLOC (g->values, g->words);
+  DEALLOC (g->changed, g->words);
+  DEALLOC (g->parity, g->size);
+  DEALLOC (g->scheduled, g->size);
+  DEALLOC (g->pivot, g->size);
+  DEALLOC (g->variable, g->columns);
+  RELEASE (g->schedule);
+  DELETE (g);
+}
+
+static int
+find_xor_component (int *repr, int idx)
+{
+  while (repr[idx] != idx)
+    idx = repr[idx] = repr[repr[idx]];
+  return idx;
+}
+
+static int
+cmp_xor_component (const void *p, const void *q)
+{
+  int *a = (int *) p, *b = (int *) q;
+  int res = a[0] - b[0];
+  return res ? res : a[1] - b[1];
+}
+
+// One matrix is generated for each connected component of the XOR
+// constraints, i.e., sharing variables, which keeps matrices small.
+
+static void
+new_gauss_matrices (Solver * solver, CNF * cnf, GaussStack * matrices)
+{
+  Clauses *xors = &cnf->xors;
+  if (EMPTY (*xors))
+    return;
+  int *repr;
+  ALLOC (repr, solver->max_var + 1);
+  for (int idx = 1; idx <= solver->max_var; idx++)
+    repr[idx] = idx;
+  for (Clause ** p = xors->start; p != xors->top; p++)
+    {
+      Clause *c = *p;
+      assert (c->size > 0);
+      const int first = find_xor_component (repr, abs (c->literals[0]));
+      for (int i = 1; i < c->size; i++)
+	{
+	  const int other = find_xor_component (repr, abs (c->literals[i]));
+	  if (other != first)
+	    repr[other] = first;
+	}
+    }
+  IntStack components;
+  INIT (components);
+  const int n = COUNT (*xors);
+  for (int i = 0; i < n; i++)
+    {
+      Clause *c = PEEK (*xors, i);
+      PUSH (components, find_xor_component (repr, abs (c->literals[0])));
+      PUSH (components, i);
+    }
+  qsort (components.start, n, 2 * sizeof (int), cmp_xor_component);
+  int *columns = repr;
+  memset (columns, 0, (solver->max_var + 1) * sizeof *columns);
+  Clauses component;
+  INIT (component);
+  const char *type = cnf->dual ? "dual" : "primal";
+  for (int i = 0; i < n; i++)
+    {
+      const int root = components.start[2 * i];
+      PUSH (component, PEEK (*xors, components.start[2 * i + 1]));
+      if (i + 1 < n && components.start[2 * i + 2] == root)
+	continue;
+      Gauss *g = new_gauss (solver, &component, cnf->dual, columns);
+      SOG ("new %s matrix with %d rows and %d columns",
+	   type, g->rows, g->columns);
+      if (!echelon_gauss (g))
+	{
+	  SOG ("inconsistent %s XOR constraints", type);
+	  if (cnf->dual)
+	    solver->gauss.inconsistent.dual = 1;
+	  else
+	    solver->gauss.inconsistent.primal = 1;
+	}
+      PUSH (*matrices, g);
+      g->touched = 1;
+      CLEAR (component);
+    }
+  RELEASE (component);
+  RELEASE (components);
+  DEALLOC (repr, solver->max_var + 1);
+  msg (2, "%d %s XOR constraints in %ld matrices", n, type,
+       (long) COUNT (*matrices));
+}
+
+static void
+new_gauss_solver (Solver * solver)
+{
+  CNF *primal = solver->cnf.primal, *dual = solver->cnf.dual;
+  if (EMPTY (primal->xors) && (!dual || EMPTY (dual->xors)))
+    return;
+  ALLOC (solver->gauss.columns.primal, solver->max_var + 1);
+  new_gauss_matrices (solver, primal, &solver->gauss.matrices.primal);
+  if (dual)
+    {
+      ALLOC (solver->gauss.columns.dual, solver->max_var + 1);
+      new_gauss_matrices (solver, dual, &solver->gauss.matrices.dual);
+    }
+  for (Gauss ** p = solver->gauss.matrices.primal.start;
+       p != solver->gauss.matrices.primal.top; p++)
+    PUSH (solver->gauss.touched.primal, *p);
+  for (Gauss ** p = solver->gauss.matrices.dual.start;
+       p != solver->gauss.matrices.dual.top; p++)
+    PUSH (solver->gauss.touched.dual, *p);
+  solver->gauss.limit = 1000 + solver->max_var;
+}
+
+static void
+delete_gauss_matrices (GaussStack * matrices)
+{
+  for (Gauss ** p = matrices->start; p != matrices->top; p++)
+    delete_gauss (*p);
+  RELEASE (*matrices);
+}
+
+static void
+delete_gauss_solver (Solver * solver)
+{
+  delete_gauss_matrices (&solver->gauss.matrices.primal);
+  delete_gauss_matrices (&solver->gauss.matrices.dual);
+  RELEASE (solver->gauss.touched.primal);
+  RELEASE (solver->gauss.touched.dual);
+  if (solver->gauss.columns.primal)
+    DEALLOC (solver->gauss.columns.primal, solver->max_var + 1);
+  if (solver->gauss.columns.dual)
+    DEALLOC (solver->gauss.columns.dual, solver->max_var + 1);
+}
+
+// Copies the value of a variable to the bit-sets of its columns.
+
+static void
+update_column (Column * column, int tmp, GaussStack * touched)
+{
+  Gauss *g = column->gauss;
+  if (!g)
+    return;
+  const int c = column->column, w = column_word (c);
+  const uint64_t bit = column_bit (c);
+  if (tmp)
+    g->assigned[w] |= bit;
+  else
+    g->assigned[w] &= ~bit;
+  if (tmp > 0)
+    g->values[w] |= bit;
+  else
+    g->values[w] &= ~bit;
+  g->changed[w] |= bit;
+  if (g->touched)
+    return;
+  g->touched = 1;
+  PUSH (*touched, g);
+}
+
+static void
+update_columns (Solver * solver, int idx)
+{
+  if (!solver->gauss.columns.primal)
+    return;
+  const int tmp = solver->vars[idx].val;
+  update_column (solver->gauss.columns.primal + idx, tmp,
+		 &solver->gauss.touched.primal);
+  if (solver->gauss.columns.dual)
+    update_column (solver->gauss.columns.dual + idx, tmp,
+		   &solver->gauss.touched.dual);
+}
+
+/*------------------------------------------------------------------------*/
+
 Solver *
 new_solver (CNF * primal, IntStack * shared, IntStack * relevant, CNF * dual)
 {
@@ -489,6 +934,7 @@ new_solver (CNF * primal, IntStack * shared, IntStack * relevant, CNF * dual)
   assert (primal);
   Solver *solver;
   NEW (solver);
+  solver->verbosity = options.verbosity;
   solver->cnf.primal = primal;
   if (dual)
     {
@@ -640,9 +1086,12 @@ new_solver (CNF * primal, IntStack * shared, IntStack * relevant, CNF * dual)
   push_frame (solver, 0);
   assert (COUNT (solver->frames) == solver->level + 1);
   init_number (solver->count);
+  init_number (solver->hybrid.count);
+  solver->hybrid.level = INT_MAX;
+  new_gauss_solver (solver);
   if (options.relevant)
     {
-      msg (1, "forced to split on relevant variables first");
+      solver->split_reason = "forced to split on relevant variables first";
       solver->split_on_relevant_first = 1;
     }
   else
@@ -659,8 +1108,7 @@ new_solver (CNF * primal, IntStack * shared, IntStack * relevant, CNF * dual)
 	reason = 0;
       if (reason)
 	{
-	  msg (1, "split on relevant variables after first model (%s)",
-	       reason);
+	  solver->split_reason = reason;
 	  solver->require_to_split_on_relevant_first_after_first_model = 1;
 	}
     }
@@ -759,13 +1207,17 @@ delete_solver (Solver * solver)
   RELEASE (solver->seen);
   RELEASE (solver->relevant);
   RELEASE (solver->clause);
+  if (solver->models)
+    delete_zdd (solver->models);
   RELEASE (solver->levels);
   RELEASE (solver->units);
+  delete_gauss_solver (solver);
   DEALLOC (solver->vars, solver->max_var + 1);
   for (int i = 0; i < num_report_header_lines; i++)
     RELEASE (solver->report.buffer[i]);
   RELEASE (solver->report.columns);
   clear_number (solver->count);
+  clear_number (solver->hybrid.count);
   clear_number (solver->limit.count.report);
   DELETE (solver);
 }
@@ -859,6 +1311,7 @@ assign (Solver * solver, int lit, Clause * reason)
     }
   PUSH (solver->trail, lit);
   dec_unassigned (solver, v);
+  update_columns (solver, idx);
 }
 
 #ifndef NDEBUG
@@ -1044,6 +1497,7 @@ flip_decision (Solver * solver, long *rule)
   POKE (solver->trail, f->trail, -decision);
   adjust_next (solver, f->trail);
   v->val = -v->val;
+  update_columns (solver, abs (decision));
 }
 
 /*------------------------------------------------------------------------*/
@@ -1067,6 +1521,7 @@ unassign (Solver * solver, int lit)
 	update_queue (solver, q, v);
     }
   inc_unassigned (solver, v);
+  update_columns (solver, abs (lit));
   return res;
 }
 
@@ -1095,6 +1550,12 @@ connect_primal_cnf (Solver * solver)
   CNF *cnf = solver->cnf.primal;
   Clauses *clauses = &cnf->clauses;
   SOG ("connecting %ld primal clauses to solver", (long) COUNT (*clauses));
+  if (solver->gauss.inconsistent.primal)
+    {
+      SOG ("found inconsistent primal XOR constraints");
+      RULE0 (EP0);
+      return 0;
+    }
   for (Clause ** p = clauses->start; p < clauses->top; p++)
     {
       Clause *c = *p;
@@ -1175,6 +1636,31 @@ print_model (Solver * solver)
   fputc ('\n', stdout);
 }
 
+// Adds all models of the current partial model to the ZDD.  Since union
+// is idempotent, models counted twice and later discounted by the dual
+// engine are only collected once anyhow.
+
+static void
+collect_model (Solver * solver)
+{
+  assert (solver->models);
+  IntStack cube;
+  INIT (cube);
+  for (const int *p = solver->relevant.start; p != solver->relevant.top; p++)
+    {
+      const int lit = *p;
+      const int tmp = val (solver, lit);
+      if (tmp)
+	PUSH (cube, tmp < 0 ? -lit : lit);
+    }
+  ZDD *model = cube_zdd (&cube);
+  ZDD *models = union_zdd (solver->models, model);
+  delete_zdd (solver->models);
+  delete_zdd (model);
+  solver->models = models;
+  RELEASE (cube);
+}
+
 static void
 print_discount (Solver * solver, Frame * f)
 {
@@ -1187,9 +1673,9 @@ static int
 model_limit_reached (Solver * solver)
 {
   const long limit = solver->limit.models.count;
-  const int res = (stats.models.counted >= limit);
+  const int res = (solver->counted >= limit);
   if (res)
-    msg (1, "reached partial models limit %ld", limit);
+    SMSG (1, "reached partial models limit %ld", limit);
   return res;
 }
 
@@ -1220,7 +1706,7 @@ remaining_variables (Solver * solver)
 static void
 inc_model_report_limit (Solver * solver)
 {
-  while (stats.models.counted >= solver->limit.models.report)
+  while (solver->counted >= solver->limit.models.report)
     {
       solver->limit.models.log2report++;
       solver->limit.models.report *= 2;
@@ -1279,7 +1765,7 @@ column (Solver * solver, const char *name,
 static void
 report (Solver * solver, int verbosity, char ch)
 {
-  if (verbosity > options.verbosity)
+  if (verbosity > solver->verbosity)
     return;
   ENTRIES = solver->dual_solving_enabled ? num_report_header_lines - 1 : 0;
   CLEAR (COLUMNS);
@@ -1318,7 +1804,7 @@ report (Solver * solver, int verbosity, char ch)
 static int
 restart_after_first_model_to_split_on_relevant_first (Solver * solver)
 {
-  if (stats.models.counted)
+  if (solver->counted)
     return 0;
   if (solver->split_on_relevant_first)
     return 0;
@@ -1341,14 +1827,17 @@ new_model (Solver * solver)
 {
   int unassigned = solver->unassigned_relevant_variables;
   stats.models.counted++;
+  solver->counted++;
   SOG ("model %ld with %d unassigned relevant variables",
        stats.models, unassigned);
-  if (stats.models.counted == 1)
+  if (solver->counted == 1)
     first_model (solver);
   if (solver->model_printing_enabled)
     print_model (solver);
+  if (solver->models)
+    collect_model (solver);
   add_power_of_two_to_number (solver->count, unassigned);
-  if (stats.models.counted == solver->limit.models.report)
+  if (solver->counted == solver->limit.models.report)
     report (solver, 1, '+');
   else
     report (solver, 3, 'm');
@@ -1373,6 +1862,12 @@ connect_dual_cnf (Solver * solver)
   Clauses *clauses = &cnf->clauses;
   SOG ("connecting %ld dual clauses to solver for counting",
        (long) COUNT (*clauses));
+  if (solver->gauss.inconsistent.dual)
+    {
+      SOG ("found inconsistent dual XOR constraints");
+      RULE0 (EN0);
+      return 0;
+    }
   for (Clause ** p = clauses->start; p < clauses->top; p++)
     {
       Clause *c = *p;
@@ -1407,7 +1902,7 @@ report_iterating (Solver * solver)
 }
 
 static Clause *
-primal_propagate (Solver * solver)
+primal_propagate_clauses (Solver * solver)
 {
   SOG ("primal propagation");
   Clause *res = 0;
@@ -1487,7 +1982,6 @@ primal_propagate (Solver * solver)
 	*q++ = *p++;
       o->top = q;
     }
-  report_iterating (solver);
   return res;
 }
 
@@ -1544,6 +2038,173 @@ dual_force (Solver * solver, Clause * c, int lit)
   return 0;
 }
 
+/*------------------------------------------------------------------------*/
+
+static void flush_primal_garbage_occurrences (Solver *);
+static void flush_dual_garbage_occurrences (Solver *);
+
+// Reason and conflict clauses of rows are collected eagerly, since they
+// are generated for every propagation of a row.
+
+static void
+collect_gauss_clauses (Solver * solver)
+{
+  if (solver->gauss.generated <= solver->gauss.limit)
+    return;
+  SOG ("collecting %ld generated XOR clauses", solver->gauss.generated);
+  flush_primal_garbage_occurrences (solver);
+  collect_garbage_clauses (solver->cnf.primal);
+  if (solver->dual_solving_enabled)
+    {
+      flush_dual_garbage_occurrences (solver);
+      collect_garbage_clauses (solver->cnf.dual);
+    }
+  solver->gauss.generated = 0;
+}
+
+// Generates the clause of row 'r' which is the reason of 'lit' or the
+// conflict if 'lit' is zero.  All other literals are false.
+
+static Clause *
+gauss_clause (Solver * solver, Gauss * g, int r, int lit)
+{
+  assert (EMPTY (solver->clause));
+  if (lit)
+    PUSH (solver->clause, lit);
+  const uint64_t *row = gauss_row (g, r);
+  for (int w = 0; w < g->words; w++)
+    for (uint64_t bits = row[w]; bits; bits &= bits - 1)
+      {
+	const int c = 64 * w + __builtin_ctzll (bits);
+	const int idx = g->variable[c];
+	if (idx == abs (lit))
+	  continue;
+	const int tmp = val (solver, idx);
+	assert (tmp);
+	PUSH (solver->clause, tmp < 0 ? idx : -idx);
+      }
+  const int size = COUNT (solver->clause);
+  Clause *res = new_clause (solver->clause.start, size);
+  CLEAR (solver->clause);
+  res->dual = g->dual;
+  res->redundant = 1;
+  res->garbage = 1;
+  add_clause_to_cnf (res, cnf (solver, res));
+  solver->gauss.generated++;
+  return res;
+}
+
+static Clause *
+propagate_gauss_row (Solver * solver, Gauss * g, int r)
+{
+  const uint64_t *row = gauss_row (g, r);
+  int unassigned = 0, column = -1;
+  unsigned parity = g->parity[r];
+  for (int w = 0; w < g->words; w++)
+    {
+      parity ^= __builtin_parityll (row[w] & g->values[w]);
+      const uint64_t bits = row[w] & ~g->assigned[w];
+      if (!bits)
+	continue;
+      if (column < 0)
+	column = 64 * w + __builtin_ctzll (bits);
+      unassigned += __builtin_popcountll (bits);
+    }
+  if (!unassigned)
+    {
+      if (!parity)
+	return 0;
+      Clause *res = gauss_clause (solver, g, r, 0);
+      SOGCLS (res, "XOR conflict");
+      stats.gauss.conflicts++;
+      if (g->dual)
+	stats.conflicts.dual++;
+      else
+	stats.conflicts.primal++;
+      return res;
+    }
+  if (gauss_column_assigned (g, g->pivot[r]))
+    {
+      SOG ("new pivot %d of row %d", g->variable[column], r);
+      eliminate_gauss_column (g, r, column);
+    }
+  if (unassigned > 1)
+    return 0;
+  assert (g->pivot[r] == column);
+  const int idx = g->variable[column], lit = parity ? idx : -idx;
+  Clause *reason = gauss_clause (solver, g, r, lit);
+  stats.gauss.propagations++;
+  if (g->dual)
+    return dual_force (solver, reason, lit);
+  SOGCLS (reason, "XOR forcing %d", lit);
+  assign (solver, lit, reason);
+  RULE1 (UP, lit);
+  return 0;
+}
+
+// Schedules rows with changed columns and then visits scheduled rows.
+
+static Clause *
+propagate_gauss (Solver * solver, Gauss * g)
+{
+  for (int w = 0; w < g->words; w++)
+    {
+      const uint64_t changed = g->changed[w];
+      if (!changed)
+	continue;
+      for (int r = 0; r < g->rows; r++)
+	if (gauss_row (g, r)[w] & changed)
+	  schedule_gauss_row (g, r);
+      g->changed[w] = 0;
+    }
+  Clause *res = 0;
+  while (!res && !EMPTY (g->schedule))
+    {
+      const int r = POP (g->schedule);
+      g->scheduled[r] = 0;
+      res = propagate_gauss_row (solver, g, r);
+    }
+  return res;
+}
+
+static Clause *
+propagate_gauss_matrices (Solver * solver, GaussStack * touched)
+{
+  Clause *res = 0;
+  while (!res && !EMPTY (*touched))
+    {
+      Gauss *g = POP (*touched);
+      assert (g->touched);
+      g->touched = 0;
+      res = propagate_gauss (solver, g);
+      if (res && !g->touched && !EMPTY (g->schedule))
+	{
+	  g->touched = 1;
+	  PUSH (*touched, g);
+	}
+    }
+  return res;
+}
+
+static Clause *
+primal_propagate (Solver * solver)
+{
+  Clause *res = 0;
+  for (;;)
+    {
+      res = primal_propagate_clauses (solver);
+      if (res || EMPTY (solver->gauss.touched.primal))
+	break;
+      collect_gauss_clauses (solver);
+      const size_t before = COUNT (solver->trail);
+      res = propagate_gauss_matrices (solver, &solver->gauss.touched.primal);
+      if (res || COUNT (solver->trail) == before)
+	break;
+    }
+  report_iterating (solver);
+  return res;
+}
+
 // Propagate collected dual unit clauses on root level.
 
 static Clause *
@@ -1678,8 +2339,18 @@ dual_propagate (Solver * solver)
   Clause *res = 0;
   if (!solver->last_decision_level)
     res = dual_propagate_units (solver);
-  if (!res)
-    res = dual_propagate_trail (solver);
+  while (!res)
+    {
+      res = dual_propagate_trail (solver);
+      if (res || EMPTY (solver->gauss.touched.dual))
+	break;
+      collect_gauss_clauses (solver);
+      const size_t before = COUNT (solver->trail);
+      res = propagate_gauss_matrices (solver, &solver->gauss.touched.dual);
+      if (res || COUNT (solver->trail) == before)
+	break;
+      update_primal_propagated (solver);
+    }
   report_iterating (solver);
   return res;
 }
@@ -1750,7 +2421,7 @@ check_no_empty_clause (Solver * solver)
       if (!cnf)
 	continue;
       for (Clause ** p = cnf->clauses.start; p != cnf->clauses.top; p++)
-	assert (!is_unit_clause (solver, *p));
+	assert ((*p)->garbage || !is_unit_clause (solver, *p));
     }
 }
 
@@ -1778,7 +2449,7 @@ check_no_unit_clause (Solver * solver)
       if (!cnf)
 	continue;
       for (Clause ** p = cnf->clauses.start; p != cnf->clauses.top; p++)
-	assert (!is_empty_clause (solver, *p));
+	assert ((*p)->garbage || !is_empty_clause (solver, *p));
     }
 }
 
@@ -2215,7 +2886,6 @@ backtrack_primal_satisfied_learn (Solver * solver, int level)
 {
   SOG ("applying primal satisfied learning rule");
 
-  check_primal_satisfied (solver);
   assert (is_relevant_decision_level (solver, level));
   check_no_relevant_decision_above_level (solver, level);
 
@@ -2257,22 +2927,26 @@ backtrack_accumulating_flipped_counts (Solver * solver, int level)
   SOGNUM (f->count, "final level %d flipping count", level);
 }
 
+static void
+flip_primal_satisfied (Solver * solver, int level)
+{
+  backtrack_accumulating_flipped_counts (solver, level);
+  flip_decision (solver, &rules.BP1F);
+  register_new_fixed_variable (solver);
+  adjust_next_to_trail (solver);
+}
+
 static void
 backtrack_primal_satisfied_flip (Solver * solver, int level, int counted)
 {
   SOG ("applying primal satisfied flipping rule");
 
   assert (counted >= 0);
-  check_primal_satisfied (solver);
   assert (is_relevant_decision_level (solver, level));
   check_no_relevant_decision_above_level (solver, level);
 
   initialize_count (solver, level, counted);
-  backtrack_accumulating_flipped_counts (solver, level);
-
-  flip_decision (solver, &rules.BP1F);
-  register_new_fixed_variable (solver);
-  adjust_next_to_trail (solver);
+  flip_primal_satisfied (solver, level);
 }
 
 static int
@@ -3005,9 +3679,285 @@ restart (Solver * solver)
   report (solver, 2, 'r');
 }
 
+/*------------------------------------------------------------------------*/
+
+// Hybrid counting compiles the residual primal clauses into a BDD as soon
+// as only a few relevant variables are left unassigned.  Unassigned
+// irrelevant and gate variables are quantified and the models over the
+// unassigned relevant variables are counted with 'count_bdd'.  Then we
+// backtrack as if a single partial model was found, just with this count
+// instead of a power of two.  Learned and blocking clauses are part of the
+// residual too, which makes sure that no model is counted twice.
+//
+// This is only sound if all decisions on the trail are relevant.  If the
+// residual has too many clauses, too many BDD nodes or no model at all,
+// we give up on hybrid counting until backtracking below that level.
+
+static int
+hybrid_counting_enabled (Solver * solver)
+{
+  if (!options.hybrid)
+    return 0;
+  if (solver->model_printing_enabled || solver->models)
+    return 0;
+  if (solver->level < solver->hybrid.level)
+    solver->hybrid.level = INT_MAX;
+  else
+    return 0;
+  if (!solver->split_on_relevant_first &&
+      solver->require_to_split_on_relevant_first_after_first_model)
+    return 0;
+  const int unassigned = solver->unassigned_relevant_variables;
+  return unassigned && unassigned <= options.hybridvars;
+}
+
+static BDD *
+residual_clause_bdd (Solver * solver, Clause * c)
+{
+  BDD *res = false_bdd ();
+  for (int i = 0; i < c->size; i++)
+    {
+      const int lit = c->literals[i];
+      const int tmp = val (solver, lit);
+      if (tmp > 0)
+	{
+	  delete_bdd (res);
+	  return 0;
+	}
+      if (tmp < 0)
+	continue;
+      BDD *b = new_bdd (abs (lit));
+      if (lit < 0)
+	{
+	  BDD *n = not_bdd (b);
+	  delete_bdd (b);
+	  b = n;
+	}
+      BDD *d = or_bdd (res, b);
+      delete_bdd (res);
+      delete_bdd (b);
+      res = d;
+    }
+  assert (!is_false_bdd (res));
+  return res;
+}
+
+// Rows of XOR constraints are part of the residual unless all their
+// columns are assigned (then they are satisfied after propagation).
+
+static BDD *
+residual_gauss_row_bdd (Gauss * g, int r)
+{
+  const uint64_t *row = gauss_row (g, r);
+  unsigned parity = g->parity[r];
+  BDD *res = false_bdd ();
+  int unassigned = 0;
+  for (int w = 0; w < g->words; w++)
+    {
+      parity ^= __builtin_parityll (row[w] & g->values[w]);
+      for (uint64_t bits = row[w] & ~g->assigned[w]; bits; bits &= bits - 1)
+	{
+	  const int c = 64 * w + __builtin_ctzll (bits);
+	  BDD *b = new_bdd (g->variable[c]);
+	  BDD *x = xor_bdd (res, b);
+	  delete_bdd (res);
+	  delete_bdd (b);
+	  res = x;
+	  unassigned++;
+	}
+    }
+  if (!unassigned)
+    {
+      assert (!parity);
+      delete_bdd (res);
+      return 0;
+    }
+  if (!parity)
+    {
+      BDD *n = not_bdd (res);
+      delete_bdd (res);
+      res = n;
+    }
+  return res;
+}
+
+static int
+residual_gauss_row (Gauss * g, int r)
+{
+  const uint64_t *row = gauss_row (g, r);
+  for (int w = 0; w < g->words; w++)
+    if (row[w] & ~g->assigned[w])
+      return 1;
+  return 0;
+}
+
+static int
+residual_clauses (Solver * solver)
+{
+  int res = 0;
+  Clauses *clauses = &solver->cnf.primal->clauses;
+  for (Clause ** p = clauses->start; p != clauses->top; p++)
+    {
+      Clause *c = *p;
+      if (c->garbage)
+	continue;
+      int satisfied = 0;
+      for (int i = 0; !satisfied && i < c->size; i++)
+	satisfied = (val (solver, c->literals[i]) > 0);
+      if (satisfied)
+	continue;
+      if (++res > options.hybridcls)
+	return res;
+    }
+  GaussStack *matrices = &solver->gauss.matrices.primal;
+  for (Gauss ** p = matrices->start; p != matrices->top; p++)
+    for (int r = 0; r < (*p)->rows; r++)
+      if (residual_gauss_row (*p, r) && ++res > options.hybridcls)
+	return res;
+  return res;
+}
+
+static int
+count_residual_clauses (Solver * solver)
+{
+  init_bdds ();
+  limit_number_of_bdd_nodes (options.hybridnodes);
+  BDD *res = true_bdd ();
+  Clauses *clauses = &solver->cnf.primal->clauses;
+  for (Clause ** p = clauses->start;
+       p != clauses->top && !bdd_node_limit_reached (); p++)
+    {
+      Clause *c = *p;
+      if (c->garbage)
+	continue;
+      BDD *b = residual_clause_bdd (solver, c);
+      if (!b)
+	continue;
+      BDD *tmp = and_bdd (res, b);
+      delete_bdd (res);
+      delete_bdd (b);
+      res = tmp;
+    }
+  GaussStack *matrices = &solver->gauss.matrices.primal;
+  for (Gauss ** p = matrices->start; p != matrices->top; p++)
+    for (int r = 0; r < (*p)->rows && !bdd_node_limit_reached (); r++)
+      {
+	BDD *b = residual_gauss_row_bdd (*p, r);
+	if (!b)
+	  continue;
+	BDD *tmp = and_bdd (res, b);
+	delete_bdd (res);
+	delete_bdd (b);
+	res = tmp;
+      }
+  IntStack quantify, domain;
+  INIT (quantify);
+  INIT (domain);
+  for (int idx = 1; idx <= solver->max_primal_or_shared_var; idx++)
+    {
+      if (val (solver, idx))
+	continue;
+      if (is_relevant_var (var (solver, idx)))
+	PUSH (domain, idx);
+      else
+	PUSH (quantify, idx);
+    }
+  assert (COUNT (domain) == solver->unassigned_relevant_variables);
+  if (!EMPTY (quantify) && !bdd_node_limit_reached ())
+    {
+      BDD *tmp = exists_bdd (res, &quantify);
+      delete_bdd (res);
+      res = tmp;
+    }
+  const int counted = !bdd_node_limit_reached () && !is_false_bdd (res);
+  if (counted)
+    {
+      clear_number (solver->hybrid.count);
+      init_number (solver->hybrid.count);
+      count_bdd (solver->hybrid.count, res, &domain);
+    }
+  else if (bdd_node_limit_reached ())
+    stats.hybrid.limited++;
+  else
+    stats.hybrid.unsatisfiable++;
+  delete_bdd (res);
+  reset_bdds ();
+  RELEASE (quantify);
+  RELEASE (domain);
+  return counted;
+}
+
+static int
+hybrid_counting (Solver * solver)
+{
+  if (!hybrid_counting_enabled (solver))
+    return 0;
+  stats.hybrid.tried++;
+  int clauses = residual_clauses (solver);
+  SOG ("trying hybrid counting of %d residual clauses with "
+       "%d unassigned relevant variables",
+       clauses, solver->unassigned_relevant_variables);
+  if (clauses <= options.hybridcls && count_residual_clauses (solver))
+    {
+      stats.hybrid.counted++;
+      SOGNUM (solver->hybrid.count, "hybrid counted");
+      return 1;
+    }
+  if (clauses > options.hybridcls)
+    stats.hybrid.limited++;
+  SOG ("disabling hybrid counting at and above level %d", solver->level);
+  solver->hybrid.level = solver->level;
+  return 0;
+}
+
+static int
+backtrack_hybrid_counted (Solver * solver)
+{
+  SOG ("backtrack hybrid counted");
+  stats.models.counted++;
+  solver->counted++;
+  if (solver->counted == 1)
+    first_model (solver);
+  add_number (solver->count, solver->hybrid.count);
+  if (solver->counted == solver->limit.models.report)
+    report (solver, 1, '+');
+  else
+    report (solver, 3, 'h');
+  if (model_limit_reached (solver))
+    return 0;
+  if (!solver->last_relevant_level)
+    {
+      SOG ("hybrid counted without any relevant decisions on the trail");
+      check_no_relevant_decision_above_level (solver, 0);
+      RULE0 (EP1);
+      return 0;
+    }
+  stats.back.tracked++;
+  int level = solver->last_relevant_level;
+  check_no_relevant_decision_above_level (solver, level);
+  if (blocking (solver, level))
+    backtrack_primal_satisfied_learn (solver, level);
+  else
+    {
+      SOG ("applying hybrid counted flipping rule");
+      Frame *f = frame_at_level (solver, level);
+      add_number (f->count, solver->hybrid.count);
+      f->counted++;
+      flip_primal_satisfied (solver, level);
+    }
+  return 1;
+}
+
+/*------------------------------------------------------------------------*/
+
 static void
 solve (Solver * solver)
 {
+  if (solver->split_on_relevant_first)
+    SMSG (1, "%s", solver->split_reason);
+  else if (solver->split_reason)
+    SMSG (1, "split on relevant variables after first model (%s)",
+	  solver->split_reason);
   if (model_limit_reached (solver))
     return;
   if (!connect_primal_cnf (solver))
@@ -3049,6 +3999,11 @@ solve (Solver * solver)
 	    reduce (solver);
 	  else if (restarting (solver))
 	    restart (solver);
+	  else if (hybrid_counting (solver))
+	    {
+	      if (!backtrack_hybrid_counted (solver))
+		return;
+	    }
 	  else
 	    decide (solver);
 	}
@@ -3060,11 +4015,11 @@ solve (Solver * solver)
 int
 primal_sat (Solver * solver)
 {
-  msg (1, "primal checking");
+  SMSG (1, "primal checking");
   assert (!solver->dual_solving_enabled);
   limit_number_of_partial_models (solver, 1);
   solve (solver);
-  return stats.models.counted ? 10 : 20;
+  return solver->counted ? 10 : 20;
 }
 
 int
@@ -3073,7 +4028,7 @@ dual_sat (Solver * solver)
   assert (solver->dual_solving_enabled);
   limit_number_of_partial_models (solver, 1);
   solve (solver);
-  return stats.models.counted ? 10 : 20;
+  return solver->counted ? 10 : 20;
 }
 
 void
@@ -3108,12 +4063,41 @@ dual_enumerate (Solver * solver, Name name)
   solve (solver);
 }
 
+// Instead of printing models they are collected in a ZDD, which has to be
+// initialized with the relevant variables as domain.
+
+static ZDD *
+collect_models (Solver * solver)
+{
+  assert (!solver->models);
+  solver->models = empty_zdd ();
+  SMSG (1, "collecting partial models in ZDD");
+  solve (solver);
+  ZDD *res = solver->models;
+  solver->models = 0;
+  return res;
+}
+
+ZDD *
+primal_enumerate_zdd (Solver * solver)
+{
+  assert (!solver->dual_solving_enabled);
+  return collect_models (solver);
+}
+
+ZDD *
+dual_enumerate_zdd (Solver * solver)
+{
+  assert (solver->dual_solving_enabled);
+  return collect_models (solver);
+}
+
 /*------------------------------------------------------------------------*/
 
 int
 deref (Solver * solver, int lit)
 {
-  assert (stats.models.counted > 0);
+  assert (solver->counted > 0);
   Var *v = var (solver, lit);
   int res = v->first;
   if (lit < 0)
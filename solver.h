@@ -4,6 +4,7 @@ Solver *new_solver (CNF * primal, IntStack * shared,	// all shared variables
 		    IntStack * relevant,	// sub set of relevant shared
 		    CNF * dual);
 
+void set_solver_verbosity (Solver *, int verbosity);
 void limit_number_of_partial_models (Solver *, long limit);
 
 int primal_sat (Solver *);
@@ -16,4 +17,9 @@ void dual_count (Number, Solver *);
 void primal_enumerate (Solver *, Name);
 void dual_enumerate (Solver *, Name);
 
+#include "zdd.h"
+
+ZDD *primal_enumerate_zdd (Solver *);
+ZDD *dual_enumerate_zdd (Solver *);
+
 void delete_solver (Solver *);
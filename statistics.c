@@ -28,6 +28,23 @@ print_rules ()
   msg (1, "%12ld FP   %12ld FN", rules.FP, rules.FN);
 }
 
+static void
+print_bdd_histogram (const char *name, long *histogram)
+{
+  long total = 0;
+  for (int i = 0; i < BDD_HISTOGRAM; i++)
+    total += histogram[i];
+  if (!total)
+    return;
+  char line[256];
+  int len = 0;
+  for (int i = 0; i < BDD_HISTOGRAM; i++)
+    len += snprintf (line + len, sizeof line - len, " %d%s:%.0f%%",
+		     i, (i + 1 == BDD_HISTOGRAM ? "+" : ""),
+		     percent (histogram[i], total));
+  msg (2, "%s%s", name, line);
+}
+
 void
 print_statistics ()
 {
@@ -50,6 +67,16 @@ print_statistics ()
 	msg (1, "%ld discounted partial models (%.1f%% per counted model)",
 	     stats.models.discounted,
 	     percent (stats.models.discounted, stats.models.counted));
+      if (stats.hybrid.tried)
+	msg (1, "%ld hybrid BDD counts (%.0f%% of %ld tried, %ld limited, "
+	     "%ld unsatisfiable)", stats.hybrid.counted,
+	     percent (stats.hybrid.counted, stats.hybrid.tried),
+	     stats.hybrid.tried, stats.hybrid.limited,
+	     stats.hybrid.unsatisfiable);
+      if (stats.gauss.propagations || stats.gauss.conflicts)
+	msg (1, "%ld XOR propagations, %ld XOR conflicts, "
+	     "%ld eliminations", stats.gauss.propagations,
+	     stats.gauss.conflicts, stats.gauss.eliminations);
       if (stats.back.discounting)
 	msg (1, "%ld backjumps with discounting (%.0f%% of all backjumps)",
 	     stats.back.discounting,
@@ -146,7 +173,36 @@ print_statistics ()
 	   stats.bdd.cache.lookups ?
 	   stats.bdd.cache.collisions /
 	   (double) stats.bdd.cache.lookups : 0.0);
+      msg (1, "peak %ld live BDD nodes, %ld freed BDD nodes",
+	   stats.bdd.peak, stats.bdd.freed);
+      for (int op = 0; op < NUM_BDD_OPS; op++)
+	{
+	  long hits = stats.bdd.ops[op].hits;
+	  long misses = stats.bdd.ops[op].misses;
+	  if (hits || misses)
+	    msg (1, "%-7s BDD cache %ld hits, %ld misses (%.0f%% hit rate)",
+		 bdd_op_name (op), hits, misses, percent (hits, hits + misses));
+	}
+      print_bdd_histogram ("unique table probes", stats.bdd.probes);
+      if (stats.bdd.table)
+	{
+	  char name[64];
+	  snprintf (name, sizeof name,
+		    "unique table chains (size %ld)", stats.bdd.table);
+	  print_bdd_histogram (name, stats.bdd.chains);
+	}
     }
+  if (stats.gates.hashed || stats.gates.simplified)
+    msg (1, "%ld structurally hashed gates, %ld simplified gates",
+	 stats.gates.hashed, stats.gates.simplified);
+  if (stats.fraig.candidates)
+    msg (1, "swept %ld candidates: %ld merged, %ld refuted, %ld limited, "
+	 "%ld SAT calls", stats.fraig.candidates, stats.fraig.merged,
+	 stats.fraig.refuted, stats.fraig.limited, stats.fraig.calls);
+  if (stats.fraig.calls)
+    msg (1, "sweeping took %ld decisions, %ld conflicts, %ld propagations",
+	 stats.fraig.decisions, stats.fraig.conflicts,
+	 stats.fraig.propagated);
   if (stats.symbol.lookups)
     msg (1, "looked up %ld symbols, %ld collisions (%.1f per look-up)",
 	 stats.symbol.lookups, stats.symbol.collisions,
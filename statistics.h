@@ -16,6 +16,13 @@ struct Rules
 
 /*------------------------------------------------------------------------*/
 
+// Buckets of BDD unique table histograms (the last one collects all
+// larger probe or chain lengths).
+
+#define BDD_HISTOGRAM 8
+
+/*------------------------------------------------------------------------*/
+
 struct Stats
 {
   long decisions, flipped;
@@ -48,16 +55,39 @@ struct Stats
     {
       long lookups, collisions;
     } node, cache;
+    struct
+    {
+      long hits, misses;
+    } ops[NUM_BDD_OPS];
+    long peak, freed, table;
+    long probes[BDD_HISTOGRAM], chains[BDD_HISTOGRAM];
   } bdd;
   struct
   {
     long lookups, collisions;
   } symbol;
   struct
+  {
+    long hashed, simplified;
+  } gates;
+  struct
+  {
+    long candidates, calls, merged, refuted, limited;
+    long decisions, conflicts, propagated;
+  } fraig;
+  struct
   {
     long counted, discounted;
   } models;
   struct
+  {
+    long tried, counted, limited, unsatisfiable;
+  } hybrid;
+  struct
+  {
+    long propagations, conflicts, eliminations;
+  } gauss;
+  struct
   {
     long max, current;
   } bytes;
@@ -98,3 +98,15 @@ percent (double a, double b)
 {
   return b ? 100 * a / b : 0;
 }
+
+// The 'splitmix64' generator of Steele, Lea and Flood, which is fast and
+// good enough for sampling and random simulation.
+
+uint64_t
+splitmix64 (uint64_t * state)
+{
+  uint64_t z = (*state += 0x9e3779b97f4a7c15ull);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return z ^ (z >> 31);
+}
@@ -13,3 +13,5 @@ int is_space_character (int ch);
 
 double average (double, double);
 double percent (double, double);
+
+uint64_t splitmix64 (uint64_t * state);
@@ -0,0 +1,12 @@
+// generated by 'version.sh'
+#include "headers.h"
+const char * get_version () {
+  return "1.0.0 d02e63e9e4d7b9b2ba1c9a339d628b863a936c70";
+}
+void print_version () {
+  msg (1, "Version %s", get_version ());
+  msg (1, "Released Mon Oct 19 09:20:32 2026 +0000");
+  msg (1, "Compiled Mon Oct 19 09:22:16 UTC 2026");
+  msg (1, "System Linux vm 6.18.44-fc-v139 x86_64");
+  msg (1, "Compiler gcc -Wall -O3 -DNDEBUG -DNLOG");
+}
@@ -0,0 +1,556 @@
+#include "headers.h"
+
+/*------------------------------------------------------------------------*/
+
+// ZDD nodes follow the BDD nodes in 'bdd.c' closely, except that a node
+// with a 'hi' child pointing to the empty family is removed instead of a
+// node with identical children.  Skipped variables are thus false and not
+// don't cares, which for sparse models keeps the diagram small.  Levels
+// are positions in the domain given to 'init_zdds' with the root at level
+// zero.  The two terminals are on the two levels after the last variable.
+
+struct ZDD
+{
+  unsigned level, ref, hash, mark;
+  uint64_t idx;
+  ZDD *next, *hi, *lo;
+};
+
+/*------------------------------------------------------------------------*/
+
+static unsigned zdd_mark;
+static ZDD **zdd_table, *empty_zdd_node, *base_zdd_node;
+static unsigned zdd_size, zdd_count;
+static uint64_t zdd_nodes;
+
+static unsigned *zdd_import_table;
+static int *zdd_export_table;
+static unsigned zdd_import_size, zdd_levels;
+
+/*------------------------------------------------------------------------*/
+
+static ZDD *
+inc (ZDD * z)
+{
+  assert (z);
+  assert (z->ref);
+  z->ref++;
+  return z;
+}
+
+static ZDD *
+alloc_zdd (unsigned level, ZDD * hi, ZDD * lo, unsigned hash)
+{
+  assert (!hi == !lo);
+  ZDD *res;
+  NEW (res);
+  res->level = level;
+  res->ref = 1;
+  res->hash = hash;
+  res->idx = zdd_nodes++;
+  res->hi = hi ? inc (hi) : 0;
+  res->lo = lo ? inc (lo) : 0;
+  zdd_count++;
+  LOG ("allocating ZDD %" PRIu64 " level %u", res->idx, level);
+  return res;
+}
+
+static void
+dealloc_zdd (ZDD * z)
+{
+  assert (z);
+  LOG ("deallocating ZDD %" PRIu64 "", z->idx);
+  assert (zdd_count);
+  zdd_count--;
+  DELETE (z);
+}
+
+static ZDD **
+find_zdd (unsigned level, ZDD * hi, ZDD * lo, unsigned hash)
+{
+  unsigned h = hash & (zdd_size - 1);
+  ZDD **res, *z;
+  for (res = zdd_table + h;
+       (z = *res) && (z->level != level || z->hi != hi || z->lo != lo);
+       res = &z->next)
+    ;
+  return res;
+}
+
+static void
+dec (ZDD * z)
+{
+  assert (z->ref);
+  if (--z->ref)
+    return;
+  ZDD **p = find_zdd (z->level, z->hi, z->lo, z->hash);
+  assert (*p == z);
+  *p = z->next;
+  if (z->hi)
+    dec (z->hi);
+  if (z->lo)
+    dec (z->lo);
+  dealloc_zdd (z);
+}
+
+ZDD *
+copy_zdd (ZDD * z)
+{
+  return inc (z);
+}
+
+void
+delete_zdd (ZDD * z)
+{
+  dec (z);
+}
+
+static unsigned
+hash_zdd_ptr (ZDD * z)
+{
+  return z ? z->hash : 0;
+}
+
+static unsigned
+hash_zdd (unsigned level, ZDD * hi, ZDD * lo)
+{
+  unsigned res = level * primes[0];
+  res = (res + hash_zdd_ptr (hi)) * primes[1];
+  res = (res + hash_zdd_ptr (lo)) * primes[2];
+  return res;
+}
+
+static void
+enlarge_zdd ()
+{
+  unsigned new_zdd_size = zdd_size ? 2 * zdd_size : 1;
+  msg (2, "enlarging ZDD table from %u to %u", zdd_size, new_zdd_size);
+  ZDD **new_zdd_table;
+  ALLOC (new_zdd_table, new_zdd_size);
+  for (unsigned i = 0; i < zdd_size; i++)
+    for (ZDD * z = zdd_table[i], *next; z; z = next)
+      {
+	next = z->next;
+	unsigned h = z->hash & (new_zdd_size - 1);
+	z->next = new_zdd_table[h];
+	new_zdd_table[h] = z;
+      }
+  DEALLOC (zdd_table, zdd_size);
+  zdd_table = new_zdd_table;
+  zdd_size = new_zdd_size;
+}
+
+static ZDD *
+new_zdd_node (unsigned level, ZDD * hi, ZDD * lo)
+{
+  if (hi && hi == empty_zdd_node)
+    return inc (lo);
+  assert (!hi || level < hi->level);
+  assert (!lo || level < lo->level);
+  if (zdd_size == zdd_count)
+    enlarge_zdd ();
+  unsigned hash = hash_zdd (level, hi, lo);
+  ZDD **p = find_zdd (level, hi, lo, hash), *res;
+  if ((res = *p))
+    return inc (res);
+  *p = res = alloc_zdd (level, hi, lo, hash);
+  return res;
+}
+
+/*------------------------------------------------------------------------*/
+
+void
+init_zdds (IntStack * vars)
+{
+  assert (!zdd_count);
+  zdd_levels = COUNT (*vars);
+  zdd_import_size = 1;
+  for (const int *p = vars->start; p != vars->top; p++)
+    if ((unsigned) *p >= zdd_import_size)
+      zdd_import_size = *p + 1;
+  ALLOC (zdd_import_table, zdd_import_size);
+  ALLOC (zdd_export_table, zdd_levels);
+  for (unsigned level = 0; level < zdd_levels; level++)
+    {
+      const int var = PEEK (*vars, level);
+      assert (0 < var);
+      assert (!zdd_import_table[var]);
+      LOG ("ZDD variable %d mapped to level %u", var, level);
+      zdd_import_table[var] = level + 1;
+      zdd_export_table[level] = var;
+    }
+  empty_zdd_node = new_zdd_node (zdd_levels, 0, 0);
+  base_zdd_node = new_zdd_node (zdd_levels + 1, 0, 0);
+  msg (2, "initialized ZDDs over %u variables", zdd_levels);
+}
+
+void
+reset_zdds ()
+{
+  for (unsigned i = 0; i < zdd_size; i++)
+    for (ZDD * z = zdd_table[i], *next; z; z = next)
+      next = z->next, dealloc_zdd (z);
+  assert (!zdd_count);
+  DEALLOC (zdd_table, zdd_size);
+  zdd_table = 0;
+  zdd_size = 0;
+  zdd_nodes = 0;
+  empty_zdd_node = 0;
+  base_zdd_node = 0;
+  DEALLOC (zdd_import_table, zdd_import_size);
+  DEALLOC (zdd_export_table, zdd_levels);
+  zdd_import_size = zdd_levels = 0;
+}
+
+static unsigned
+zdd_import_var (int var)
+{
+  assert (0 < var);
+  assert ((unsigned) var < zdd_import_size);
+  const unsigned res = zdd_import_table[var];
+  assert (res);
+  return res - 1;
+}
+
+static int
+zdd_export_level (unsigned level)
+{
+  assert (level < zdd_levels);
+  return zdd_export_table[level];
+}
+
+int
+is_empty_zdd (ZDD * z)
+{
+  assert (empty_zdd_node);
+  return z == empty_zdd_node;
+}
+
+ZDD *
+empty_zdd ()
+{
+  assert (empty_zdd_node);
+  return inc (empty_zdd_node);
+}
+
+ZDD *
+base_zdd ()
+{
+  assert (base_zdd_node);
+  return inc (base_zdd_node);
+}
+
+ZDD *
+new_zdd (int var, ZDD * hi, ZDD * lo)
+{
+  return new_zdd_node (zdd_import_var (var), hi, lo);
+}
+
+// The family of all models of the cube given as literals.  Domain
+// variables not occurring in the cube are don't cares, which yields a
+// node with identical children for each of them.
+
+ZDD *
+cube_zdd (IntStack * lits)
+{
+  signed char *values;
+  ALLOC (values, zdd_levels);
+  for (const int *p = lits->start; p != lits->top; p++)
+    {
+      const int lit = *p;
+      values[zdd_import_var (abs (lit))] = lit < 0 ? -1 : 1;
+    }
+  ZDD *res = base_zdd ();
+  for (unsigned level = zdd_levels; level-- > 0;)
+    {
+      const signed char value = values[level];
+      if (value < 0)
+	continue;
+      ZDD *tmp = new_zdd_node (level, res, value ? empty_zdd_node : res);
+      dec (res);
+      res = tmp;
+    }
+  DEALLOC (values, zdd_levels);
+  return res;
+}
+
+/*------------------------------------------------------------------------*/
+
+// Union needs a computed table, which as for BDDs is chained, keeps its
+// entries alive and is flushed after each top-level operation.
+
+typedef struct Computed Computed;
+struct Computed
+{
+  ZDD *a, *b, *res;
+  Computed *next;
+};
+
+static Computed **computed_table;
+static unsigned computed_size, computed_count;
+
+static unsigned
+hash_computed (ZDD * a, ZDD * b)
+{
+  return hash_zdd_ptr (a) * primes[3] + hash_zdd_ptr (b) * primes[4];
+}
+
+static void
+enlarge_computed ()
+{
+  unsigned new_computed_size = computed_size ? 2 * computed_size : 1;
+  Computed **new_computed_table;
+  ALLOC (new_computed_table, new_computed_size);
+  for (unsigned i = 0; i < computed_size; i++)
+    for (Computed * l = computed_table[i], *next; l; l = next)
+      {
+	next = l->next;
+	unsigned h = hash_computed (l->a, l->b) & (new_computed_size - 1);
+	l->next = new_computed_table[h];
+	new_computed_table[h] = l;
+      }
+  DEALLOC (computed_table, computed_size);
+  computed_table = new_computed_table;
+  computed_size = new_computed_size;
+}
+
+static Computed **
+find_computed (ZDD * a, ZDD * b)
+{
+  unsigned h = hash_computed (a, b) & (computed_size - 1);
+  Computed **res, *l;
+  for (res = computed_table + h;
+       (l = *res) && (l->a != a || l->b != b); res = &l->next)
+    ;
+  return res;
+}
+
+static ZDD *
+cached_union (ZDD * a, ZDD * b)
+{
+  Computed *l = computed_count ? *find_computed (a, b) : 0;
+  return l ? inc (l->res) : 0;
+}
+
+static void
+cache_union (ZDD * a, ZDD * b, ZDD * res)
+{
+  if (computed_count == computed_size)
+    enlarge_computed ();
+  Computed **p = find_computed (a, b), *l;
+  assert (!*p);
+  NEW (l);
+  l->a = inc (a);
+  l->b = inc (b);
+  l->res = inc (res);
+  *p = l;
+  computed_count++;
+}
+
+static void
+reset_computed ()
+{
+  for (unsigned i = 0; i < computed_size; i++)
+    for (Computed * l = computed_table[i], *next; l; l = next)
+      {
+	next = l->next;
+	dec (l->a);
+	dec (l->b);
+	dec (l->res);
+	DELETE (l);
+      }
+  DEALLOC (computed_table, computed_size);
+  computed_table = 0;
+  computed_size = computed_count = 0;
+}
+
+static ZDD *
+union_zdd_recursive (ZDD * a, ZDD * b)
+{
+  if (a == empty_zdd_node || a == b)
+    return inc (b);
+  if (b == empty_zdd_node)
+    return inc (a);
+  if (a->idx > b->idx)
+    SWAP (ZDD *, a, b);
+  ZDD *res = cached_union (a, b);
+  if (res)
+    return res;
+  const unsigned level = MIN (a->level, b->level);
+  ZDD *a_hi = a->level == level ? a->hi : empty_zdd_node;
+  ZDD *a_lo = a->level == level ? a->lo : a;
+  ZDD *b_hi = b->level == level ? b->hi : empty_zdd_node;
+  ZDD *b_lo = b->level == level ? b->lo : b;
+  ZDD *hi = union_zdd_recursive (a_hi, b_hi);
+  ZDD *lo = union_zdd_recursive (a_lo, b_lo);
+  res = new_zdd_node (level, hi, lo);
+  cache_union (a, b, res);
+  dec (lo);
+  dec (hi);
+  return res;
+}
+
+ZDD *
+union_zdd (ZDD * a, ZDD * b)
+{
+  LOG ("union_zdd (%" PRIu64 ", %" PRIu64 ")", a->idx, b->idx);
+  ZDD *res = union_zdd_recursive (a, b);
+  reset_computed ();
+  return res;
+}
+
+/*------------------------------------------------------------------------*/
+
+typedef STACK (ZDD *) ZDDs;
+
+static void
+inc_zdd_mark ()
+{
+  if (!++zdd_mark)
+    die ("out of ZDD marks");
+}
+
+// Children before parents as in 'collect_bdd_nodes'.
+
+static void
+collect_zdd_nodes (ZDD * root, ZDDs * nodes)
+{
+  ZDDs work;
+  INIT (work);
+  inc_zdd_mark ();
+  PUSH (work, root);
+  while (!EMPTY (work))
+    {
+      ZDD *z = POP (work);
+      if ((uintptr_t) z & 1)
+	{
+	  PUSH (*nodes, (ZDD *) ((uintptr_t) z & ~(uintptr_t) 1));
+	  continue;
+	}
+      if (z->idx <= 1 || z->mark == zdd_mark)
+	continue;
+      z->mark = zdd_mark;
+      PUSH (work, (ZDD *) ((uintptr_t) z | 1));
+      PUSH (work, z->lo);
+      PUSH (work, z->hi);
+    }
+  RELEASE (work);
+}
+
+unsigned
+size_zdd (ZDD * z)
+{
+  ZDDs nodes;
+  INIT (nodes);
+  collect_zdd_nodes (z, &nodes);
+  const unsigned res = COUNT (nodes);
+  RELEASE (nodes);
+  return res;
+}
+
+// The number of sets is the sum of the counts of the two children, since
+// skipped levels do not contribute don't cares as for BDDs.
+
+void
+count_zdd (Number res, ZDD * z)
+{
+  assert (is_zero_number (res));
+  if (z == base_zdd_node)
+    inc_number (res);
+  if (z->idx <= 1)
+    return;
+  ZDDs nodes;
+  INIT (nodes);
+  collect_zdd_nodes (z, &nodes);
+  const size_t n = COUNT (nodes);
+  Number *counts;
+  ALLOC (counts, n);
+  for (size_t i = 0; i < n; i++)
+    {
+      ZDD *a = PEEK (nodes, i);
+      init_number (counts[i]);
+      ZDD *children[2] = { a->hi, a->lo };
+      for (int j = 0; j < 2; j++)
+	{
+	  ZDD *child = children[j];
+	  if (child == base_zdd_node)
+	    inc_number (counts[i]);
+	  else if (child != empty_zdd_node)
+	    add_number (counts[i], counts[child->mark]);
+	}
+      a->mark = i;
+    }
+  add_number (res, counts[n - 1]);
+  for (size_t i = 0; i < n; i++)
+    {
+      clear_number (counts[i]);
+      PEEK (nodes, i)->mark = 0;
+    }
+  DEALLOC (counts, n);
+  RELEASE (nodes);
+}
+
+// Compact export with one line 'idx var hi lo' per node, children first,
+// where '0' is the empty family and '1' the family with only the empty
+// set.  The last line gives the root.
+
+void
+print_zdd_to_file (ZDD * z, Name name, FILE * file)
+{
+  ZDDs nodes;
+  INIT (nodes);
+  collect_zdd_nodes (z, &nodes);
+  for (ZDD ** p = nodes.start; p != nodes.top; p++)
+    {
+      ZDD *a = *p;
+      fprintf (file, "%" PRIu64 " %s %" PRIu64 " %" PRIu64 "\n",
+	       a->idx, name.get (name.state, zdd_export_level (a->level)),
+	       a->hi->idx, a->lo->idx);
+    }
+  fprintf (file, "root %" PRIu64 "\n", z->idx);
+  RELEASE (nodes);
+}
+
+// Iterates over all sets of the family in lexicographic order of the
+// paths, taking 'hi' edges first, and prints the variables of each set.
+// The current path is kept on an explicit stack of nodes, where the low
+// bit tags nodes for which the 'hi' child has already been explored.
+
+void
+print_all_zdd_sets (ZDD * z, Name name)
+{
+  ZDDs path;
+  INIT (path);
+  ZDD *n = z;
+  for (;;)
+    {
+      while (n->idx > 1)
+	{
+	  PUSH (path, n);
+	  n = n->hi;
+	}
+      if (n == base_zdd_node)
+	{
+	  int first = 1;
+	  for (ZDD ** p = path.start; p != path.top; p++)
+	    {
+	      if ((uintptr_t) * p & 1)
+		continue;
+	      if (!first)
+		fputc (' ', stdout);
+	      fputs (name.get (name.state, zdd_export_level ((*p)->level)),
+		     stdout);
+	      first = 0;
+	    }
+	  fputc ('\n', stdout);
+	}
+      while (!EMPTY (path) && ((uintptr_t) path.top[-1] & 1))
+	(void) POP (path);
+      if (EMPTY (path))
+	break;
+      ZDD *parent = POP (path);
+      PUSH (path, (ZDD *) ((uintptr_t) parent | 1));
+      n = parent->lo;
+    }
+  RELEASE (path);
+}
@@ -0,0 +1,33 @@
+#ifndef ZDD_H_INCLUDED
+#define ZDD_H_INCLUDED
+
+// Zero-suppressed decision diagrams representing families of sets of
+// variables.  A set stands for the model which assigns exactly the
+// variables in the set to true and all other domain variables to false.
+
+typedef struct ZDD ZDD;
+
+void init_zdds (IntStack * vars);	// domain from root to leaves
+void reset_zdds ();
+
+ZDD *copy_zdd (ZDD *);
+void delete_zdd (ZDD *);
+
+int is_empty_zdd (ZDD *);
+
+ZDD *empty_zdd ();		// no set at all
+ZDD *base_zdd ();		// only the empty set
+ZDD *new_zdd (int var, ZDD * hi, ZDD * lo);
+ZDD *cube_zdd (IntStack * lits);
+ZDD *union_zdd (ZDD *, ZDD *);
+
+unsigned size_zdd (ZDD *);
+
+#include "name.h"
+#include "num.h"
+
+void count_zdd (Number res, ZDD *);
+void print_zdd_to_file (ZDD *, Name, FILE *);
+void print_all_zdd_sets (ZDD *, Name);
+
+#endif